@@ -9,6 +9,10 @@ The ESP32 now outputs JSON-formatted log messages and command responses:
 - Log messages: {"type": "info|warn|error|midi", "message": "..."}
 - Command responses: {"type": "config|response|error", ...}
 
+An optional binary transport (COBS framing, CRC-16, sequence numbers and
+request IDs) can be negotiated with {"type": "binary_hello"}; see
+BinaryClient below and include/binary_protocol.h for the frame layout.
+
 Configuration includes:
 - Switch names, MIDI channels, CC numbers, values, enabled state
 - Custom colors for each switch (hex format: #RRGGBB)
@@ -23,9 +27,38 @@ Example:
 
 import serial
 import json
+import statistics
+import struct
 import sys
 import time
 
+# Binary protocol constants (mirror include/binary_protocol.h)
+BINARY_PROTOCOL_VERSION = 3
+ACTIVE_BANK = 0xFF
+FLAG_RESPONSE = 0x01
+FLAG_ERROR = 0x02
+FLAG_EVENT = 0x04
+OP_HELLO = 0x01
+OP_PING = 0x02
+OP_GET_CONFIG = 0x03
+OP_SET_CONFIG = 0x04
+OP_TEST_SWITCH = 0x05
+OP_CALIBRATE_LADDER = 0x06
+OP_BYE = 0x07
+OP_GET_STATS = 0x08
+OP_PATCH_SWITCH = 0x09
+OP_COMMIT = 0x0A
+OP_SELECT_BANK = 0x0B
+OP_LOG = 0x10
+PATCH_CHANNEL = 0x01
+PATCH_CC = 0x02
+PATCH_VALUE = 0x04
+PATCH_ENABLED = 0x08
+PATCH_COLOR = 0x10
+PATCH_NAME = 0x20
+PATCH_ACTIONS = 0x40
+MIDI_ACTION_TYPES = ["pc", "cc", "note_on", "note_off"]
+
 def send_command(ser, command):
     """Send a JSON command to the ESP32 and return the response."""
     json_str = json.dumps(command) + '\n'
@@ -179,6 +212,522 @@ def test_switch(ser, switch_id):
             except json.JSONDecodeError:
                 print(f"[RAW] {line}")
 
+def crc16_ccitt(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as computed by the firmware."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+def cobs_encode(data):
+    """COBS-encode data (no trailing delimiter)."""
+    out = bytearray([0])
+    code_pos = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xFF:
+                out[code_pos] = code
+                code_pos = len(out)
+                out.append(0)
+                code = 1
+    out[code_pos] = code
+    return bytes(out)
+
+def cobs_decode(data):
+    """Decode one COBS frame (without delimiter). Raises ValueError if malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            raise ValueError("malformed COBS frame")
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+# Action dicts use the JSON field names: pc -> program, cc -> cc/value,
+# note_on/note_off -> note/velocity
+def _action_keys(action_type):
+    data1 = {"pc": "program", "cc": "cc"}.get(action_type, "note")
+    data2 = "value" if action_type == "cc" else "velocity"
+    return data1, data2
+
+def encode_actions(actions):
+    out = bytearray([len(actions)])
+    for action in actions:
+        data1, data2 = _action_keys(action["type"])
+        out += bytes([MIDI_ACTION_TYPES.index(action["type"]), action.get("channel", 1),
+                      action.get(data1, 0), action.get(data2, 127)])
+    return bytes(out)
+
+def decode_actions(data):
+    actions = []
+    for i in range(data[0]):
+        action_type, channel, value1, value2 = data[1 + i * 4:5 + i * 4]
+        name = MIDI_ACTION_TYPES[action_type]
+        data1, data2 = _action_keys(name)
+        action = {"type": name, "channel": channel, data1: value1}
+        if name != "pc":
+            action[data2] = value2
+        actions.append(action)
+    return actions, 1 + data[0] * 4
+
+class BinaryClient:
+    """Client for the COBS-framed binary protocol."""
+
+    def __init__(self, ser):
+        self.ser = ser
+        self.seq = 0
+        self.request_id = 0
+        self.bytes_sent = 0
+        self.bytes_received = 0
+
+    def open(self):
+        """Negotiate binary mode with the JSON handshake."""
+        response = send_command(self.ser, {"type": "binary_hello", "version": BINARY_PROTOCOL_VERSION})
+        if response.get("type") != "response":
+            raise RuntimeError(f"Binary handshake failed: {response}")
+        flags, payload = self.request(OP_HELLO)
+        version, switch_count = payload[0], payload[1]
+        self.bank_count = payload[2]
+        return version, switch_count
+
+    def close(self):
+        self.request(OP_BYE)
+
+    def _send_frame(self, op, payload=b""):
+        self.request_id = (self.request_id % 0xFFFF) + 1
+        header = struct.pack("<BBBBH", BINARY_PROTOCOL_VERSION, op, 0, self.seq, self.request_id)
+        self.seq = (self.seq + 1) & 0xFF
+        body = header + payload
+        frame = cobs_encode(body + struct.pack("<H", crc16_ccitt(body))) + b"\x00"
+        self.ser.write(frame)
+        self.bytes_sent += len(frame)
+        return self.request_id
+
+    def _read_frame(self):
+        raw = self.ser.read_until(b"\x00")
+        if not raw.endswith(b"\x00"):
+            raise TimeoutError("No binary frame received")
+        self.bytes_received += len(raw)
+        frame = cobs_decode(raw[:-1])
+        body, crc = frame[:-2], struct.unpack("<H", frame[-2:])[0]
+        if crc16_ccitt(body) != crc:
+            raise ValueError("CRC mismatch")
+        version, op, flags, seq, request_id = struct.unpack("<BBBBH", body[:6])
+        return op, flags, request_id, body[6:]
+
+    def request(self, op, payload=b""):
+        """Send a request and wait for the response with the matching ID.
+        Log frames received meanwhile are printed."""
+        request_id = self._send_frame(op, payload)
+        while True:
+            r_op, flags, r_id, r_payload = self._read_frame()
+            if r_op == OP_LOG:
+                log_type, _, message = r_payload.partition(b"\x00")
+                print(f"[ESP32 LOG] {log_type.decode()}: {message.decode(errors='replace')}")
+                continue
+            if r_id != request_id:
+                continue
+            if flags & FLAG_ERROR:
+                raise RuntimeError(r_payload.decode(errors="replace"))
+            return flags, r_payload
+
+    def get_config(self, bank=ACTIVE_BANK):
+        _, payload = self.request(OP_GET_CONFIG, bytes([bank]))
+        switches = []
+        pos = 2
+        for _ in range(payload[1]):
+            sw_id, channel, cc, value, enabled, color, name_len = struct.unpack("<BBBBBHB", payload[pos:pos + 8])
+            name = payload[pos + 8:pos + 8 + name_len].decode(errors="replace")
+            pos += 8 + name_len
+            actions, length = decode_actions(payload[pos:])
+            pos += length
+            r, g, b = (color >> 8) & 0xF8, (color >> 3) & 0xFC, (color << 3) & 0xF8
+            switches.append({"id": sw_id, "name": name, "channel": channel, "cc": cc, "value": value,
+                             "enabled": bool(enabled), "color": f"#{r:02X}{g:02X}{b:02X}",
+                             "actions": actions})
+        return switches
+
+    def set_config(self, switches, bank=ACTIVE_BANK):
+        payload = bytearray([bank, len(switches)])
+        for sw in switches:
+            hex_color = sw.get("color", "#FFFFFF").lstrip("#")
+            r, g, b = int(hex_color[0:2], 16), int(hex_color[2:4], 16), int(hex_color[4:6], 16)
+            color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+            name = sw["name"].encode()[:31]
+            payload += struct.pack("<BBBBBHB", sw["id"], sw["channel"], sw["cc"], sw["value"],
+                                   1 if sw["enabled"] else 0, color, len(name)) + name
+            payload += encode_actions(sw.get("actions", []))
+        self.request(OP_SET_CONFIG, bytes(payload))
+
+    def test_switch(self, switch_id):
+        self.request(OP_TEST_SWITCH, bytes([switch_id]))
+
+    def select_bank(self, bank):
+        _, payload = self.request(OP_SELECT_BANK, bytes([bank]))
+        return payload[0]
+
+    def patch_switch(self, switch_id, channel=None, cc=None, value=None, enabled=None, color=None, name=None,
+                     actions=None):
+        """Change selected fields of one switch; flash is written after a quiet period."""
+        mask = 0
+        fields = bytearray()
+        if channel is not None:
+            mask |= PATCH_CHANNEL
+            fields.append(channel)
+        if cc is not None:
+            mask |= PATCH_CC
+            fields.append(cc)
+        if value is not None:
+            mask |= PATCH_VALUE
+            fields.append(value)
+        if enabled is not None:
+            mask |= PATCH_ENABLED
+            fields.append(1 if enabled else 0)
+        if color is not None:
+            hex_color = color.lstrip("#")
+            r, g, b = int(hex_color[0:2], 16), int(hex_color[2:4], 16), int(hex_color[4:6], 16)
+            mask |= PATCH_COLOR
+            fields += struct.pack("<H", ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+        if name is not None:
+            encoded = name.encode()[:31]
+            mask |= PATCH_NAME
+            fields += bytes([len(encoded)]) + encoded
+        if actions is not None:
+            mask |= PATCH_ACTIONS
+            fields += encode_actions(actions)
+        self.request(OP_PATCH_SWITCH, bytes([switch_id, mask]) + bytes(fields))
+
+    def commit(self):
+        """Flush a pending configuration write. Returns (written, flash_writes, writes_avoided)."""
+        _, payload = self.request(OP_COMMIT)
+        return struct.unpack("<BII", payload[:9])
+
+    def ping(self):
+        self.request(OP_PING)
+
+def set_preset_recall(ser, switch_id=0):
+    """Give one switch a multi-message preset recall and test it."""
+    actions = [
+        {"type": "pc", "channel": 1, "program": 12},
+        {"type": "cc", "channel": 1, "cc": 7, "value": 100},
+        {"type": "cc", "channel": 1, "cc": 11, "value": 127},
+        {"type": "pc", "channel": 2, "program": 3},
+        {"type": "note_on", "channel": 10, "note": 36, "velocity": 110},
+    ]
+    print(f"Setting a {len(actions)}-message preset recall on switch {switch_id}...")
+    print(json.dumps(send_command(ser, {"type": "patch_switch", "switch_id": switch_id, "actions": actions}), indent=2))
+    test_switch(ser, switch_id)
+    print(json.dumps(send_command(ser, {"type": "midi_stats"}), indent=2))
+
+def set_gestures(ser, switch_id=0):
+    """Bind long press, release and double tap on one switch, then read it back."""
+    gestures = {
+        "long_press_ms": 600,
+        "double_tap_ms": 300,
+        "long_press": {"type": "cc", "channel": 1, "cc": 80, "value": 127},
+        "release": {"type": "cc", "channel": 1, "cc": 80, "value": 0},
+        "double_tap": {"type": "bank_next"},
+    }
+    print(f"Binding gestures on switch {switch_id}...")
+    print(json.dumps(send_command(ser, {"type": "patch_switch", "switch_id": switch_id, "gestures": gestures}), indent=2))
+    config = send_command(ser, {"type": "get_config"})
+    for sw in (config or {}).get("switches", []):
+        if sw.get("id") == switch_id:
+            print(json.dumps(sw.get("gestures"), indent=2))
+    print("Tap the switch once, twice, and hold it to try each gesture.")
+
+def pedal_monitor(ser, pedal_id=0, seconds=10):
+    """Enable one expression pedal and show what it sends while it is moved."""
+    pedal = {"id": pedal_id, "enabled": True, "channel": 1, "cc": 11, "deadband": 16, "max_rate_hz": 50}
+    print(json.dumps(send_command(ser, {"type": "set_pedals", "pedals": [pedal]}), indent=2))
+    send_command(ser, {"type": "midi_stats", "reset": True})
+    print(f"Move pedal {pedal_id + 1} for {seconds} seconds...")
+    end = time.time() + seconds
+    while time.time() < end:
+        stats = send_command(ser, {"type": "midi_stats"}) or {}
+        p = (stats.get("pedals") or [{}] * (pedal_id + 1))[pedal_id]
+        print(f"level {p.get('level', 0):4}  value {p.get('value', 0):5}  "
+              f"sent {p.get('messages', 0):5}  rate limited {p.get('rate_limited', 0):5}")
+        time.sleep(0.5)
+    output = (send_command(ser, {"type": "midi_stats"}) or {}).get("output", {})
+    print(f"coalesced {output.get('continuous_coalesced')}, "
+          f"worst latency {output.get('max_latency_us', {}).get('continuous')} us")
+
+def read_event(ser, timeout=1.0):
+    """Next event line from the subscription, or None. Other lines are printed."""
+    end = time.time() + timeout
+    while time.time() < end:
+        line = ser.readline().decode(errors="replace").strip()
+        if not line:
+            continue
+        try:
+            parsed = json.loads(line)
+        except json.JSONDecodeError:
+            print(f"[ESP32 RAW] {line}")
+            continue
+        if "ev" in parsed:
+            return parsed
+        if parsed.get("type") != "response":
+            print(f"[ESP32 LOG] {line}")
+    return None
+
+def event_stream_test(ser, presses=20, listen_seconds=10):
+    """Subscribe to the event stream and measure how fast events arrive.
+
+    test_switch presses are timed from the command write to the arrival of
+    their MIDI event; 'age' is the device's own event-to-UART time. Then
+    footswitch events are printed live for a while. Gaps in 'seq' are
+    events the device dropped.
+    """
+    response = send_command(ser, {"type": "subscribe"})
+    print(json.dumps(response, indent=2))
+    expected_seq = response.get("seq", 0)
+    gaps = 0
+
+    def check_seq(event):
+        nonlocal expected_seq, gaps
+        if event.get("ev") == "dropped":
+            print(f"  device dropped {event['count']} events at seq {event['seq']}")
+            expected_seq = event["seq"] + event["count"]
+            return
+        if event["seq"] != expected_seq:
+            gaps += event["seq"] - expected_seq
+        expected_seq = event["seq"] + 1
+
+    round_trips, ages = [], []
+    for _ in range(presses):
+        start = time.perf_counter()
+        ser.write((json.dumps({"type": "test_switch", "switch_id": 0}) + "\n").encode())
+        while True:
+            event = read_event(ser)
+            if event is None:
+                print("  no MIDI event for test_switch")
+                break
+            check_seq(event)
+            if event.get("ev") == "midi" and event.get("source") == "host":
+                round_trips.append((time.perf_counter() - start) * 1000)
+                ages.append(event["age"])
+                break
+        time.sleep(0.05)
+
+    if round_trips:
+        ordered = sorted(round_trips)
+        print(f"command -> event: min {ordered[0]:.1f} ms, median {statistics.median(ordered):.1f} ms, "
+              f"p90 {ordered[int(len(ordered) * 0.9) - 1]:.1f} ms, max {ordered[-1]:.1f} ms")
+        print(f"device event age: median {statistics.median(ages):.0f} us, max {max(ages)} us")
+
+    print(f"Press footswitches for {listen_seconds} seconds...")
+    end = time.time() + listen_seconds
+    while time.time() < end:
+        event = read_event(ser, timeout=0.2)
+        if event is None:
+            continue
+        check_seq(event)
+        print(f"  {json.dumps(event)}")
+
+    print(json.dumps(send_command(ser, {"type": "unsubscribe"}), indent=2))
+    print(f"sequence gaps without a dropped marker: {gaps}")
+
+# Simulated MIDI IN stream with known content: per-type counts and the number
+# of bytes the parser must drop
+MIDI_IN_STREAM = (
+    [0x90, 60, 100, 62, 100, 60, 0]         # note on, note on (running status), note off (velocity 0)
+    + [0xB0, 7, 100, 0xC0, 5]               # control change, program change
+    + [0xF8, 0xF8, 0xF8]                    # clock
+    + [0x90, 64, 0xF8, 90]                  # note on with a clock byte inside it
+    + [0xF6, 0x42]                          # tune request, then a stray data byte (dropped)
+    + [0xF0, 0x7D, 1, 2, 3, 0xF7]           # short SysEx (forwarded)
+    + [0xF0] + [0x11] * 200 + [0xF7]        # SysEx too long to forward (202 bytes dropped)
+    + [0xF4]                                # undefined status (dropped)
+    + [0xE0, 0, 64]                         # pitch bend
+)
+MIDI_IN_EXPECTED = {"note_on": 3, "note_off": 1, "control_change": 1, "program_change": 1,
+                    "clock": 4, "system_common": 1, "sysex": 1, "pitch_bend": 1}
+MIDI_IN_EXPECTED_DROPPED = 204
+MIDI_THRU_LATENCY_BOUND_US = 10000
+
+def record_trace(ser, path="capture.trace", seconds=5):
+    """Record an input trace for the host replayer (see trace_tool.py)."""
+    import trace_tool
+    port = ser.port
+    ser.close()
+    try:
+        trace_tool.record(port, path, seconds)
+    except SystemExit as e:
+        print(f"Recording failed: {e}")
+    finally:
+        ser.open()
+
+def midi_input_test(ser):
+    """Drive the MIDI input parser and THRU merge with simulated byte streams."""
+    send_command(ser, {"type": "midi_stats", "reset": True})
+    send_command(ser, {"type": "midi_thru", "enabled": True})
+    time.sleep(0.05)
+
+    # 1. Parser: counters and dropped bytes for a known stream
+    send_command(ser, {"type": "midi_inject", "bytes": MIDI_IN_STREAM})
+    time.sleep(len(MIDI_IN_STREAM) * 0.00032 + 0.2)
+    stats = send_command(ser, {"type": "midi_stats", "reset": True})
+    counts = stats["input"]["messages"]
+    failures = [f"{name}: {counts.get(name)} != {expected}"
+                for name, expected in MIDI_IN_EXPECTED.items() if counts.get(name) != expected]
+    if stats["input"]["bytes_received"] != len(MIDI_IN_STREAM):
+        failures.append(f"bytes_received: {stats['input']['bytes_received']} != {len(MIDI_IN_STREAM)}")
+    if stats["input"]["dropped_bytes"] != MIDI_IN_EXPECTED_DROPPED:
+        failures.append(f"dropped_bytes: {stats['input']['dropped_bytes']} != {MIDI_IN_EXPECTED_DROPPED}")
+
+    # 2. Merge: a dense note stream while presses are queued locally
+    time.sleep(0.05)
+    notes = []
+    for i in range(60):
+        notes += [0x90 | (i % 2), 40 + i % 40, 100]
+    send_command(ser, {"type": "midi_inject", "bytes": notes})
+    for switch_id in range(3):
+        send_command(ser, {"type": "test_switch", "switch_id": switch_id})
+    time.sleep(len(notes) * 0.00032 + 0.3)
+    merge = send_command(ser, {"type": "midi_stats"})
+    thru_latency = merge["output"]["max_latency_us"]["thru"]
+    if merge["input"]["dropped_bytes"] != 0:
+        failures.append(f"merge dropped {merge['input']['dropped_bytes']} bytes")
+    if merge["input"]["thru_messages"] != 60:
+        failures.append(f"merge forwarded {merge['input']['thru_messages']} of 60 messages")
+    if thru_latency > MIDI_THRU_LATENCY_BOUND_US:
+        failures.append(f"THRU latency {thru_latency} us > {MIDI_THRU_LATENCY_BOUND_US} us")
+
+    print(json.dumps(merge, indent=2))
+    if failures:
+        print("MIDI input test FAILED:")
+        for failure in failures:
+            print(f"  {failure}")
+    else:
+        print(f"MIDI input test passed (max THRU latency {thru_latency} us, "
+              f"{merge['output']['status_bytes_saved']} status bytes saved)")
+    return not failures
+
+def show_stats(ser, reset=False):
+    """Print the latency histograms as percentile rows, then the counters."""
+    stats = send_command(ser, {"type": "get_stats", "reset": reset})
+    print(f"{'histogram':<18} {'count':>7} {'min':>7} {'p50':>7} {'p90':>7} {'p99':>7} {'max':>7}  (us)")
+    for name, hist in stats.get("histograms", {}).items():
+        if hist.get("count", 0) == 0:
+            print(f"{name:<18} {0:>7}")
+            continue
+        print(f"{name:<18} {hist['count']:>7} {hist['min_us']:>7} {hist['p50_us']:>7} "
+              f"{hist['p90_us']:>7} {hist['p99_us']:>7} {hist['max_us']:>7}")
+    print(json.dumps(stats.get("counters", {}), indent=2))
+
+def show_boot_profile(ser):
+    """Print how long each start-up stage took, and the input-ready target."""
+    profile = send_command(ser, {"type": "boot_profile"})
+    previous = 0
+    for name, at in profile.get("stages_us", {}).items():
+        print(f"{name:<14} {at / 1000:>9.2f} ms  (+{(at - previous) / 1000:.2f})")
+        previous = at
+    if "input_ready_us" in profile:
+        verdict = "met" if profile["target_met"] else "MISSED"
+        print(f"input ready at {profile['input_ready_us'] / 1000:.2f} ms, "
+              f"target {profile['target_us'] / 1000:.0f} ms: {verdict}")
+
+def select_bank(ser, bank):
+    """Make a bank active (0-based index)."""
+    print(f"Selecting bank {bank}...")
+    response = send_command(ser, {"type": "select_bank", "bank": bank})
+    print(json.dumps(response, indent=2))
+
+def patch_color_sweep(ser, switch_id=0):
+    """Simulate dragging a colour picker: many small patches, one flash write."""
+    print(f"Sweeping colour of switch {switch_id} with patch_switch...")
+    for hue in range(0, 256, 16):
+        color = f"#{hue:02X}{255 - hue:02X}80"
+        response = send_command(ser, {"type": "patch_switch", "switch_id": switch_id, "color": color})
+        print(f"  {color}: {response.get('message')}")
+    response = send_command(ser, {"type": "commit"})
+    print(json.dumps(response, indent=2))
+
+def binary_get_config(ser):
+    """Fetch the configuration over the binary protocol."""
+    client = BinaryClient(ser)
+    version, switch_count = client.open()
+    print(f"Binary protocol v{version}, {switch_count} switches")
+    print(json.dumps(client.get_config(), indent=2))
+    client.close()
+
+def binary_keepalive_test(ser, idle_seconds=12):
+    """Leave a binary session idle, check it is still open, then end it with a JSON line."""
+    client = BinaryClient(ser)
+    client.open()
+    print(f"Binary session open, idling {idle_seconds} s...")
+    time.sleep(idle_seconds)
+    start = time.perf_counter()
+    client.ping()
+    print(f"PING after idle answered in {(time.perf_counter() - start) * 1000:.1f} ms")
+
+    # No OP_BYE: a JSON command line alone must end the session
+    response = send_command(ser, {"type": "get_config"})
+    if response.get("type") == "config":
+        print(f"JSON line ended the session, {len(response.get('switches', []))} switches")
+    else:
+        print(f"JSON line not answered: {response}")
+
+def summarize(label, samples, total_bytes, count):
+    samples_ms = [s * 1000 for s in samples]
+    samples_ms.sort()
+    p95 = samples_ms[int(len(samples_ms) * 0.95) - 1] if samples_ms else 0
+    print(f"{label:<8} mean {statistics.mean(samples_ms):7.2f} ms   p95 {p95:7.2f} ms   "
+          f"{total_bytes / count:7.1f} bytes/op   {count / sum(samples):6.1f} ops/s")
+
+def compare_protocols(ser, iterations=50):
+    """Compare get_config round-trip latency and wire bytes, JSON vs binary."""
+    print(f"Running {iterations} get_config round trips per protocol...")
+
+    json_samples = []
+    json_bytes = 0
+    request = (json.dumps({"type": "get_config"}) + "\n").encode()
+    for _ in range(iterations):
+        start = time.perf_counter()
+        ser.write(request)
+        while True:
+            line = ser.readline()
+            try:
+                if json.loads(line).get("type") == "config":
+                    break
+            except json.JSONDecodeError:
+                pass
+        json_samples.append(time.perf_counter() - start)
+        json_bytes += len(request) + len(line)
+
+    client = BinaryClient(ser)
+    client.open()
+    # Count only the get_config traffic, not the handshake
+    handshake_bytes = client.bytes_sent + client.bytes_received
+    binary_samples = []
+    for _ in range(iterations):
+        start = time.perf_counter()
+        client.get_config()
+        binary_samples.append(time.perf_counter() - start)
+    binary_bytes = client.bytes_sent + client.bytes_received - handshake_bytes
+    client.close()
+
+    print("=" * 70)
+    summarize("JSON", json_samples, json_bytes, iterations)
+    summarize("Binary", binary_samples, binary_bytes, iterations)
+    print("=" * 70)
+
 def main():
     if len(sys.argv) < 2:
         print("Usage: python test_uart.py <port>")
@@ -223,8 +772,21 @@ def main():
             print("7. Test switch 1")
             print("8. Test all switches")
             print("9. Exit")
+            print("10. Get configuration (binary protocol)")
+            print("11. Compare JSON vs binary throughput")
+            print("12. Patch switch 0 colour (sweep) and commit")
+            print("13. Select bank")
+            print("14. Set multi-message preset recall on switch 0")
+            print("15. MIDI input / THRU merge test (simulated stream)")
+            print("16. Show latency statistics (and reset)")
+            print("17. Bind gestures on switch 0")
+            print("18. Enable expression pedal 1 and monitor it")
+            print("19. Event stream: subscribe and measure delivery latency")
+            print("20. Record an input trace for host replay")
+            print("21. Show boot profile")
+            print("22. Binary session keepalive and JSON fallback")
             
-            choice = input("\nEnter choice (1-9): ").strip()
+            choice = input("\nEnter choice (1-22): ").strip()
             
             if choice == '1':
                 get_config(ser)
@@ -246,6 +808,35 @@ def main():
                     time.sleep(0.5)
             elif choice == '9':
                 break
+            elif choice == '10':
+                binary_get_config(ser)
+            elif choice == '11':
+                compare_protocols(ser)
+            elif choice == '12':
+                patch_color_sweep(ser)
+            elif choice == '13':
+                bank = input("Bank index: ").strip()
+                if bank.isdigit():
+                    select_bank(ser, int(bank))
+            elif choice == '14':
+                set_preset_recall(ser)
+            elif choice == '15':
+                midi_input_test(ser)
+            elif choice == '16':
+                show_stats(ser, reset=True)
+            elif choice == '17':
+                set_gestures(ser)
+            elif choice == '18':
+                pedal_monitor(ser)
+            elif choice == '19':
+                event_stream_test(ser)
+            elif choice == '20':
+                path = input("Trace file [capture.trace]: ").strip() or "capture.trace"
+                record_trace(ser, path)
+            elif choice == '21':
+                show_boot_profile(ser)
+            elif choice == '22':
+                binary_keepalive_test(ser)
             else:
                 print("Invalid choice")
                 
@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""
+Input traces for the host replayer (test/test_trace).
+
+    python trace_tool.py record <port> <out.trace> [seconds]
+        Record a session on the device: the configuration is read first,
+        then {"type": "trace", "action": "start"}; play the footswitches for
+        the given time (default 5 s, at most ~2 s of ladder samples are
+        kept), and the dump is converted to the text trace format.
+
+    python trace_tool.py synth <scenario> <out.trace>
+        Write a synthetic trace. Scenarios: single_press, fast_stomps,
+        short_stomp.
+
+The replay of a new trace becomes its golden output with
+    TRACE_UPDATE=1 pio test -e native -f test_trace
+and TRACE_FILE=<path> prints the replay of any trace without comparing it.
+See the header of test/test_trace/test_main.cpp for the file format.
+"""
+
+import json
+import struct
+import sys
+import time
+
+TRACE_VERSION = 1
+GAP_VALUE = 0xFFFF
+SAMPLE_US = 500           # 2 kHz
+
+# Synthetic ladder: pull-up idle level and one level per switch
+SYNTH_IDLE = 3900
+SYNTH_LEVELS = [300, 900, 1500, 2100, 2700, 3300]
+
+
+def header_line(info):
+    """The trace header from a dump's header (or synthetic) fields."""
+    cal = info.get("calibration")
+    if cal:
+        idle = cal.get("idle")
+        calibration = f"{'-' if idle is None else idle}:" + ",".join(str(v) for v in cal["levels"])
+    else:
+        calibration = "none"
+    fields = [f"version={TRACE_VERSION}", f"rate_hz={info.get('rate_hz', 2000)}",
+              f"switches={info.get('switches', 6)}", f"debounce_ms={info.get('debounce_ms', 50)}",
+              f"bank={info.get('bank', 0)}"]
+    if "config_crc" in info:
+        fields.append(f"config_crc=0x{info['config_crc']:04x}")
+    fields.append(f"calibration={calibration}")
+    return "trace " + " ".join(fields)
+
+
+def ladder_lines(entries):
+    """L lines from (dt_us, value) pairs, runs of equal pairs collapsed."""
+    lines = []
+    dt_carry = 0
+    previous, count = None, 0
+    for dt, value in entries:
+        if value == GAP_VALUE:
+            dt_carry += dt
+            continue
+        pair = (dt + dt_carry, value)
+        dt_carry = 0
+        if pair == previous:
+            count += 1
+            continue
+        if previous is not None:
+            lines.append(f"L {previous[0]} {previous[1]}" + (f" x{count}" if count > 1 else ""))
+        previous, count = pair, 1
+    if previous is not None:
+        lines.append(f"L {previous[0]} {previous[1]}" + (f" x{count}" if count > 1 else ""))
+    return lines
+
+
+def write_trace(path, header, setup_commands, entries, commands, comment=None):
+    with open(path, "w") as f:
+        if comment:
+            f.write(f"# {comment}\n")
+        f.write(header + "\n")
+        for command in setup_commands:
+            f.write(f"C {command}\n")
+        for line in ladder_lines(entries):
+            f.write(line + "\n")
+        for t, command in commands:
+            f.write(f"U {t} {command}\n")
+
+
+# Recording
+
+def read_json_line(ser, timeout=2.0):
+    end = time.time() + timeout
+    while time.time() < end:
+        line = ser.readline().decode(errors="replace").strip()
+        if not line:
+            continue
+        try:
+            return json.loads(line)
+        except json.JSONDecodeError:
+            continue
+    return None
+
+
+def request(ser, command, reply_type, timeout=2.0):
+    ser.write((json.dumps(command) + "\n").encode())
+    end = time.time() + timeout
+    while time.time() < end:
+        parsed = read_json_line(ser, end - time.time())
+        if parsed is not None and parsed.get("type") in (reply_type, "error"):
+            return parsed
+    return None
+
+
+def setup_command_from_config(config):
+    """A set_config that recreates the configuration get_config returned."""
+    command = {"type": "set_config"}
+    for key in ("switches", "bank_nav", "pedals"):
+        if key in config:
+            command[key] = config[key]
+    return json.dumps(command, separators=(",", ":"))
+
+
+def record(port, path, seconds=5.0):
+    import serial
+    ser = serial.Serial(port, 115200, timeout=0.5)
+    time.sleep(2)
+    ser.reset_input_buffer()
+
+    config = request(ser, {"type": "get_config"}, "config")
+    if not config or config.get("type") != "config":
+        sys.exit(f"get_config failed: {config}")
+    started = request(ser, {"type": "trace", "action": "start"}, "response")
+    if not started or started.get("type") != "response":
+        sys.exit(f"trace start failed: {started}")
+    print(f"Recording for {seconds} s: play the footswitches now...")
+    time.sleep(seconds)
+
+    info = request(ser, {"type": "trace", "action": "dump"}, "trace")
+    if not info or info.get("type") != "trace":
+        sys.exit(f"trace dump failed: {info}")
+    streams = {"ladder": bytearray(), "uart": bytearray()}
+    while True:
+        line = read_json_line(ser, 5.0)
+        if line is None:
+            sys.exit("dump stopped before trace_end")
+        if line.get("type") == "trace_data":
+            data = streams[line["stream"]]
+            if line["offset"] != len(data):
+                sys.exit(f"{line['stream']} chunk out of order at {line['offset']}")
+            data.extend(bytes.fromhex(line["hex"]))
+        elif line.get("type") == "trace_end":
+            break
+    ser.close()
+
+    entries = [struct.unpack_from("<HH", streams["ladder"], i) for i in range(0, len(streams["ladder"]), 4)]
+    if len(entries) != info["ladder_samples"] or len(streams["uart"]) != info["uart_bytes"]:
+        sys.exit("dump length does not match its header")
+
+    commands = []
+    uart = streams["uart"]
+    at = 0
+    while at + 6 <= len(uart):
+        t, length = struct.unpack_from("<IH", uart, at)
+        line = uart[at + 6:at + 6 + length].decode(errors="replace")
+        commands.append(((t - info["start_us"]) & 0xFFFFFFFF, line))
+        at += 6 + length
+
+    setup = [setup_command_from_config(config)]
+    write_trace(path, header_line(info), setup, entries, commands,
+                comment=f"Recorded {time.strftime('%Y-%m-%d %H:%M')}" +
+                (" (truncated: buffer full)" if info.get("truncated") else ""))
+    print(f"{len(entries)} ladder samples, {len(commands)} commands -> {path}")
+
+
+# Synthetic scenarios
+
+class Synth:
+    def __init__(self):
+        self.entries = []
+
+    def hold(self, level, ms):
+        for _ in range(int(ms * 1000 / SAMPLE_US)):
+            self.entries.append((SAMPLE_US, level))
+
+    def bounce(self, level_from, level_to, ms=3):
+        """Contact bounce: the reading jumps between the two levels."""
+        for i in range(int(ms * 1000 / SAMPLE_US)):
+            self.entries.append((SAMPLE_US, level_to if i % 2 == 0 else level_from))
+
+    def stomp(self, switch, hold_ms, bounce_ms=3):
+        level = SYNTH_LEVELS[switch]
+        self.bounce(SYNTH_IDLE, level, bounce_ms)
+        self.hold(level, hold_ms)
+        self.bounce(level, SYNTH_IDLE, bounce_ms)
+
+
+def synth(scenario, path):
+    s = Synth()
+    commands = []
+    if scenario == "single_press":
+        comment = "One press of switch 1 with contact bounce, and a ping while it is held"
+        s.hold(SYNTH_IDLE, 100)
+        s.stomp(0, 200)
+        s.hold(SYNTH_IDLE, 300)
+        commands.append((150000, '{"type":"ping"}'))
+    elif scenario == "fast_stomps":
+        # The second stomp re-presses the selected switch, which sends nothing
+        comment = ("Switches 2 and 3 in quick succession, then a fast double stomp on switch 4 "
+                   "whose second stomp is swallowed on purpose (switch 4 is already selected)")
+        s.hold(SYNTH_IDLE, 100)
+        s.stomp(1, 80)
+        s.hold(SYNTH_IDLE, 40)
+        s.stomp(2, 80)
+        s.hold(SYNTH_IDLE, 40)
+        s.stomp(3, 70)
+        s.hold(SYNTH_IDLE, 60)
+        s.stomp(3, 70)
+        s.hold(SYNTH_IDLE, 300)
+    elif scenario == "short_stomp":
+        comment = "A 30 ms touch of switch 5 (under the debounce) is ignored; the 80 ms press after it is not"
+        s.hold(SYNTH_IDLE, 100)
+        s.stomp(4, 30)
+        s.hold(SYNTH_IDLE, 150)
+        s.stomp(4, 80)
+        s.hold(SYNTH_IDLE, 300)
+    else:
+        sys.exit(f"unknown scenario {scenario}")
+
+    info = {"rate_hz": 1000000 // SAMPLE_US, "switches": len(SYNTH_LEVELS), "debounce_ms": 50, "bank": 0,
+            "calibration": {"idle": SYNTH_IDLE, "levels": SYNTH_LEVELS}}
+    write_trace(path, header_line(info), [], s.entries, commands, comment=comment)
+    print(f"{len(s.entries)} ladder samples -> {path}")
+
+
+def main():
+    if len(sys.argv) >= 4 and sys.argv[1] == "record":
+        record(sys.argv[2], sys.argv[3], float(sys.argv[4]) if len(sys.argv) > 4 else 5.0)
+    elif len(sys.argv) == 4 and sys.argv[1] == "synth":
+        synth(sys.argv[2], sys.argv[3])
+    else:
+        print(__doc__)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
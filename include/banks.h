@@ -0,0 +1,63 @@
+#ifndef BANKS_H
+#define BANKS_H
+
+#include <Arduino.h>
+#include "midi.h" // for NUM_FOOTSWITCHES and FootswitchConfig
+#include "display.h" // for DisplayProducer
+
+// Bank store: BANK_COUNT complete switch layouts, plus one spare, kept side
+// by side in one static arena. `footswitches` always points at the active
+// bank, so a bank change is a pointer swap, and so is replacing a whole bank
+// (the new layout is written into the spare, then swapped in). Banks are read from flash lazily by the Arduino
+// loop (boot bank first, then the others nearest-first); the stage path never
+// touches flash or JSON.
+
+#define BANK_COUNT 32              // At most 32: residency is tracked in one word
+#define BANK_NAV_NONE -1
+#define BANK_PREFETCH_INTERVAL_MS 20   // Loop time between two background bank loads
+
+// Footswitches that step through banks instead of sending MIDI
+struct BankNavConfig {
+    int8_t prevSwitch;   // BANK_NAV_NONE if unassigned
+    int8_t nextSwitch;
+};
+
+// Written by the Arduino loop only; bank changes from any task are counted
+// by getBankSwitchCount()
+struct BankStats {
+    uint32_t deferredSwitches;  // Requested before the bank was resident, finished by the loop
+    uint32_t loads;             // Banks read from flash
+};
+
+extern BankNavConfig bankNav;
+extern BankStats bankStats;
+
+void initializeBanks();
+uint8_t getActiveBank();
+bool isBankResident(uint8_t bank);
+
+// Arena slot of a bank, loading it first if needed (Arduino loop only)
+FootswitchConfig *getBankSwitches(uint8_t bank);
+
+// Whole-bank update (Arduino loop only): stageBankUpdate() returns a copy of
+// the bank to modify without the config lock, publishBankUpdate() swaps it in
+FootswitchConfig *stageBankUpdate(uint8_t bank);
+void publishBankUpdate(uint8_t bank);
+
+// Make a bank active. Callable from the input task and the Arduino loop, each
+// passing its own display producer (the redraw queues have one producer
+// each). If the bank is not resident yet the switch is finished by
+// serviceBanks() on the loop. Returns true if it happened immediately.
+bool selectBank(uint8_t bank, DisplayProducer producer);
+bool stepBank(int delta, DisplayProducer producer);
+
+// Bank changes performed, from any task
+uint32_t getBankSwitchCount();
+
+// -1 / +1 if the switch is assigned to bank navigation, otherwise 0
+int bankNavDirection(int switchId);
+
+// Called from the loop: finish deferred bank changes and prefetch banks
+void serviceBanks();
+
+#endif // BANKS_H
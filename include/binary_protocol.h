@@ -0,0 +1,81 @@
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <Arduino.h>
+#include "midi.h" // for FOOTSWITCH_NAME_MAX
+
+// Optional binary transport on the host UART, entered with the JSON
+// {"type": "binary_hello"} handshake and left with OP_BYE. The session has
+// no idle timeout; a host that restarted in JSON mode ends it by sending a
+// JSON command line, which is then handled normally.
+//
+// Each frame is COBS-encoded and terminated by 0x00. Decoded layout:
+//   u8  version     BINARY_PROTOCOL_VERSION
+//   u8  op          BinaryOp
+//   u8  flags       BINARY_FLAG_*
+//   u8  seq         Sender's frame counter (wraps at 256)
+//   u16 requestId   Chosen by the host, echoed in the response (0 = unsolicited)
+//   ... payload
+//   u16 crc         CRC-16/CCITT over everything above
+// Multi-byte fields are little-endian.
+
+#define BINARY_PROTOCOL_VERSION 3         // 2: bank index in GET/SET_CONFIG, 3: MIDI action lists
+#define BINARY_HEADER_SIZE 6
+#define BINARY_CRC_SIZE 2
+#define BINARY_MAX_NAME_LENGTH FOOTSWITCH_NAME_MAX
+#define BINARY_SWITCH_RECORD_MAX (8 + BINARY_MAX_NAME_LENGTH + 1 + 4 * MIDI_MAX_ACTIONS)
+// Decoded bytes, header and CRC included: sized for a full GET/SET_CONFIG
+// (bank, count and every switch at its longest name and action list)
+#define BINARY_MAX_FRAME (BINARY_HEADER_SIZE + 2 + NUM_FOOTSWITCHES * BINARY_SWITCH_RECORD_MAX + BINARY_CRC_SIZE)
+#define BINARY_ACTIVE_BANK 0xFF            // Bank byte meaning "whichever bank is active"
+
+#define BINARY_FLAG_RESPONSE 0x01
+#define BINARY_FLAG_ERROR    0x02
+#define BINARY_FLAG_EVENT    0x04
+
+enum BinaryOp : uint8_t {
+    OP_HELLO            = 0x01,  // -> u8 version, u8 switch count, u8 bank count
+    OP_PING             = 0x02,
+    OP_GET_CONFIG       = 0x03,  // <- [u8 bank] -> u8 bank, u8 count, count x switch record
+    OP_SET_CONFIG       = 0x04,  // <- u8 bank, u8 count, count x switch record
+    OP_TEST_SWITCH      = 0x05,  // <- u8 switch id
+    OP_CALIBRATE_LADDER = 0x06,  // <- u8 action (0 capture, 1 save, 2 reset), i8 switch id -> u16 value
+    OP_BYE              = 0x07,
+    OP_GET_STATS        = 0x08,  // -> 6 x u32 protocol counters
+    OP_PATCH_SWITCH     = 0x09,  // <- u8 switch id, u8 PATCH_* mask, present fields in mask bit order (active bank)
+    OP_COMMIT           = 0x0A,  // -> u8 written, u32 flash writes, u32 writes avoided
+    OP_SELECT_BANK      = 0x0B,  // <- u8 bank -> u8 active bank, u8 bank count
+    OP_LOG              = 0x10   // Device -> host: type '\0' message
+};
+
+// OP_PATCH_SWITCH field mask; fields follow in this order with their record encoding
+#define PATCH_CHANNEL 0x01   // u8
+#define PATCH_CC      0x02   // u8
+#define PATCH_VALUE   0x04   // u8
+#define PATCH_ENABLED 0x08   // u8
+#define PATCH_COLOR   0x10   // u16
+#define PATCH_NAME    0x20   // u8 length, name bytes
+#define PATCH_ACTIONS 0x40   // action list
+
+// Switch record: u8 id, u8 channel, u8 cc, u8 value, u8 enabled,
+// u16 color (RGB565), u8 name length, name bytes (no terminator), action list
+// Action list: u8 count, count x (u8 MidiActionType, u8 channel, u8 data1, u8 data2)
+
+struct BinaryProtocolStats {
+    uint32_t framesReceived;
+    uint32_t framesSent;
+    uint32_t crcErrors;
+    uint32_t framingErrors;   // Bad COBS, short or oversized frames
+    uint32_t sequenceGaps;    // Host frames missing between two received ones
+    uint32_t sessions;
+};
+
+extern BinaryProtocolStats binaryStats;
+
+void startBinaryProtocol();
+bool isBinaryProtocolActive();
+void binaryProtocolReceive(uint8_t byte);
+void stopBinaryProtocol();
+void sendBinaryLog(const char *type, const char *message);
+
+#endif // BINARY_PROTOCOL_H
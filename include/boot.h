@@ -0,0 +1,37 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+// Boot profiler: each start-up stage is stamped with esp_timer time, i.e.
+// microseconds since the app started (the ROM and second-stage bootloader
+// run before that clock and are not included). setup() brings up
+// everything a press needs first; the display task initializes the panels
+// and paints them afterwards, while switches already send MIDI.
+// The profile is sent once as {"type": "boot_profile"} when the first paint
+// is done, and again on request.
+
+#define BOOT_INPUT_READY_TARGET_US 100000  // App start -> first press can send MIDI
+
+enum BootStage : uint8_t {
+    BOOT_STAGE_SETUP,          // setup() entered
+    BOOT_STAGE_UART,           // Host UART open
+    BOOT_STAGE_MIDI,           // MIDI OUT/IN open
+    BOOT_STAGE_LADDER,         // Ladder pin and calibration ready
+    BOOT_STAGE_CONFIG,         // Boot bank, bank store and pedals loaded
+    BOOT_STAGE_INPUT_READY,    // Sampler and input task running: presses send MIDI
+    BOOT_STAGE_DISPLAY_INIT,   // Panels initialized (display task)
+    BOOT_STAGE_FIRST_PAINT,    // Both screens drawn (display task)
+    BOOT_STAGE_COUNT
+};
+
+// Safe from any task; a stage keeps its first time
+void markBootStage(BootStage stage);
+bool bootStageReached(BootStage stage);
+uint32_t bootStageUs(BootStage stage);
+
+// Arduino loop
+void sendBootProfile();
+void serviceBootProfile();   // Sends the profile once the first paint is done
+
+#endif // BOOT_H
@@ -6,10 +6,70 @@
 #include <Preferences.h>
 #include "midi.h"
 
-// Function declarations for configuration management
-void initializeDefaultConfig();
+// Persisted configuration: one packed, CRC-checked record written with putBytes
+#define CONFIG_BLOB_MAGIC 0x4346   // "FC"
+#define CONFIG_BLOB_VERSION 3          // 2: MIDI action lists, 3: gestures (older records are still read)
+
+struct __attribute__((packed)) PackedSwitchConfig {
+    char name[FOOTSWITCH_NAME_MAX + 1];   // NUL-terminated
+    uint8_t midiChannel;
+    uint8_t midiCC;
+    uint8_t midiValue;
+    uint8_t enabled;
+    uint16_t color;
+    uint8_t actionCount;
+    MidiAction actions[MIDI_MAX_ACTIONS];
+    GestureConfig gestures;
+};
+
+struct __attribute__((packed)) PackedConfig {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t count;                        // NUM_FOOTSWITCHES at time of writing
+    PackedSwitchConfig switches[NUM_FOOTSWITCHES];
+    uint16_t crc;                         // CRC-16/CCITT over all preceding bytes
+};
+
+// Time spent by the last loadConfigFromFlash(), for boot profiling
+extern uint32_t configLoadTimeUs;
+
+// Patches are written to flash once no further edit arrived for this long
+#define CONFIG_COMMIT_DELAY_MS 2000
+#define CONFIG_COMMIT_MAX_RETRIES 3     // Failed writes retried a quiet period apart, then left for the next edit
+
+struct ConfigPersistStats {
+    uint32_t flashWrites;     // Records actually written
+    uint32_t writesAvoided;   // Edits folded into an already pending commit
+    uint32_t patches;         // patch_switch edits applied
+    uint32_t writeFailures;   // Flash writes that failed (each retry counts)
+};
+
+extern ConfigPersistStats configPersistStats;
+
+// Function declarations for configuration management.
+// Every bank is stored as its own PackedConfig record.
+void initializeDefaultConfig(FootswitchConfig *switches);
+void applySwitchConfig(FootswitchConfig &fs, JsonObjectConst sw);
+void setFootswitchName(FootswitchConfig &fs, const char *name);
+void markBankDirty(uint8_t bank);
 void saveConfigToFlash();
+bool loadBankFromFlash(uint8_t bank, FootswitchConfig *switches);
+void saveBankNavToFlash();
 void loadConfigFromFlash();
-void sendCurrentConfig();
+void sendCurrentConfig(uint8_t bank);
+void commitConfigUpdate(uint8_t bank);
+
+// Incremental edits: change RAM now, write flash after a quiet period
+bool patchSwitchConfig(FootswitchConfig &fs, JsonObjectConst patch);
+void scheduleConfigCommit(uint8_t bank, uint8_t switchId);
+bool commitPendingConfig();
+bool isConfigCommitPending();
+void serviceConfigCommit();
+
+// Guards the bank arena against concurrent rewrite (host), read (display task)
+// and bank swaps (input task)
+void initializeConfigLock();
+void lockConfig();
+void unlockConfig();
 
 #endif // CONFIG_H
@@ -9,17 +9,55 @@
 extern MultiTFT footswitchDisplay;
 extern MultiTFT configDisplay;
 
+// Display task placement: drawing runs on the core not used for input
+#define DISPLAY_TASK_CORE 0
+#define DISPLAY_TASK_PRIORITY 1
+#define DISPLAY_TASK_STACK_SIZE 8192
+#define DISPLAY_EVENT_QUEUE_SIZE 8
+#define STATUS_BADGE_MS 1500           // How long "CONFIG UPDATED" stays up after a change
+
+// Redraw requests handled by the display task. Values are bit flags so
+// that identical pending requests can be coalesced.
+enum DisplayEvent : uint8_t {
+    DISPLAY_EVENT_FOOTSWITCH = 1 << 0,
+    DISPLAY_EVENT_CONFIG     = 1 << 1
+};
+
+// Each producing task gets its own single-producer queue
+enum DisplayProducer : uint8_t {
+    DISPLAY_PRODUCER_INPUT,   // Footswitch/MIDI task
+    DISPLAY_PRODUCER_HOST,    // Arduino loop (UART commands, timers)
+    DISPLAY_PRODUCER_COUNT
+};
+
+// Per-panel SPI traffic counters
+struct DisplayFrameStats {
+    uint32_t lastFrameBytes;   // Bytes pushed by the most recent non-empty update
+    uint32_t totalBytes;       // Bytes pushed since boot
+    uint32_t framesDrawn;      // Updates that touched the panel
+    uint32_t framesSkipped;    // Updates skipped because nothing changed
+};
+
 // Display function declarations
 void initializeDisplays();
+void bringUpDisplays();
+void startDisplayTask();
+void postDisplayEvent(DisplayProducer producer, DisplayEvent event);
+uint8_t serviceDisplayEvents();
 void updateFootswitchDisplay();
 void updateConfigDisplay();
 void drawFootswitchScreen();
 void drawConfigScreen();
-void showConfiguringMessage();
-void hideConfiguringMessage();
+void invalidateDisplays();
+void showStatusBadge();
+void serviceStatusBadge();
 void showLoadingScreen();
+void sendDisplayStats();
+
+extern DisplayFrameStats footswitchDisplayStats;
+extern DisplayFrameStats configDisplayStats;
 
 // Helper function for determining text color based on background brightness
 uint16_t getTextColorForBackground(uint16_t backgroundColor);
 
-#endif // DISPLAY_H
\ No newline at end of file
+#endif // DISPLAY_H
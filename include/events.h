@@ -0,0 +1,78 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Host event stream: after {"type": "subscribe"} the host is sent one short
+// JSON line per switch edge, gesture, MIDI block on the wire and
+// configuration change, instead of having to poll.
+// - Producers (the input task or the loop) copy a fixed-size record into a
+//   lock-free ring and return at once; they skip even that unless the
+//   event's kind is subscribed.
+// - serviceEvents() on the Arduino loop writes the records, but only as
+//   much as the host UART accepts without blocking. A slow host therefore
+//   fills the ring, and further events are dropped and counted rather than
+//   stalling the loop.
+// - Sequence numbers count every posted event. A gap is the number of events
+//   dropped, and a {"ev":"dropped"} line marks where it happened.
+
+#define EVENT_RING_SIZE 64             // Power of two
+#define EVENT_FLUSH_PER_PASS 8         // Lines written per serviceEvents() call, at most
+#define EVENT_LINE_MAX_LENGTH 128
+
+enum HostEventKind : uint8_t {
+    HOST_EVENT_SWITCH,     // code: 1 down, 0 up; index: switch
+    HOST_EVENT_GESTURE,    // code: GestureEvent; index: switch
+    HOST_EVENT_MIDI,       // code: MidiProducer or MIDI_PRODUCER_COUNT (pedals); data: status, length
+    HOST_EVENT_CONFIG,     // code: ConfigEvent; index: bank or pedal, data[0]: switch for patches
+    HOST_EVENT_KIND_COUNT
+};
+
+enum ConfigEvent : uint8_t {
+    CONFIG_EVENT_BANK,     // Active bank changed
+    CONFIG_EVENT_SET,      // Whole bank replaced
+    CONFIG_EVENT_PATCH,    // One switch patched
+    CONFIG_EVENT_SAVED,    // Pending changes written to flash
+    CONFIG_EVENT_PEDALS,
+    CONFIG_EVENT_COUNT
+};
+
+#define EVENT_NO_SWITCH 0xFF
+
+struct HostEventRecord {
+    uint32_t timeUs;        // When it happened (edge, gesture or wire time)
+    uint32_t dropsBefore;   // Events dropped before this one was posted
+    uint8_t kind;
+    uint8_t code;
+    uint8_t index;
+    uint8_t data[2];
+};
+
+struct EventStats {
+    uint32_t posted;        // Accepted into the ring
+    uint32_t dropped;       // Ring full
+    uint32_t sent;          // Lines written to the host
+};
+
+extern EventStats eventStats;
+extern std::atomic<uint8_t> subscribedEvents;   // Bit per HostEventKind
+
+inline bool isEventSubscribed(HostEventKind kind) {
+    return (subscribedEvents.load(std::memory_order_relaxed) & (1u << kind)) != 0;
+}
+
+// Any task. Returns false if the kind is not subscribed or the ring is full.
+bool postHostEvent(HostEventKind kind, uint8_t code, uint8_t index, uint32_t timeUs,
+                   uint8_t data0 = 0, uint8_t data1 = 0);
+
+// Arduino loop
+void initializeEvents();
+bool parseEventKind(const char *name, HostEventKind &kind);
+const char *eventKindName(uint8_t kind);
+// Start (mask != 0) or end a subscription. Events still waiting are
+// discarded. Returns the sequence number the next event will get.
+uint32_t subscribeEvents(uint8_t mask);
+void serviceEvents();
+
+#endif // EVENTS_H
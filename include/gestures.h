@@ -0,0 +1,49 @@
+#ifndef GESTURES_H
+#define GESTURES_H
+
+#include <Arduino.h>
+#include "midi.h" // for NUM_FOOTSWITCHES, GestureEvent and GestureConfig
+
+// Gesture engine: one state machine per switch, driven by the debounced
+// ladder edges (with their sample timestamps) and by the sample clock.
+//
+// - Press and release are always reported, at their edge times.
+// - Long press fires once when a switch is held for longPressMs, hold repeat
+//   fires after repeatDelayMs and then every repeatIntervalMs. Both are only
+//   timed for switches that bind them and never hold back the press.
+// - A switch with a double-tap binding holds its press back until it is
+//   clear that no second tap follows: the tap must be released within
+//   doubleTapMs and the next press must start within doubleTapMs of that.
+//   A double tap reports DOUBLE_TAP instead of both presses. Switches
+//   without one report the press as soon as it is debounced.
+//
+// Input task only. Thresholds and bindings are copied when a press starts.
+
+// Defaults for switches whose configuration does not set them
+#define GESTURE_LONG_PRESS_MS 600
+#define GESTURE_DOUBLE_TAP_MS 300
+#define GESTURE_REPEAT_DELAY_MS 500
+#define GESTURE_REPEAT_INTERVAL_MS 100
+#define GESTURE_MIN_MS 20
+#define GESTURE_MAX_MS 10000
+
+// timeUs is the edge time for press, release and double tap, and the sample
+// time for long press and hold repeat
+typedef void (*GestureHandler)(int switchIndex, GestureEvent event, uint32_t timeUs);
+
+void initializeGestures(GestureHandler handler);
+void gestureSwitchDown(int switchIndex, uint32_t edgeUs);
+void gestureSwitchUp(int switchIndex, uint32_t edgeUs);
+// Run the timers up to nowUs. Call only while the ladder is settled, so a
+// second tap still being debounced is not mistaken for the end of the window.
+void serviceGestures(uint32_t nowUs);
+
+void setDefaultGestures(GestureConfig &gestures);
+uint8_t gestureBindingMask(const GestureConfig &gestures);
+const char *gestureEventName(uint8_t event);
+
+inline uint8_t gestureBit(GestureEvent event) {
+    return (uint8_t)(1u << event);
+}
+
+#endif // GESTURES_H
@@ -0,0 +1,36 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Bump allocator over a caller-supplied static buffer, used as the
+// ArduinoJson allocator so parsing and building documents never touches
+// the heap. Memory is reclaimed all at once by reset(); each arena must
+// only back one live JsonDocument at a time, from a single task.
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    JsonArena(uint8_t *buffer, size_t capacity);
+
+    // Drop everything allocated so far and return the allocator for a new document
+    ArduinoJson::Allocator *reset();
+
+    void *allocate(size_t size) override;
+    void deallocate(void *ptr) override;
+    void *reallocate(void *ptr, size_t newSize) override;
+
+    size_t capacity() const { return _capacity; }
+    size_t used() const { return _used; }
+    size_t peak() const { return _peak; }          // High-water mark since boot
+    uint32_t failures() const { return _failures; } // Allocations refused for lack of space
+
+private:
+    uint8_t *_buffer;
+    size_t _capacity;
+    size_t _used;
+    size_t _peak;
+    uint32_t _failures;
+    uint8_t *_lastBlock;
+};
+
+#endif // JSON_ARENA_H
@@ -0,0 +1,65 @@
+#ifndef LADDER_H
+#define LADDER_H
+
+#include <Arduino.h>
+#include "midi.h" // for NUM_FOOTSWITCHES
+
+// Fixed-rate sampling of the footswitch resistor ladder.
+// A hardware timer wakes a sampler task, which reads the ADC, median-filters
+// the raw values and queues timestamped samples for the input task. The same
+// task reads the expression pedals (see pedals.h).
+
+#ifndef LADDER_SAMPLE_RATE_HZ
+#define LADDER_SAMPLE_RATE_HZ 2000
+#endif
+
+#define LADDER_MEDIAN_TAPS 5       // Odd; a single noisy read never reaches the classifier
+#define LADDER_QUEUE_SIZE 64       // Power of two; ~32 ms of samples at 2 kHz
+#define LADDER_TIMER_ID 0
+#define LADDER_TASK_CORE 1
+#define LADDER_TASK_PRIORITY (configMAX_PRIORITIES - 1)
+#define LADDER_TASK_STACK_SIZE 2048
+
+// Classification table: one entry per 12-bit ADC code
+#define LADDER_ADC_CODES 4096
+#define LADDER_NONE -1             // No switch pressed
+#define LADDER_HOLD -2             // Guard band: keep the previous classification
+#define LADDER_GUARD_PERCENT 15    // Guard half-width as % of the narrower neighbouring band
+#define LADDER_MIN_LEVEL_GAP 40    // Minimum distance between calibrated levels
+#define LADDER_LEVEL_UNSET 0xFFFF
+#define LADDER_FACTORY_STEP 200   // ADC codes between switches before calibration
+#define LADDER_CALIBRATION_VERSION 1
+
+// Measured ADC level of each switch (and of the idle ladder), persisted to NVS
+struct LadderCalibration {
+    uint16_t version;
+    uint16_t idleLevel;                       // LADDER_LEVEL_UNSET if not captured
+    uint16_t levels[NUM_FOOTSWITCHES];        // LADDER_LEVEL_UNSET if not captured
+};
+
+struct LadderSample {
+    uint16_t value;          // Median-filtered 12-bit ADC code
+    uint32_t timestampUs;    // Time of the timer tick that triggered the read
+};
+
+void initializeLadderSampler(uint32_t sampleRateHz = LADDER_SAMPLE_RATE_HZ);
+void attachLadderConsumer(TaskHandle_t task);
+bool queueLadderSample(const LadderSample &sample);
+bool readLadderSample(LadderSample &sample);
+uint32_t getLadderSampleRate();
+uint32_t getLadderOverruns();
+uint16_t getLadderValue();
+
+// Constant-time classification: a table load plus hysteresis in guard bands
+int classifyLadder(uint16_t value, int previous);
+
+// Calibration (run from the host via the calibrate_ladder command)
+void loadLadderCalibration();
+uint16_t captureLadderLevel(int switchId);
+bool saveLadderCalibration(char *error, size_t errorSize);
+void resetLadderCalibration();
+bool isLadderCalibrated();
+bool getLadderCalibration(LadderCalibration &cal);   // False while on factory thresholds
+bool useLadderCalibration(const LadderCalibration &cal, char *error, size_t errorSize);
+
+#endif // LADDER_H
@@ -0,0 +1,160 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+#include "midi.h" // for NUM_FOOTSWITCHES
+
+// Footswitch screen layout, computed at compile time from the switch count
+// and the panel size after rotation. The grid is chosen so tiles come closest
+// to the proportions of the original six-switch screen (220x90), with a
+// penalty for grids that leave cells empty. Six switches on the landscape
+// panel give exactly the original 2x3 grid.
+//
+// Everything here is constexpr: the firmware reads tile origins, sizes,
+// font sizes and text anchors from tables, and a count that cannot fit the
+// panel fails the build.
+
+// ST7796 native (portrait) resolution
+#define PANEL_NATIVE_WIDTH 320
+#define PANEL_NATIVE_HEIGHT 480
+
+#define FOOTSWITCH_ROTATION 1    // Landscape
+#define CONFIG_ROTATION 3        // Landscape (rotated)
+
+#define LAYOUT_MARGIN 10                 // Panel edge to the outer tiles
+#define LAYOUT_GAP_X 20                  // Between tile columns
+#define LAYOUT_GAP_Y 15                  // Between tile rows
+#define LAYOUT_TARGET_ASPECT_X100 244    // Preferred tile width/height, times 100
+#define LAYOUT_EMPTY_CELL_PENALTY 100    // Score cost of an unused grid cell
+#define LAYOUT_MIN_TILE_WIDTH 80
+#define LAYOUT_MIN_TILE_HEIGHT 40
+#define LAYOUT_NAME_FIT_CHARS 10         // Name characters a tile must fit at its font size
+#define LAYOUT_LABEL_FIT_CHARS 11        // "CC127 Ch16" plus a space of slack
+
+namespace layout {
+
+// GLCD font cell at text size 1
+static const int GLYPH_WIDTH = 6;
+static const int GLYPH_HEIGHT = 8;
+
+constexpr int panelWidth(int rotation) {
+    return (rotation & 1) ? PANEL_NATIVE_HEIGHT : PANEL_NATIVE_WIDTH;
+}
+
+constexpr int panelHeight(int rotation) {
+    return (rotation & 1) ? PANEL_NATIVE_WIDTH : PANEL_NATIVE_HEIGHT;
+}
+
+constexpr int rowsFor(int count, int columns) {
+    return (count + columns - 1) / columns;
+}
+
+constexpr int tileWidth(int width, int columns) {
+    return (width - 2 * LAYOUT_MARGIN - (columns - 1) * LAYOUT_GAP_X) / columns;
+}
+
+constexpr int tileHeight(int height, int rows) {
+    return (height - 2 * LAYOUT_MARGIN - (rows - 1) * LAYOUT_GAP_Y) / rows;
+}
+
+constexpr int absDiff(int a, int b) {
+    return a > b ? a - b : b - a;
+}
+
+// Lower is better; grids whose tiles would vanish are never chosen
+constexpr int gridScore(int count, int width, int height, int columns) {
+    return (tileWidth(width, columns) <= 0 || tileHeight(height, rowsFor(count, columns)) <= 0)
+        ? 0x7FFFFFFF
+        : absDiff(tileWidth(width, columns) * 100 / tileHeight(height, rowsFor(count, columns)),
+                  LAYOUT_TARGET_ASPECT_X100) +
+          (columns * rowsFor(count, columns) - count) * LAYOUT_EMPTY_CELL_PENALTY;
+}
+
+// Ties keep the narrower grid
+constexpr int bestColumns(int count, int width, int height, int columns = 1, int best = 1) {
+    return columns > count
+        ? best
+        : bestColumns(count, width, height, columns + 1,
+                      gridScore(count, width, height, columns) < gridScore(count, width, height, best)
+                          ? columns : best);
+}
+
+constexpr int minOf(int a, int b) {
+    return a < b ? a : b;
+}
+
+constexpr int clampSize(int size) {
+    return size < 1 ? 1 : size;
+}
+
+// Name: size 3 on tall tiles, smaller as tiles get short or narrow
+constexpr int nameTextSize(int width, int height) {
+    return clampSize(minOf(height >= 80 ? 3 : height >= 56 ? 2 : 1,
+                           width / (GLYPH_WIDTH * LAYOUT_NAME_FIT_CHARS)));
+}
+
+constexpr int labelTextSize(int width, int height) {
+    return clampSize(minOf(height >= 80 ? 2 : 1, width / (GLYPH_WIDTH * LAYOUT_LABEL_FIT_CHARS)));
+}
+
+// Compile-time list of slot indices, for building the origin tables
+template <int... I> struct IndexList {};
+template <int N, int... I> struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+template <int... I> struct MakeIndexList<0, I...> { typedef IndexList<I...> type; };
+
+} // namespace layout
+
+struct TileOrigin {
+    int16_t x;
+    int16_t y;
+};
+
+// Row-major tile origins of a grid, one per switch
+template <typename Grid, typename List>
+struct TileOriginTable;
+
+template <typename Grid, int... I>
+struct TileOriginTable<Grid, layout::IndexList<I...> > {
+    static constexpr TileOrigin values[sizeof...(I)] = {
+        {(int16_t)(LAYOUT_MARGIN + (I % Grid::columns) * (Grid::tileWidth + LAYOUT_GAP_X)),
+         (int16_t)(LAYOUT_MARGIN + (I / Grid::columns) * (Grid::tileHeight + LAYOUT_GAP_Y))}...
+    };
+};
+
+template <typename Grid, int... I>
+constexpr TileOrigin TileOriginTable<Grid, layout::IndexList<I...> >::values[sizeof...(I)];
+
+template <int Count, int PanelWidth, int PanelHeight>
+struct TileGrid {
+    static constexpr int count = Count;
+    static constexpr int columns = layout::bestColumns(Count, PanelWidth, PanelHeight);
+    static constexpr int rows = layout::rowsFor(Count, columns);
+    static constexpr int tileWidth = layout::tileWidth(PanelWidth, columns);
+    static constexpr int tileHeight = layout::tileHeight(PanelHeight, rows);
+
+    static constexpr int nameSize = layout::nameTextSize(tileWidth, tileHeight);
+    static constexpr int labelSize = layout::labelTextSize(tileWidth, tileHeight);
+    // Text anchors (middle centre) relative to the tile: 30 and 65 on a 90 px tile
+    static constexpr int textX = tileWidth / 2;
+    static constexpr int nameY = tileHeight / 3;
+    static constexpr int labelY = tileHeight * 13 / 18;
+
+    static_assert(Count >= 1, "at least one footswitch is required");
+    static_assert(columns * rows >= Count, "grid does not hold every footswitch");
+    static_assert(tileWidth >= LAYOUT_MIN_TILE_WIDTH, "footswitch tiles too narrow for the panel");
+    static_assert(tileHeight >= LAYOUT_MIN_TILE_HEIGHT, "footswitch tiles too short for the panel");
+    static_assert(nameY + nameSize * layout::GLYPH_HEIGHT / 2 <= labelY - labelSize * layout::GLYPH_HEIGHT / 2,
+                  "name and label text overlap");
+    static_assert(labelY + labelSize * layout::GLYPH_HEIGHT / 2 < tileHeight, "label text leaves the tile");
+
+    typedef TileOriginTable<TileGrid, typename layout::MakeIndexList<Count>::type> Origins;
+
+    static constexpr const TileOrigin &origin(int slot) { return Origins::values[slot]; }
+};
+
+// The footswitch panel of this build
+typedef TileGrid<NUM_FOOTSWITCHES,
+                 layout::panelWidth(FOOTSWITCH_ROTATION),
+                 layout::panelHeight(FOOTSWITCH_ROTATION)> FootswitchLayout;
+
+#endif // LAYOUT_H
@@ -0,0 +1,82 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Deferred logging for tasks that must not block on the host UART.
+// LOG_* calls copy the format pointer and up to LOG_MAX_ARGS integer
+// arguments into a fixed-size record in a lock-free ring (any task, no heap,
+// no Serial). serviceLog() on the Arduino loop formats the records and
+// writes them as the usual {"type": ..., "message": ...} lines.
+//
+// The format must be a string literal and take integer arguments only
+// (%d, %u, %x, %c); records are formatted after the caller has returned.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE  4
+
+// Calls below this level are compiled out entirely
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SIZE 64            // Power of two
+#define LOG_MAX_ARGS 4
+#define LOG_FLUSH_PER_PASS 8        // Records formatted per serviceLog() call
+
+struct LogRecord {
+    const char *type;               // JSON "type" field, a string literal
+    const char *format;
+    uint8_t argCount;
+    uint32_t args[LOG_MAX_ARGS];
+};
+
+struct LogStats {
+    uint32_t written;
+    uint32_t dropped;               // Ring full when the record was made
+    uint32_t flushed;
+};
+
+extern LogStats logStats;
+
+void initializeLog();
+bool logPush(const char *type, const char *format, const uint32_t *args, uint8_t argCount);
+void serviceLog();
+
+template <typename... Args>
+inline void logDeferred(const char *type, const char *format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+    // static_cast rejects pointers (strings would be gone by flush time)
+    const uint32_t values[sizeof...(Args) + 1] = {0, static_cast<uint32_t>(args)...};
+    logPush(type, format, values + 1, sizeof...(Args));
+}
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(type, ...) logDeferred(type, __VA_ARGS__)
+#else
+#define LOG_DEBUG(type, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(type, ...) logDeferred(type, __VA_ARGS__)
+#else
+#define LOG_INFO(type, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(type, ...) logDeferred(type, __VA_ARGS__)
+#else
+#define LOG_WARN(type, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(type, ...) logDeferred(type, __VA_ARGS__)
+#else
+#define LOG_ERROR(type, ...) do {} while (0)
+#endif
+
+#endif // LOG_H
@@ -3,8 +3,8 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <MIDI.h>
 #include <HardwareSerial.h>
+#include <type_traits>
 
 // Configuration constants
 #define MIDI_BAUD_RATE 31250
@@ -20,25 +20,143 @@
 #define YELLOW  0xFFE0
 #define WHITE   0xFFFF
 
-// Footswitch configuration structure
+// Longest switch name kept in flash and sent over the binary protocol
+#define FOOTSWITCH_NAME_MAX 31
+
+// Per-switch MIDI actions, compiled to wire bytes whenever a switch changes
+#define MIDI_MAX_ACTIONS 8
+#define MIDI_MAX_SWITCH_BYTES (MIDI_MAX_ACTIONS * 3)
+
+// Non-blocking output: one ring of blocks per producer, drained by the input
+// task. A block is one switch's bytes or one THRU message, preceded by a
+// header (u8 length, u32 enqueue time in us); blocks from different rings
+// are merged only at block boundaries.
+#define MIDI_TX_QUEUE_SIZE 256                 // Power of two, per producer
+#define MIDI_BLOCK_HEADER_SIZE 5
+#define MIDI_MAX_BLOCK 128                     // Longest block payload (a forwarded SysEx)
+#define MIDI_REALTIME_QUEUE_SIZE 32            // Real-time bytes, sent ahead of everything
+#define MIDI_RUNNING_STATUS_REFRESH_MS 1000    // Resend status after this long idle
+#define MIDI_UART_FIFO_SIZE 128                // Serial2 hardware TX FIFO
+#define MIDI_PRESS_ORIGIN_QUEUE_SIZE 64        // Edge times of queued presses (power of two)
+
+// Continuous controllers (expression pedals) do not queue: each has one slot
+// holding its newest message, which replaces one not yet sent. Slots are
+// sent only while no INPUT or HOST block is waiting.
+#define MIDI_CONTINUOUS_SLOTS 4
+#define MIDI_CONTINUOUS_MAX_BYTES 5            // 14-bit CC: status, MSB pair, LSB pair
+
+enum MidiActionType : uint8_t {
+    MIDI_ACTION_PC = 0,         // data1 = program
+    MIDI_ACTION_CC = 1,         // data1 = controller, data2 = value
+    MIDI_ACTION_NOTE_ON = 2,    // data1 = note, data2 = velocity
+    MIDI_ACTION_NOTE_OFF = 3,   // data1 = note, data2 = velocity
+    MIDI_ACTION_TYPE_COUNT
+};
+
+struct MidiAction {
+    uint8_t type;      // MidiActionType
+    uint8_t channel;   // 1-16
+    uint8_t data1;
+    uint8_t data2;
+};
+
+enum MidiProducer : uint8_t {
+    MIDI_PRODUCER_INPUT,   // Input task (footswitch presses)
+    MIDI_PRODUCER_HOST,    // Arduino loop (test_switch)
+    MIDI_PRODUCER_THRU,    // Input task (messages received on MIDI IN)
+    MIDI_PRODUCER_COUNT
+};
+
+// Per-switch gestures beyond the plain press, see gestures.h
+enum GestureEvent : uint8_t {
+    GESTURE_PRESS,         // Sends the switch's own actions
+    GESTURE_RELEASE,
+    GESTURE_LONG_PRESS,
+    GESTURE_DOUBLE_TAP,    // Replaces both presses
+    GESTURE_HOLD_REPEAT,
+    GESTURE_EVENT_COUNT
+};
+
+#define GESTURE_BINDING_COUNT (GESTURE_EVENT_COUNT - 1)   // Every event but the press
+
+enum GestureActionKind : uint8_t {
+    GESTURE_ACTION_NONE = 0,
+    GESTURE_ACTION_MIDI = 1,        // Send one MidiAction
+    GESTURE_ACTION_BANK_NEXT = 2,
+    GESTURE_ACTION_BANK_PREV = 3,
+    GESTURE_ACTION_KIND_COUNT
+};
+
+struct GestureBinding {
+    uint8_t kind;      // GestureActionKind
+    MidiAction midi;   // GESTURE_ACTION_MIDI only
+};
+
+struct GestureConfig {
+    uint16_t longPressMs;
+    uint16_t doubleTapMs;        // Longest tap, and longest gap before the second tap
+    uint16_t repeatDelayMs;      // Hold before the first repeat
+    uint16_t repeatIntervalMs;
+    GestureBinding bindings[GESTURE_BINDING_COUNT];   // Indexed by event - 1
+};
+
+struct MidiTxStats {
+    uint32_t bytesQueued;
+    uint32_t bytesSent;
+    uint32_t statusBytesSaved;   // Status bytes elided by running status
+    uint32_t queueFull;          // Blocks dropped because a ring was full
+    uint32_t maxLatencyUs[MIDI_PRODUCER_COUNT];   // Enqueue to UART FIFO, worst case
+    uint32_t continuousSent;        // Controller messages sent
+    uint32_t continuousCoalesced;   // Replaced by a newer value before they were sent
+    uint32_t continuousMaxLatencyUs;
+};
+
+// Footswitch configuration. Plain data with the name stored inline, so a
+// switch is copied with memcpy (bank store, display snapshot, flash blob)
+// and never touches the heap. Fields read on every press and redraw come
+// first; the action list they are compiled from follows.
 struct FootswitchConfig {
-    String name;
+    // Hot: press and redraw
+    bool enabled : 1;
+    uint16_t color;  // RGB565 color value
     uint8_t midiChannel;
     uint8_t midiCC;
+    uint8_t gestureMask;   // Bit per bound GestureEvent, set by compileSwitchMidi()
+
+    // Compiled by compileSwitchMidi(): complete messages, running status
+    // already applied between consecutive actions
+    uint8_t midiLength;
+    uint8_t midiBytes[MIDI_MAX_SWITCH_BYTES];
+
+    char name[FOOTSWITCH_NAME_MAX + 1];   // NUL-terminated
+
+    // Cold: edited, saved and compiled, never read by a press
     uint8_t midiValue;
-    bool enabled;
-    uint16_t color;  // RGB565 color value
+    // With no actions the switch sends CC midiCC = midiValue on midiChannel
+    uint8_t actionCount;
+    MidiAction actions[MIDI_MAX_ACTIONS];
+    GestureConfig gestures;
 };
 
-// Forward declaration for MIDI
-extern midi::MidiInterface<midi::SerialMIDI<HardwareSerial>> MIDI;
+static_assert(std::is_trivially_copyable<FootswitchConfig>::value,
+              "FootswitchConfig is copied with memcpy");
+
+// Switches of the active bank (points into the bank store, see banks.h)
+extern FootswitchConfig *footswitches;
 
-// Footswitch configuration and runtime variables are provided by switches module
-extern FootswitchConfig footswitches[NUM_FOOTSWITCHES];
+extern MidiTxStats midiTxStats;
 
 // Function declarations
 void initializeMIDI();
-void sendMidiCC(int switchIndex);
+void compileSwitchMidi(FootswitchConfig &fs);
+bool parseMidiActionType(const char *name, uint8_t &type);
+const char *midiActionTypeName(uint8_t type);
+bool queueSwitchMidi(MidiProducer producer, int switchIndex, uint32_t originUs = 0);
+bool queueMidiAction(MidiProducer producer, const MidiAction &action, uint32_t originUs = 0);
+bool queueMidiBlock(MidiProducer producer, const uint8_t *bytes, uint8_t length);
+bool queueMidiRealtime(uint8_t byte);
+bool queueMidiContinuous(uint8_t slot, const uint8_t *bytes, uint8_t length);
+void serviceMidiOutput();
 
 
 #endif // MIDI_CONTROLLER_H
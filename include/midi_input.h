@@ -0,0 +1,62 @@
+#ifndef MIDI_INPUT_H
+#define MIDI_INPUT_H
+
+#include <Arduino.h>
+#include "midi.h"
+
+// MIDI IN on Serial2, drained by the input task every tick. Complete messages
+// are counted, fed to the clock tracker and (with THRU on) queued for output
+// as MIDI_PRODUCER_THRU blocks; real-time bytes bypass the block queues.
+
+#define MIDI_THRU_SYSEX_MAX MIDI_MAX_BLOCK   // Longer SysEx messages are dropped, not forwarded
+#define MIDI_INJECT_QUEUE_SIZE 512           // Power of two; host-simulated input bytes
+#define MIDI_BYTE_TIME_US 320                // One byte at 31250 baud; injected bytes are paced to it
+#define MIDI_CLOCK_PPQN 24
+#define MIDI_CLOCK_TIMEOUT_MS 500            // Clock considered stopped after this long without a tick
+
+enum MidiInputType : uint8_t {
+    MIDI_IN_NOTE_OFF,          // Includes Note On with velocity 0
+    MIDI_IN_NOTE_ON,
+    MIDI_IN_POLY_PRESSURE,
+    MIDI_IN_CONTROL_CHANGE,
+    MIDI_IN_PROGRAM_CHANGE,
+    MIDI_IN_CHANNEL_PRESSURE,
+    MIDI_IN_PITCH_BEND,
+    MIDI_IN_SYSEX,
+    MIDI_IN_SYSTEM_COMMON,
+    MIDI_IN_CLOCK,
+    MIDI_IN_START,
+    MIDI_IN_CONTINUE,
+    MIDI_IN_STOP,
+    MIDI_IN_ACTIVE_SENSING,
+    MIDI_IN_SYSTEM_RESET,
+    MIDI_IN_TYPE_COUNT
+};
+
+struct MidiInputStats {
+    uint32_t bytesReceived;
+    uint32_t droppedBytes;     // Stray data, undefined status, oversized SysEx, THRU queue full
+    uint32_t thruMessages;
+    uint32_t messages[MIDI_IN_TYPE_COUNT];
+};
+
+extern MidiInputStats midiInputStats;
+extern volatile bool midiThruEnabled;
+
+const char *midiInputTypeName(uint8_t type);
+
+// Input task: read Serial2 (and injected bytes) and parse them
+void serviceMidiInput();
+
+// Host side: feed bytes to the parser as if they arrived on MIDI IN.
+// All or nothing; returns false if the inject queue is full.
+bool injectMidiInput(const uint8_t *bytes, size_t length);
+
+// Zero input and output counters (done by the input task on its next tick)
+void requestMidiStatsReset();
+
+// Tempo from incoming MIDI Clock; 0 when no clock is running
+uint32_t getMidiClockQuarterUs();
+float getMidiClockBpm();
+
+#endif // MIDI_INPUT_H
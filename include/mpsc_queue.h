@@ -0,0 +1,73 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Bounded lock-free multi-producer/single-consumer ring. Any task may call
+// push(); exactly one task may call pop(). Each slot's sequence says whether
+// it is free for the producer at that position or holds an item for the
+// consumer. push() never blocks: a full ring returns false.
+// Capacity must be a power of two.
+template <typename T, uint32_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() { clear(); }
+
+    // Consumer side, while no producer is running (setup)
+    void clear() {
+        for (uint32_t i = 0; i < Capacity; ++i) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        _enqueuePos.store(0, std::memory_order_release);
+        _dequeuePos = 0;
+    }
+
+    bool push(const T &item) {
+        uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &_slots[pos & (Capacity - 1)];
+            int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->item = item;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        Slot &slot = _slots[_dequeuePos & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != _dequeuePos + 1) return false;
+        item = slot.item;
+        slot.sequence.store(_dequeuePos + Capacity, std::memory_order_release);
+        ++_dequeuePos;
+        return true;
+    }
+
+    // Items ever accepted by push()
+    uint32_t pushed() const {
+        return _enqueuePos.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        T item;
+    };
+
+    Slot _slots[Capacity];
+    std::atomic<uint32_t> _enqueuePos;
+    uint32_t _dequeuePos;   // Consumer only
+};
+
+#endif // MPSC_QUEUE_H
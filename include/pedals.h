@@ -0,0 +1,71 @@
+#ifndef PEDALS_H
+#define PEDALS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "midi.h" // for MIDI_CONTINUOUS_SLOTS
+
+// Expression pedals on their own ADC pins, sent as Control Change streams.
+// - The ladder sampler reads the pedals every PEDAL_SAMPLE_DIVIDER ticks and
+//   smooths each reading.
+// - The input task then applies the travel calibration, the deadband and
+//   the rate limit. The newest value goes into the pedal's continuous slot
+//   in the MIDI output (see midi.h).
+// A pedal that moves faster than the link can carry therefore costs one
+// message per rate interval, and footswitch messages always go first.
+
+#define PEDAL_COUNT 2
+
+#ifndef EXPRESSION_PEDAL1_PIN
+#define EXPRESSION_PEDAL1_PIN 34
+#endif
+#ifndef EXPRESSION_PEDAL2_PIN
+#define EXPRESSION_PEDAL2_PIN 35
+#endif
+
+#define PEDAL_SAMPLE_DIVIDER 4          // Ladder ticks per pedal read (500 Hz at 2 kHz)
+#define PEDAL_SMOOTHING_SHIFT 3         // Each read moves the smoothed level 1/8 of the way
+#define PEDAL_DEFAULT_DEADBAND 16       // ADC codes
+#define PEDAL_DEFAULT_MAX_RATE_HZ 50
+#define PEDAL_MAX_RATE_HZ 1000
+#define PEDAL_ADC_MAX 4095
+#define PEDAL_CONFIG_VERSION 1
+
+// Global, like the bank navigation switches: pedals do not change with the bank
+struct PedalConfig {
+    uint8_t enabled;          // Off by default: an unconnected input floats
+    uint8_t channel;          // 1-16
+    uint8_t cc;               // 0-119; 0-31 for 14-bit pedals, whose LSB goes on cc + 32
+    uint8_t highResolution;   // 14-bit MSB/LSB pair instead of one 7-bit CC
+    uint8_t invert;
+    uint16_t minLevel;        // ADC code at heel down
+    uint16_t maxLevel;        // ADC code at toe down
+    uint16_t deadband;        // ADC codes the level must move before a new value is sent
+    uint16_t maxRateHz;       // Messages per second, at most
+};
+
+struct PedalStats {
+    uint16_t level;           // Smoothed ADC reading
+    uint16_t value;           // Last value sent (0-127, or 0-16383 for 14-bit)
+    uint32_t messages;        // Values handed to the MIDI output
+    uint32_t rateLimited;     // Changes held back by the rate limit
+};
+
+static_assert(PEDAL_COUNT <= MIDI_CONTINUOUS_SLOTS, "one continuous slot per pedal");
+
+extern PedalStats pedalStats[PEDAL_COUNT];
+
+// Arduino loop: configuration
+void initializePedals();
+void writePedalsJson(JsonArray pedals);
+// Apply the keys present in each {"id": n, ...} object. Returns false (and
+// changes nothing) if an entry is invalid.
+bool applyPedalsConfig(JsonArrayConst pedals, char *error, size_t errorSize);
+
+// Ladder sampler task
+void samplePedals();
+
+// Input task
+void servicePedals(uint32_t nowUs);
+
+#endif // PEDALS_H
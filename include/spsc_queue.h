@@ -0,0 +1,67 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer ring buffer.
+// Exactly one task may call push() and exactly one task may call pop().
+// Capacity must be a power of two; one slot is never used so that
+// head == tail always means empty.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    // Producer side. Returns false if the queue is full.
+    bool push(const T &item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (Capacity - 1);
+        if (next == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _items[head] = item;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side. Pushes all items or none, so the consumer never sees
+    // part of a block. Returns false if they do not fit.
+    bool pushAll(const T *items, size_t count) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t used = (head - _tail.load(std::memory_order_acquire)) & (Capacity - 1);
+        if (count > Capacity - 1 - used) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            _items[(head + i) & (Capacity - 1)] = items[i];
+        }
+        _head.store((head + count) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool pop(T &item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail];
+        _tail.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+    }
+
+private:
+    T _items[Capacity];
+    std::atomic<size_t> _head;
+    std::atomic<size_t> _tail;
+};
+
+#endif // SPSC_QUEUE_H
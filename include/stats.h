@@ -0,0 +1,39 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Fixed-bucket latency histograms. Buckets are log-linear: values below 4 us
+// get their own bucket, above that each power of two is split into four, so
+// every bucket is within 25% of its neighbours up to ~30 s.
+#define STATS_BUCKETS 96
+
+enum StatsHistogramId : uint8_t {
+    HIST_EDGE_TO_ACCEPT,      // Ladder ADC edge -> debounce acceptance (input task)
+    HIST_ACCEPT_TO_ENQUEUE,   // Acceptance -> MIDI bytes queued (input task)
+    HIST_ENQUEUE_TO_WIRE,     // Queued -> last byte out of Serial2 (input task)
+    HIST_EDGE_TO_WIRE,        // Whole press-to-MIDI path (input task)
+    HIST_LOOP_PERIOD,         // Arduino loop iteration (loop)
+    HIST_REDRAW,              // One display event handled (display task)
+    HIST_UART_PARSE,          // deserializeJson of one command (loop)
+    HIST_EVENT_DELIVERY,      // Host event -> its line written to the UART (loop)
+    HIST_COUNT
+};
+
+// Each histogram has exactly one writing task; readers may see a sample
+// half-recorded, which only matters to the last digit.
+struct LatencyHistogram {
+    uint32_t buckets[STATS_BUCKETS];
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    std::atomic<bool> resetPending;   // Set by resetStats(), honoured by the writer
+};
+
+void recordLatency(StatsHistogramId id, uint32_t us);
+void resetStats();
+void sendStats();
+
+#endif // STATS_H
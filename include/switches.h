@@ -7,6 +7,12 @@
 // Debounce delay (ms)
 #define DEBOUNCE_DELAY 50
 
+// Input task: ladder scanning and MIDI output, pinned away from the display task
+#define INPUT_TASK_CORE 1
+#define INPUT_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define INPUT_TASK_STACK_SIZE 4096
+#define INPUT_TASK_PERIOD_MS 1    // Upper bound on wake interval when no samples arrive
+
 // Footswitch pin array and state tracking
 // extern const int FOOTSWITCH_PINS[NUM_FOOTSWITCHES];
 // extern bool footswitchStates[NUM_FOOTSWITCHES];
@@ -14,20 +20,16 @@
 // extern unsigned long lastDebounceTime[NUM_FOOTSWITCHES];
 
 extern int lastPressedFootswitch;
-extern unsigned long lastDebounceTime;
-extern int currentSelectedFootswitch;
-extern bool isConfiguring;
-extern unsigned long configuringStartTime;
+extern uint32_t lastEdgeTimeUs;       // Timestamp of the last classification change
+extern uint32_t lastAcceptedEdgeUs;   // Edge timestamp of the last accepted press
 
 // Track currently selected footswitch (-1 if none)
 extern int currentSelectedFootswitch;
 
-// Track configuring state and timer
-extern bool isConfiguring;
-extern unsigned long configuringStartTime;
-
 // Functions
 void initializeFootswitchPins();
 void handleFootswitches();
+void runInputPass();
+void startInputTask();
 
 #endif // SWITCHES_H
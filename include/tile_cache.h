@@ -0,0 +1,45 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <Arduino.h>
+#include "MultiTFT.hpp"
+#include "midi.h"
+
+// Pre-rendered footswitch tiles. A tile is rasterized once into a 4-bit
+// palette sprite (background, border, text) when its switch changes; every
+// later draw of the same content is a single blit. The normal and the
+// selected (highlighted) look of each switch are cached separately.
+//
+// Sprites come from PSRAM when the board has it, otherwise from the heap
+// within TILE_CACHE_BUDGET_BYTES. When the budget is spent the least
+// recently used sprite is freed; a tile that still does not fit is drawn
+// directly, as before the cache existed. Display task only.
+
+#ifndef TILE_CACHE_BUDGET_BYTES
+#define TILE_CACHE_BUDGET_BYTES (80 * 1024)          // Internal heap, no PSRAM
+#endif
+#define TILE_CACHE_PSRAM_BUDGET_BYTES (256 * 1024)
+#define TILE_CACHE_HEAP_RESERVE_BYTES (40 * 1024)    // Keep this much of the largest heap block free
+#define TILE_SELECTED_BORDER 4                       // Highlight frame width of the selected tile
+
+enum TileVariant : uint8_t {
+    TILE_VARIANT_NORMAL,
+    TILE_VARIANT_SELECTED,
+    TILE_VARIANT_COUNT
+};
+
+struct TileCacheStats {
+    uint32_t budgetBytes;
+    uint32_t usedBytes;
+    uint32_t hits;        // Draws served by a blit of an up-to-date sprite
+    uint32_t renders;     // Tiles rasterized into a sprite
+    uint32_t evictions;   // Sprites freed to make room for another
+    uint32_t fallbacks;   // Draws done directly for lack of memory
+};
+
+extern TileCacheStats tileCacheStats;
+
+void initializeTileCache(MultiTFT &display, int16_t tileWidth, int16_t tileHeight);
+void drawFootswitchTile(int slot, int x, int y, const FootswitchConfig &fs, bool selected);
+
+#endif // TILE_CACHE_H
@@ -0,0 +1,55 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "ladder.h"
+
+// Input trace recorder: captures what the firmware was fed so a session can
+// be replayed on the host against virtual time (test/test_trace).
+// - Ladder stream: every filtered sample the sampler task queues for the
+//   input task, as {time since the previous sample, value}.
+// - UART stream: every JSON command line the loop handles, except the
+//   trace commands themselves, as {time, length, bytes}.
+// Recording stops by itself when either buffer is full. The dump is one
+// header line, the streams as hex chunks and an end line; serviceTrace()
+// writes them only as fast as the host UART takes them without blocking.
+
+#ifndef TRACE_LADDER_SAMPLES
+#define TRACE_LADDER_SAMPLES 4096      // ~2 s at 2 kHz, 4 bytes each
+#endif
+#ifndef TRACE_UART_BYTES
+#define TRACE_UART_BYTES 4096
+#endif
+#define TRACE_VERSION 1
+#define TRACE_GAP_VALUE 0xFFFF         // Ladder entry that only advances time (gaps over 65535 us)
+#define TRACE_DUMP_CHUNK 24            // Stream bytes per dump line; the line fits the UART FIFO
+
+struct TraceLadderEntry {
+    uint16_t dtUs;      // Since the previous entry (or since the start)
+    uint16_t value;     // Filtered ADC code, or TRACE_GAP_VALUE
+};
+
+// Set while recording; the sampler task checks it before anything else
+extern std::atomic<bool> traceRecording;
+
+void recordTraceSample(const LadderSample &sample);
+
+// Sampler task
+inline void traceLadderSample(const LadderSample &sample) {
+    if (traceRecording.load(std::memory_order_relaxed)) recordTraceSample(sample);
+}
+
+// Arduino loop
+void traceUartCommand(const char *command, size_t length);
+bool startTrace();
+void stopTrace();
+bool startTraceDump();
+void sendTraceStatus();
+void serviceTrace();
+
+// Checksum of what the active bank's switches send, so a replay can tell
+// it runs against the configuration the trace was recorded with
+uint16_t traceConfigCrc();
+
+#endif // TRACE_H
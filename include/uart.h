@@ -3,9 +3,23 @@
 
 #include <Arduino.h>
 
+// Longest accepted command line (bytes, excluding the newline)
+#define UART_MAX_LINE_LENGTH 2048
+
+// Static parse pool for one command document
+#define JSON_COMMAND_ARENA_SIZE 8192
+
+struct UartStats {
+    uint32_t commands;        // Lines handed to the dispatcher
+    uint32_t lineOverflows;   // Lines dropped for exceeding UART_MAX_LINE_LENGTH
+    uint32_t parseFailures;   // Lines that were not valid JSON or did not fit the pool
+};
+
+extern UartStats uartStats;
+
 void uart_init(unsigned long baudRate = 115200);
 void uart_loop();
-void processUartCommand(String command);
+void processUartCommand(const char *command, size_t length);
 
 
 #endif // UART_H
@@ -4,10 +4,20 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "midi.h"  // For color definitions
+#include "json_arena.h"
 
 // LED pin for feedback
 extern const int LED_PIN;
 
+// Longest single log line written by printJsonLog (longer messages are truncated)
+#define JSON_LOG_MAX_LENGTH 256
+
+// Static pool for response documents built on the Arduino loop
+#define JSON_RESPONSE_ARENA_SIZE 4096
+
+// Patterns that can wait behind the one currently playing
+#define LED_QUEUE_SIZE 4
+
 // Blink patterns for commands
 enum BlinkType {
     BLINK_GET_CONFIG,
@@ -17,10 +27,18 @@ enum BlinkType {
     BLINK_ERROR
 };
 
-// Utility function declarations
-void printJsonLog(const String &type, const String &message);
+// Utility function declarations.
+// printJsonLog writes to the host UART at once: Arduino loop only. Other tasks
+// use the deferred LOG_* macros from log.h.
+void printJsonLog(const char *type, const char *message);
+void printJsonLogf(const char *type, const char *format, ...);
 void blinkLed(BlinkType type);
-uint16_t hexStringToColor(const String &hexStr);
-String colorToHexString(uint16_t color);
+void updateLed();
+uint16_t hexStringToColor(const char *hexStr);
+void colorToHexString(uint16_t color, char hexStr[8]);
+uint16_t crc16Ccitt(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF);
+
+// Allocator for JSON responses (get_config, stats); Arduino loop only
+extern JsonArena responseArena;
 
 #endif // UTILS_H
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef HOST_MOCKS_ARDUINO_H
+#define HOST_MOCKS_ARDUINO_H
+
+// Host build of the Arduino-ESP32 core API surface used by the firmware.
+// Time is the host's monotonic clock or a virtual one; GPIO and ADC are plain arrays that
+// tests set through mock_hal.h; FreeRTOS tasks are never started.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "WString.h"
+#include "HardwareSerial.h"
+#include "freertos_mock.h"
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define IRAM_ATTR
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+int64_t esp_timer_get_time();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+// Hardware timers are accepted and never fire
+typedef struct hw_timer_s hw_timer_t;
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+
+// No heap accounting on the host; figures are the ESP32's nominal values
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 300000; }
+    uint32_t getMinFreeHeap() { return 300000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+};
+
+extern EspClass ESP;
+
+// The host build models a board without PSRAM
+bool psramFound();
+
+#endif // HOST_MOCKS_ARDUINO_H
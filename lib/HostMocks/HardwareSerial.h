@@ -0,0 +1,118 @@
+#ifndef HOST_MOCKS_HARDWARE_SERIAL_H
+#define HOST_MOCKS_HARDWARE_SERIAL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <string>
+#include "WString.h"
+
+#define SERIAL_8N1 0x800001c
+
+int64_t esp_timer_get_time();
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t byte) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        for (size_t i = 0; i < size; ++i) write(buffer[i]);
+        return size;
+    }
+    size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+
+    size_t print(const char *text) { return write(text); }
+    size_t print(const String &text) { return write(text.c_str()); }
+    size_t print(long value) { return write(std::to_string(value).c_str()); }
+    size_t print(unsigned long value) { return write(std::to_string(value).c_str()); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &value) { return print(value) + println(); }
+
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Both directions are plain buffers: tests feed rx and inspect tx.
+// Writes never block; availableForWrite() reports an empty TX FIFO unless
+// txByteTimeUs is set, in which case the FIFO fills with writes and drains
+// one byte per txByteTimeUs of (virtual) time, like the wire would.
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int port) : _port(port), _baudRate(0) {}
+
+    void begin(unsigned long baudRate, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {
+        (void)config; (void)rxPin; (void)txPin;
+        _baudRate = baudRate;
+    }
+    void end() {}
+    operator bool() const { return true; }
+
+    size_t write(uint8_t byte) override { return write(&byte, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        tx.append((const char *)buffer, size);
+        if (txByteTimeUs != 0) {
+            drainFifo();
+            _fifoLevel += size;
+        }
+        return size;
+    }
+    using Print::write;
+
+    int available() override { return (int)rx.size(); }
+    int read() override {
+        if (rx.empty()) return -1;
+        uint8_t byte = rx.front();
+        rx.pop_front();
+        return byte;
+    }
+    int peek() override { return rx.empty() ? -1 : rx.front(); }
+    int availableForWrite() override {
+        if (txByteTimeUs == 0) return txFifoSize;
+        drainFifo();
+        return _fifoLevel < (uint32_t)txFifoSize ? txFifoSize - (int)_fifoLevel : 0;
+    }
+
+    unsigned long baudRate() const { return _baudRate; }
+
+    // Host side of the port
+    void feed(const char *text) { feed((const uint8_t *)text, strlen(text)); }
+    void feed(const uint8_t *bytes, size_t length) { rx.insert(rx.end(), bytes, bytes + length); }
+
+    std::deque<uint8_t> rx;
+    std::string tx;
+    int txFifoSize = 128;
+    uint32_t txByteTimeUs = 0;
+
+private:
+    void drainFifo() {
+        int64_t now = esp_timer_get_time();
+        uint64_t sent = (uint64_t)(now - _drainedUs) / txByteTimeUs;
+        if (sent >= _fifoLevel) {
+            _fifoLevel = 0;
+            _drainedUs = now;
+        } else {
+            _fifoLevel -= (uint32_t)sent;
+            _drainedUs += (int64_t)(sent * txByteTimeUs);
+        }
+    }
+
+    int _port;
+    unsigned long _baudRate;
+    uint32_t _fifoLevel = 0;
+    int64_t _drainedUs = 0;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+#endif // HOST_MOCKS_HARDWARE_SERIAL_H
@@ -0,0 +1,83 @@
+#include "MultiTFT.hpp"
+
+// CASET + RASET + RAMWR: 3 command bytes and 8 parameter bytes per window
+static const uint32_t WINDOW_OVERHEAD_BYTES = 11;
+
+// Native panel geometry (portrait)
+static const int16_t PANEL_WIDTH = 320;
+static const int16_t PANEL_HEIGHT = 480;
+
+MultiTFT::MultiTFT(uint8_t csPin) : TFT_eSPI(PANEL_WIDTH, PANEL_HEIGHT), _csPin(csPin) {}
+
+void MultiTFT::begin(uint8_t rotation) {
+    pinMode(_csPin, OUTPUT);
+    bool landscape = rotation & 1;
+    _width = landscape ? PANEL_HEIGHT : PANEL_WIDTH;
+    _height = landscape ? PANEL_WIDTH : PANEL_HEIGHT;
+    _framebuffer.assign((size_t)_width * _height, 0);
+    deselect();
+}
+
+void MultiTFT::select() {
+    digitalWrite(_csPin, LOW);
+    _selected = true;
+    ++_selectCount;
+}
+
+void MultiTFT::deselect() {
+    digitalWrite(_csPin, HIGH);
+    _selected = false;
+}
+
+void MultiTFT::countWindow(int32_t w, int32_t h) {
+    if (w <= 0 || h <= 0) return;
+    _bytesPushed += WINDOW_OVERHEAD_BYTES + (uint32_t)w * (uint32_t)h * 2;
+    _pixelsWritten += (uint32_t)w * (uint32_t)h;
+}
+
+void MultiTFT::fillClipped(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+    int32_t x0 = max<int32_t>(x, 0), y0 = max<int32_t>(y, 0);
+    int32_t x1 = min<int32_t>(x + w, _width), y1 = min<int32_t>(y + h, _height);
+    for (int32_t row = y0; row < y1; ++row) {
+        std::fill(_framebuffer.begin() + (size_t)row * _width + x0,
+                  _framebuffer.begin() + (size_t)row * _width + x1, color);
+    }
+}
+
+void MultiTFT::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    countWindow(1, 1);
+    fillClipped(x, y, 1, 1, color);
+}
+
+void MultiTFT::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+    countWindow(1, h);
+    fillClipped(x, y, 1, h, color);
+}
+
+void MultiTFT::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+    countWindow(w, 1);
+    fillClipped(x, y, w, 1, color);
+}
+
+void MultiTFT::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    countWindow(w, h);
+    fillClipped(x, y, w, h, color);
+}
+
+void MultiTFT::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+    int32_t x0 = max<int32_t>(x, 0), x1 = min<int32_t>(x + w, _width);
+    for (int32_t row = max<int32_t>(y, 0); row < min<int32_t>(y + h, _height) && x0 < x1; ++row) {
+        std::copy(data + (size_t)(row - y) * w + (x0 - x), data + (size_t)(row - y) * w + (x1 - x),
+                  _framebuffer.begin() + (size_t)row * _width + x0);
+    }
+}
+
+void MultiTFT::pushSprite(TFT_eSprite &sprite, int32_t x, int32_t y) {
+    countWindow(sprite.width(), sprite.height());
+    sprite.pushSprite(x, y);
+}
+
+uint16_t MultiTFT::pixel(int32_t x, int32_t y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+    return _framebuffer[(size_t)y * _width + x];
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <vector>
+
+// Framebuffer-backed MultiTFT for host builds. Drawing lands in an RGB565
+// buffer the size of the rotated panel, and SPI traffic is counted the same
+// way as on the device (address window + pixel data per primitive).
+class MultiTFT : public TFT_eSPI {
+public:
+    MultiTFT(uint8_t csPin);
+
+    void begin(uint8_t rotation = 1);
+
+    void select();
+    void deselect();
+
+    void drawPixel(int32_t x, int32_t y, uint32_t color) override;
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) override;
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) override;
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) override;
+
+    // Blit a sprite created with this panel as its parent: one window
+    void pushSprite(TFT_eSprite &sprite, int32_t x, int32_t y);
+
+    // No DMA on the host; every push completes before it returns
+    bool dmaEnabled() const { return false; }
+
+    // Approximate bytes pushed over SPI (address window + pixel data)
+    uint32_t bytesPushed() const { return _bytesPushed; }
+    void resetBytesPushed() { _bytesPushed = 0; }
+
+    // Host only: pixels written since the last reset, and the framebuffer
+    uint32_t pixelsWritten() const { return _pixelsWritten; }
+    void resetPixelsWritten() { _pixelsWritten = 0; }
+    uint16_t pixel(int32_t x, int32_t y) const;
+    const std::vector<uint16_t> &framebuffer() const { return _framebuffer; }
+    bool isSelected() const { return _selected; }
+    uint32_t selectCount() const { return _selectCount; }
+
+private:
+    void countWindow(int32_t w, int32_t h);
+    void fillClipped(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+
+    uint8_t _csPin;
+    bool _selected = false;
+    uint32_t _selectCount = 0;
+    std::vector<uint16_t> _framebuffer;
+    uint32_t _bytesPushed = 0;
+    uint32_t _pixelsWritten = 0;
+};
@@ -0,0 +1,102 @@
+#include "mock_hal.h"
+#include <map>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t> > Namespace;
+
+static std::map<std::string, Namespace> store;
+static uint32_t bytesWritten = 0;
+static bool flashFull = false;
+
+// NVS limits keys to 15 characters
+static const size_t KEY_MAX_LENGTH = 15;
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partitionLabel) {
+    (void)partitionLabel;
+    if (_open) return false;
+    // Like nvs_open: a read-only open of a namespace never written fails
+    if (readOnly && store.find(name) == store.end()) return false;
+    _namespace = name;
+    _readOnly = readOnly;
+    _open = true;
+    if (!readOnly) store[_namespace];
+    return true;
+}
+
+void Preferences::end() {
+    _open = false;
+}
+
+bool Preferences::clear() {
+    if (!_open || _readOnly) return false;
+    store[_namespace].clear();
+    return true;
+}
+
+bool Preferences::remove(const char *key) {
+    if (!_open || _readOnly) return false;
+    return store[_namespace].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char *key) {
+    if (!_open) return false;
+    const Namespace &ns = store[_namespace];
+    return ns.find(key) != ns.end();
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length) {
+    if (!_open || _readOnly || key == NULL || strlen(key) > KEY_MAX_LENGTH) return 0;
+    if (flashFull) return 0;
+    const uint8_t *bytes = (const uint8_t *)value;
+    store[_namespace][key].assign(bytes, bytes + length);
+    bytesWritten += length;
+    return length;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+    if (!_open) return 0;
+    const Namespace &ns = store[_namespace];
+    Namespace::const_iterator it = ns.find(key);
+    return it == ns.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLength) {
+    size_t length = getBytesLength(key);
+    if (length == 0 || buffer == NULL || length > maxLength) return 0;
+    memcpy(buffer, store[_namespace][key].data(), length);
+    return length;
+}
+
+// Strings are stored with their terminator, as nvs_set_str does
+size_t Preferences::putString(const char *key, const char *value) {
+    return putBytes(key, value, strlen(value) + 1) ? strlen(value) : 0;
+}
+
+size_t Preferences::putString(const char *key, const String &value) {
+    return putString(key, value.c_str());
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLength) {
+    return getBytes(key, value, maxLength);
+}
+
+String Preferences::getString(const char *key, const String &defaultValue) {
+    size_t length = getBytesLength(key);
+    if (length == 0) return defaultValue;
+    std::vector<char> text(length);
+    getBytes(key, text.data(), length);
+    return String(text.data());
+}
+
+void mockClearPreferences() {
+    store.clear();
+    bytesWritten = 0;
+}
+
+uint32_t mockPreferencesBytesWritten() {
+    return bytesWritten;
+}
+
+void mockSetPreferencesFull(bool full) {
+    flashFull = full;
+}
@@ -0,0 +1,34 @@
+#ifndef HOST_MOCKS_PREFERENCES_H
+#define HOST_MOCKS_PREFERENCES_H
+
+#include <Arduino.h>
+
+// NVS stand-in: namespaces of byte blobs held in process memory.
+// Contents survive end()/begin() like flash; mockClearPreferences() erases them.
+class Preferences {
+public:
+    Preferences() : _open(false), _readOnly(false) {}
+
+    bool begin(const char *name, bool readOnly = false, const char *partitionLabel = NULL);
+    void end();
+
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putBytes(const char *key, const void *value, size_t length);
+    size_t getBytes(const char *key, void *buffer, size_t maxLength);
+    size_t getBytesLength(const char *key);
+
+    size_t putString(const char *key, const char *value);
+    size_t putString(const char *key, const String &value);
+    size_t getString(const char *key, char *value, size_t maxLength);
+    String getString(const char *key, const String &defaultValue = String());
+
+private:
+    std::string _namespace;
+    bool _open;
+    bool _readOnly;
+};
+
+#endif // HOST_MOCKS_PREFERENCES_H
@@ -0,0 +1,6 @@
+#ifndef HOST_MOCKS_SPI_H
+#define HOST_MOCKS_SPI_H
+
+#include <Arduino.h>
+
+#endif // HOST_MOCKS_SPI_H
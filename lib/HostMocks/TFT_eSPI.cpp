@@ -0,0 +1,81 @@
+#include "TFT_eSPI.h"
+
+// TFT_eSPI's default 16-colour palette
+static const uint16_t DEFAULT_PALETTE[16] = {
+    0x0000, 0x000F, 0x03E0, 0x03EF, 0x7800, 0x780F, 0x7BE0, 0xC618,
+    0x7BEF, 0x001F, 0x07E0, 0x07FF, 0xF800, 0xF81F, 0xFFE0, 0xFFFF
+};
+
+// As TFT_eSPI: four lines, the vertical ones one pixel shorter at each end
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y + 1, h - 2, color);
+    drawFastVLine(x + w - 1, y + 1, h - 2, color);
+}
+
+int16_t TFT_eSPI::drawString(const char *text, int32_t x, int32_t y) {
+    int32_t width = textWidth(text);
+    int32_t height = fontHeight();
+
+    // Datums are numbered row by row: top, middle, bottom x left, centre, right
+    x -= (_textDatum % 3) * width / 2;
+    y -= (_textDatum / 3) * height / 2;
+
+    for (const char *c = text; *c != '\0'; ++c, x += 6 * _textSize) {
+        for (int gy = 0; gy < 7; ++gy) {
+            for (int gx = 0; gx < 5; ++gx) {
+                fillRect(x + gx * _textSize, y + gy * _textSize, _textSize, _textSize, _textColor);
+            }
+        }
+    }
+    return (int16_t)width;
+}
+
+void *TFT_eSprite::setColorDepth(int8_t depth) {
+    _depth = (depth == 4) ? 4 : 16;
+    return NULL;
+}
+
+void *TFT_eSprite::createSprite(int16_t width, int16_t height, uint8_t frames) {
+    (void)frames;
+    if (width <= 0 || height <= 0) return NULL;
+    _width = width;
+    _height = height;
+    _pixels.assign((size_t)width * height, 0);
+    memcpy(_palette, DEFAULT_PALETTE, sizeof(_palette));
+    return _pixels.data();
+}
+
+void TFT_eSprite::deleteSprite() {
+    _pixels.clear();
+    _pixels.shrink_to_fit();
+    _width = 0;
+    _height = 0;
+}
+
+void TFT_eSprite::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    if (!created()) return;
+    uint16_t value = (_depth == 4) ? (color & 0x0F) : (uint16_t)color;
+    int32_t x0 = max<int32_t>(x, 0), y0 = max<int32_t>(y, 0);
+    int32_t x1 = min<int32_t>(x + w, _width), y1 = min<int32_t>(y + h, _height);
+    for (int32_t row = y0; row < y1; ++row) {
+        std::fill(_pixels.begin() + (size_t)row * _width + x0,
+                  _pixels.begin() + (size_t)row * _width + x1, value);
+    }
+}
+
+uint16_t TFT_eSprite::readPixel(int32_t x, int32_t y) const {
+    if (!created() || x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+    uint16_t value = _pixels[(size_t)y * _width + x];
+    return (_depth == 4) ? _palette[value] : value;
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+    if (!created() || _parent == NULL) return;
+    _image.resize(_pixels.size());
+    for (size_t i = 0; i < _pixels.size(); ++i) {
+        _image[i] = (_depth == 4) ? _palette[_pixels[i]] : _pixels[i];
+    }
+    _parent->pushImage(x, y, _width, _height, _image.data());
+}
@@ -0,0 +1,94 @@
+#ifndef HOST_MOCKS_TFT_ESPI_H
+#define HOST_MOCKS_TFT_ESPI_H
+
+#include <Arduino.h>
+#include <vector>
+
+// TFT_eSPI text datums
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+// The part of TFT_eSPI the firmware draws with. Primitives are virtual as in
+// the library, so MultiTFT and TFT_eSprite decide where pixels go.
+//
+// Text uses the GLCD cell (6x8 per character times text size) and draws
+// every pixel of the 5x7 glyph box as one size x size rectangle, which is
+// how TFT_eSPI renders transparent scaled text. Glyph shapes are not
+// modelled, so text costs a fixed, slightly pessimistic amount per character.
+class TFT_eSPI {
+public:
+    TFT_eSPI(int16_t width = 320, int16_t height = 480) : _width(width), _height(height) {}
+    virtual ~TFT_eSPI() {}
+
+    virtual void drawPixel(int32_t x, int32_t y, uint32_t color) { fillRect(x, y, 1, 1, color); }
+    virtual void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) { fillRect(x, y, 1, h, color); }
+    virtual void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) { fillRect(x, y, w, 1, color); }
+    virtual void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) = 0;
+
+    // Raw RGB565 block, as pushed by a sprite
+    virtual void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+        (void)x; (void)y; (void)w; (void)h; (void)data;
+    }
+
+    void fillScreen(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+
+    void setTextDatum(uint8_t datum) { _textDatum = datum; }
+    void setTextColor(uint16_t color) { _textColor = color; }
+    void setTextColor(uint16_t color, uint16_t background, bool fill = false) { (void)background; (void)fill; _textColor = color; }
+    void setTextSize(uint8_t size) { _textSize = size > 0 ? size : 1; }
+    int16_t drawString(const char *text, int32_t x, int32_t y);
+    int16_t drawString(const String &text, int32_t x, int32_t y) { return drawString(text.c_str(), x, y); }
+    int16_t textWidth(const char *text) const { return (int16_t)(strlen(text) * 6 * _textSize); }
+    int16_t fontHeight() const { return (int16_t)(8 * _textSize); }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+protected:
+    int16_t _width;
+    int16_t _height;
+    uint8_t _textDatum = TL_DATUM;
+    uint16_t _textColor = 0xFFFF;
+    uint8_t _textSize = 1;
+};
+
+// Off-screen sprite at 4 (palette) or 16 bits per pixel. Pixels are kept as
+// one uint16_t each; only the colour depth's bits are stored.
+class TFT_eSprite : public TFT_eSPI {
+public:
+    explicit TFT_eSprite(TFT_eSPI *parent) : TFT_eSPI(0, 0), _parent(parent), _depth(16) {}
+
+    void *setColorDepth(int8_t depth);
+    void *createSprite(int16_t width, int16_t height, uint8_t frames = 1);
+    void deleteSprite();
+    bool created() const { return !_pixels.empty(); }
+
+    void setPaletteColor(uint8_t index, uint16_t color) { _palette[index & 0x0F] = color; }
+    uint16_t getPaletteColor(uint8_t index) const { return _palette[index & 0x0F]; }
+
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+    void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+
+    // RGB565 value of a pixel (palette applied)
+    uint16_t readPixel(int32_t x, int32_t y) const;
+
+    // Draw onto the parent as one block
+    void pushSprite(int32_t x, int32_t y);
+
+private:
+    TFT_eSPI *_parent;
+    int8_t _depth;
+    uint16_t _palette[16];
+    std::vector<uint16_t> _pixels;
+    std::vector<uint16_t> _image;   // RGB565 staging for pushSprite, kept so blits do not allocate
+};
+
+#endif // HOST_MOCKS_TFT_ESPI_H
@@ -0,0 +1,47 @@
+#ifndef HOST_MOCKS_WSTRING_H
+#define HOST_MOCKS_WSTRING_H
+
+#include <string>
+#include <stdint.h>
+#include <string.h>
+
+// Arduino String over std::string: only the operations the firmware uses
+class String {
+public:
+    String() {}
+    String(const char *text) : _s(text ? text : "") {}
+    String(const std::string &text) : _s(text) {}
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char value) : _s(std::to_string(value)) {}
+    explicit String(int value) : _s(std::to_string(value)) {}
+    explicit String(unsigned int value) : _s(std::to_string(value)) {}
+    explicit String(long value) : _s(std::to_string(value)) {}
+    explicit String(unsigned long value) : _s(std::to_string(value)) {}
+
+    size_t length() const { return _s.size(); }
+    const char *c_str() const { return _s.c_str(); }
+    char operator[](size_t index) const { return index < _s.size() ? _s[index] : '\0'; }
+    String substring(size_t from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(size_t from, size_t to) const {
+        return from < to && from < _s.size() ? String(_s.substr(from, to - from)) : String();
+    }
+
+    bool concat(const char *text) { _s += text ? text : ""; return true; }
+    String &operator+=(const String &other) { _s += other._s; return *this; }
+    String &operator+=(const char *text) { concat(text); return *this; }
+    String &operator+=(char c) { _s += c; return *this; }
+
+    bool operator==(const String &other) const { return _s == other._s; }
+    bool operator!=(const String &other) const { return _s != other._s; }
+    bool operator==(const char *text) const { return _s == (text ? text : ""); }
+    bool operator!=(const char *text) const { return !(*this == text); }
+
+    friend String operator+(const String &a, const String &b) { return String(a._s + b._s); }
+    friend String operator+(const char *a, const String &b) { return String(std::string(a) + b._s); }
+    friend String operator+(const String &a, const char *b) { return String(a._s + b); }
+
+private:
+    std::string _s;
+};
+
+#endif // HOST_MOCKS_WSTRING_H
@@ -0,0 +1,157 @@
+#include "mock_hal.h"
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+EspClass ESP;
+
+static const int GPIO_COUNT = 40;
+static uint8_t pinLevels[GPIO_COUNT];
+static uint16_t analogValues[GPIO_COUNT];
+static uint32_t taskCount = 0;
+
+// Any non-null address serves as a handle
+static int handleStorage;
+struct hw_timer_s { int unused; };
+static hw_timer_t timerStorage;
+
+static std::chrono::steady_clock::time_point bootTime() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return start;
+}
+
+// Set by mockSetMicros(): time stands still until the test moves it
+static bool virtualClock = false;
+static int64_t virtualMicros = 0;
+
+int64_t esp_timer_get_time() {
+    if (virtualClock) return virtualMicros;
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime()).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)esp_timer_get_time();
+}
+
+unsigned long millis() {
+    return (unsigned long)(uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint64_t delayedMicros = 0;
+
+uint64_t mockDelayedMicros() {
+    return delayedMicros;
+}
+
+void delay(uint32_t ms) {
+    delayedMicros += (uint64_t)ms * 1000;
+    if (virtualClock) return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    delayedMicros += us;
+    if (virtualClock) return;
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin; (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < GPIO_COUNT) pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < GPIO_COUNT ? pinLevels[pin] : LOW;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    return pin < GPIO_COUNT ? analogValues[pin] : 0;
+}
+
+void mockSetAnalogValue(uint8_t pin, uint16_t value) {
+    if (pin < GPIO_COUNT) analogValues[pin] = value & 0x0FFF;
+}
+
+bool psramFound() {
+    return false;
+}
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    (void)num; (void)divider; (void)countUp;
+    return &timerStorage;
+}
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge) {
+    (void)timer; (void)fn; (void)edge;
+}
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarmValue, bool autoreload) {
+    (void)timer; (void)alarmValue; (void)autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t *timer) {
+    (void)timer;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackDepth,
+                                   void *parameter, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core) {
+    (void)task; (void)name; (void)stackDepth; (void)parameter; (void)priority; (void)core;
+    if (handle != NULL) *handle = &handleStorage;
+    ++taskCount;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    (void)clearOnExit; (void)ticksToWait;
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken) {
+    (void)task;
+    if (higherPriorityTaskWoken != NULL) *higherPriorityTaskWoken = pdFALSE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return &handleStorage;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    (void)semaphore; (void)ticksToWait;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    (void)semaphore;
+    return pdTRUE;
+}
+
+uint32_t mockTaskCount() {
+    return taskCount;
+}
+
+void mockSetMicros(int64_t us) {
+    virtualClock = true;
+    virtualMicros = us;
+}
+
+void mockUseRealClock() {
+    virtualClock = false;
+}
+
+void mockResetSerial() {
+    Serial.rx.clear();
+    Serial.tx.clear();
+    Serial2.rx.clear();
+    Serial2.tx.clear();
+}
@@ -0,0 +1,37 @@
+#ifndef HOST_MOCKS_MOCK_HAL_H
+#define HOST_MOCKS_MOCK_HAL_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// Test-side controls for the host HAL
+
+// Value returned by analogRead(pin) until changed
+void mockSetAnalogValue(uint8_t pin, uint16_t value);
+
+// Erase every Preferences namespace
+void mockClearPreferences();
+
+// Bytes written through Preferences::put* since the last clear (flash wear proxy)
+uint32_t mockPreferencesBytesWritten();
+
+// While set, every Preferences::put* fails as on a full NVS partition
+void mockSetPreferencesFull(bool full);
+
+// Tasks registered with xTaskCreatePinnedToCore (none of them run)
+uint32_t mockTaskCount();
+
+// Virtual clock: from the first call, esp_timer_get_time(), micros() and
+// millis() return the time set here and delay() returns at once, so a test
+// decides exactly when everything happens. mockUseRealClock() goes back.
+void mockSetMicros(int64_t us);
+void mockUseRealClock();
+
+// Total time requested through delay() and delayMicroseconds(), in either
+// clock mode: a path that must not block can be checked to add nothing
+uint64_t mockDelayedMicros();
+
+// Clear both serial ports' buffers
+void mockResetSerial();
+
+#endif // HOST_MOCKS_MOCK_HAL_H
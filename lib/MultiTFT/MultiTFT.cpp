@@ -1,27 +1,112 @@
 #include "MultiTFT.hpp"
 #include <SPI.h>
+#include "SpriteChunks.hpp"
+
+// CASET + RASET + RAMWR: 3 command bytes and 8 parameter bytes per window
+static const uint32_t WINDOW_OVERHEAD_BYTES = 11;
+
+// Sprite chunks in panel byte order. While one buffer streams the other is
+// being filled; the bus carries one transfer at a time so all panels share them.
+static uint16_t dmaBuffers[2][MULTITFT_DMA_BUFFER_PIXELS];
+
+// initDMA() adds the DMA device to the shared SPI host and aborts the
+// firmware (ESP_ERROR_CHECK) when called a second time, so the first panel
+// claims it and the others share it
+enum BusDmaState : int8_t { BUS_DMA_UNTRIED, BUS_DMA_READY, BUS_DMA_UNAVAILABLE };
+static BusDmaState busDma = BUS_DMA_UNTRIED;
 
 MultiTFT::MultiTFT(uint8_t csPin) 
     : TFT_eSPI(), _csPin(csPin) {}
 
 void MultiTFT::begin(uint8_t rotation) {
     pinMode(_csPin, OUTPUT);
-    select();
+    // init() brings up the SPI bus, so no transaction can be opened before it
+    digitalWrite(_csPin, LOW);
     init();
     setRotation(rotation);
-    deselect();
+    digitalWrite(_csPin, HIGH);
+    // Without DMA every panel falls back to blocking pushes
+    if (busDma == BUS_DMA_UNTRIED) {
+        busDma = initDMA() ? BUS_DMA_READY : BUS_DMA_UNAVAILABLE;
+    } else if (busDma == BUS_DMA_READY) {
+        // TFT_eSPI keeps the DMA device in one global handle; this instance
+        // only needs its own flag, which gates pushPixelsDMA() and dmaWait()
+        DMA_Enabled = true;
+    }
+    _dmaEnabled = busDma == BUS_DMA_READY;
 }
 
 void MultiTFT::select() {
+    startWrite();
     digitalWrite(_csPin, LOW);
-    delayMicroseconds(10);
 }
 
+// endWrite() waits for the SPI FIFO to drain, so CS rises after the last bit
 void MultiTFT::deselect() {
-    delay(1);
+    waitTransfer();
+    endWrite();
     digitalWrite(_csPin, HIGH);
 }
 
 TFT_eSPI* MultiTFT::raw() {
     return static_cast<TFT_eSPI*>(this);
-}
\ No newline at end of file
+}
+
+void MultiTFT::waitTransfer() {
+    if (_dmaEnabled) dmaWait();
+}
+
+void MultiTFT::countWindow(int32_t w, int32_t h) {
+    if (w <= 0 || h <= 0) return;
+    _bytesPushed += WINDOW_OVERHEAD_BYTES + (uint32_t)w * (uint32_t)h * 2;
+}
+
+// CPU-driven primitives must not start while a DMA chunk is on the wire
+
+void MultiTFT::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    countWindow(1, 1);
+    waitTransfer();
+    TFT_eSPI::drawPixel(x, y, color);
+}
+
+void MultiTFT::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+    countWindow(1, h);
+    waitTransfer();
+    TFT_eSPI::drawFastVLine(x, y, h, color);
+}
+
+void MultiTFT::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+    countWindow(w, 1);
+    waitTransfer();
+    TFT_eSPI::drawFastHLine(x, y, w, color);
+}
+
+void MultiTFT::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    countWindow(w, h);
+    waitTransfer();
+    TFT_eSPI::fillRect(x, y, w, h, color);
+}
+
+void MultiTFT::pushSprite(TFT_eSprite &sprite, int32_t x, int32_t y) {
+    int32_t w = sprite.width();
+    int32_t h = sprite.height();
+    countWindow(w, h);
+
+    if (!_dmaEnabled || sprite.getColorDepth() != 4 || w > MULTITFT_DMA_BUFFER_PIXELS) {
+        sprite.pushSprite(x, y);
+        return;
+    }
+
+    uint16_t palette[16];
+    for (uint8_t i = 0; i < 16; ++i) palette[i] = sprite.getPaletteColor(i);
+    uint16_t swapped[16];
+    swapPaletteBytes(palette, swapped);
+
+    waitTransfer();
+    setAddrWindow(x, y, w, h);
+    uint16_t *const buffers[2] = {dmaBuffers[0], dmaBuffers[1]};
+    // pushPixelsDMA waits for the previous chunk, which used the other buffer
+    streamSprite4((const uint8_t *)sprite.getPointer(), w, h, swapped, buffers,
+                  MULTITFT_DMA_BUFFER_PIXELS,
+                  [this](uint16_t *chunk, int32_t pixels) { pushPixelsDMA(chunk, pixels); });
+}
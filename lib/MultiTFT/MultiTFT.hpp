@@ -2,19 +2,47 @@
 #include <Arduino.h>
 #include <TFT_eSPI.h>
 
+// Pixels per DMA chunk buffer; two buffers are shared by all panels
+#define MULTITFT_DMA_BUFFER_PIXELS 2048
+
 class MultiTFT : public TFT_eSPI {
 public:
     MultiTFT(uint8_t csPin);
 
     void begin(uint8_t rotation = 1);
 
-    // Public select/deselect for manual CS control
+    // Manual CS control inside an SPI transaction: select() claims the bus
+    // and asserts CS; deselect() waits for any pixel DMA still streaming,
+    // ends the transaction and releases CS. Panels sharing the bus are
+    // scheduled by MultiTFTBus.
     void select();
     void deselect();
 
     // Catch-all passthrough for direct TFT_eSPI access if needed
     TFT_eSPI* raw();
 
+    // Primitive overrides so every pixel written to the panel is accounted for
+    void drawPixel(int32_t x, int32_t y, uint32_t color) override;
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) override;
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) override;
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+
+    // Blit a sprite created with this panel as its parent: one window.
+    // 4-bit sprites are expanded in chunks and streamed by DMA; the call
+    // returns while the last chunk is still on the wire.
+    void pushSprite(TFT_eSprite &sprite, int32_t x, int32_t y);
+
+    bool dmaEnabled() const { return _dmaEnabled; }
+
+    // Approximate bytes pushed over SPI (address window + pixel data)
+    uint32_t bytesPushed() const { return _bytesPushed; }
+    void resetBytesPushed() { _bytesPushed = 0; }
+
 private:
+    void countWindow(int32_t w, int32_t h);
+    void waitTransfer();
+
     uint8_t _csPin;
+    bool _dmaEnabled = false;
+    uint32_t _bytesPushed = 0;
 };
@@ -0,0 +1,98 @@
+#include "MultiTFTBus.hpp"
+
+MultiTFTBus::MultiTFTBus()
+    : _panelCount(0), _next(0), _active(-1), _landingCount(0),
+      _batchesRun(0), _panelSwitches(0) {}
+
+bool MultiTFTBus::attach(MultiTFT &panel) {
+    if (_panelCount >= MULTITFT_BUS_MAX_PANELS || indexOf(panel) >= 0) return false;
+    PanelQueue &queue = _queues[_panelCount++];
+    queue.panel = &panel;
+    queue.head = 0;
+    queue.count = 0;
+    return true;
+}
+
+int MultiTFTBus::indexOf(MultiTFT &panel) const {
+    for (uint8_t i = 0; i < _panelCount; ++i) {
+        if (_queues[i].panel == &panel) return i;
+    }
+    return -1;
+}
+
+void MultiTFTBus::submit(MultiTFT &panel, DrawBatchFn draw, void *context,
+                         BatchDoneFn done, void *doneContext) {
+    int index = indexOf(panel);
+    if (index < 0) return;
+
+    PanelQueue &queue = _queues[index];
+    if (queue.count == MULTITFT_BUS_QUEUE_SIZE) flush();
+
+    Batch &batch = queue.batches[(queue.head + queue.count) % MULTITFT_BUS_QUEUE_SIZE];
+    batch.draw = draw;
+    batch.context = context;
+    batch.done = done;
+    batch.doneContext = doneContext;
+    ++queue.count;
+}
+
+void MultiTFTBus::flush() {
+    for (;;) {
+        // Next panel with work, starting from the one whose turn it is
+        int index = -1;
+        for (uint8_t n = 0; n < _panelCount; ++n) {
+            uint8_t candidate = (_next + n) % _panelCount;
+            if (_queues[candidate].count > 0) {
+                index = candidate;
+                break;
+            }
+        }
+        if (index < 0) break;
+
+        PanelQueue &queue = _queues[index];
+        Batch batch = queue.batches[queue.head];
+        queue.head = (queue.head + 1) % MULTITFT_BUS_QUEUE_SIZE;
+        --queue.count;
+
+        // A marker completes with the batches before it; if the panel is
+        // not selected those have already landed
+        if (batch.draw == NULL) {
+            if (batch.done == NULL) continue;
+            if (_active == index) {
+                _landing[_landingCount++] = batch;
+            } else {
+                batch.done(batch.doneContext);
+            }
+            continue;
+        }
+
+        _next = (index + 1) % _panelCount;
+        activate(index);
+        batch.draw(*queue.panel, batch.context);
+        ++_batchesRun;
+        if (batch.done != NULL) _landing[_landingCount++] = batch;
+    }
+    release();
+}
+
+void MultiTFTBus::activate(int index) {
+    if (_active == index) return;
+    if (_active >= 0) ++_panelSwitches;
+    release();
+    _queues[index].panel->select();
+    _active = index;
+}
+
+// Deselect waits for the last transfer, so the batches drawn since select
+// have landed and their completions can run
+void MultiTFTBus::release() {
+    if (_active < 0) return;
+    _queues[_active].panel->deselect();
+    _active = -1;
+
+    uint8_t count = _landingCount;
+    _landingCount = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        _landing[i].done(_landing[i].doneContext);
+    }
+}
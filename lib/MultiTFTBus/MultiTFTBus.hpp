@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include "MultiTFT.hpp"
+
+#define MULTITFT_BUS_MAX_PANELS 2
+#define MULTITFT_BUS_QUEUE_SIZE 16   // Batches waiting per panel
+
+// A draw batch: a function that draws on one panel. It runs with the panel
+// already selected and must not select or deselect itself.
+typedef void (*DrawBatchFn)(MultiTFT &panel, void *context);
+// Called once everything a batch drew is on the panel
+typedef void (*BatchDoneFn)(void *context);
+
+// Scheduler for panels sharing one SPI bus. Callers queue batches per panel
+// and flush() runs them round-robin, one batch per panel in turn, so a long
+// redraw of one panel holds the other back by at most one batch. Chip select
+// only changes between batches of different panels; consecutive batches on
+// the same panel share one transaction, and pixel DMA from one batch can
+// still be streaming while the CPU prepares the next.
+//
+// Not thread-safe: one task owns the bus.
+class MultiTFTBus {
+public:
+    MultiTFTBus();
+
+    bool attach(MultiTFT &panel);
+
+    // Queue a batch. A full queue is flushed first, so this never drops work.
+    // With no draw function the batch is a marker: its done callback runs
+    // once everything queued before it on the panel has landed, which is
+    // how a caller learns that a frame is complete.
+    void submit(MultiTFT &panel, DrawBatchFn draw, void *context,
+                BatchDoneFn done = NULL, void *doneContext = NULL);
+
+    // Run every queued batch and release the bus
+    void flush();
+
+    uint32_t batchesRun() const { return _batchesRun; }
+    uint32_t panelSwitches() const { return _panelSwitches; }
+
+private:
+    struct Batch {
+        DrawBatchFn draw;
+        void *context;
+        BatchDoneFn done;
+        void *doneContext;
+    };
+
+    struct PanelQueue {
+        MultiTFT *panel;
+        Batch batches[MULTITFT_BUS_QUEUE_SIZE];
+        uint8_t head;
+        uint8_t count;
+    };
+
+    int indexOf(MultiTFT &panel) const;
+    void activate(int index);
+    void release();
+
+    PanelQueue _queues[MULTITFT_BUS_MAX_PANELS];
+    uint8_t _panelCount;
+    uint8_t _next;     // Panel that gets the next turn
+    int _active;       // Selected panel, -1 when the bus is idle
+
+    // Completions of batches drawn on the active panel, run at deselect
+    Batch _landing[MULTITFT_BUS_QUEUE_SIZE * MULTITFT_BUS_MAX_PANELS];
+    uint8_t _landingCount;
+
+    uint32_t _batchesRun;
+    uint32_t _panelSwitches;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+
+// Expansion of packed 4-bit sprites into RGB565 chunks for pixel DMA.
+// It has no TFT_eSPI dependency, so the host build runs the same code as
+// MultiTFT::pushSprite (test/test_sprite_chunks).
+
+// Palette in the panel's big-endian byte order
+inline void swapPaletteBytes(const uint16_t *palette, uint16_t *swapped) {
+    for (uint8_t i = 0; i < 16; ++i) {
+        swapped[i] = (uint16_t)((palette[i] >> 8) | (palette[i] << 8));
+    }
+}
+
+// Expand a w x h sprite, rows packed two pixels per byte with even x in the
+// high nibble, into chunks of whole rows of at most bufferPixels. Chunks
+// alternate between the two buffers and each is handed to send(chunk,
+// pixels). A send that waits for the previous transfer before starting its
+// own (pushPixelsDMA) therefore never has a buffer refilled while it is
+// still on the wire. Returns the number of chunks, 0 if a row does not fit.
+template <typename Send>
+int32_t streamSprite4(const uint8_t *pixels, int32_t w, int32_t h, const uint16_t *palette,
+                      uint16_t *const buffers[2], int32_t bufferPixels, Send send) {
+    if (w <= 0 || h <= 0 || w > bufferPixels) return 0;
+    int32_t stride = (w + 1) / 2;
+    int32_t rowsPerChunk = bufferPixels / w;
+
+    int32_t chunks = 0;
+    uint8_t buffer = 0;
+    for (int32_t row = 0; row < h; row += rowsPerChunk) {
+        int32_t rows = min(rowsPerChunk, h - row);
+        uint16_t *out = buffers[buffer];
+        for (int32_t r = 0; r < rows; ++r) {
+            const uint8_t *in = pixels + (row + r) * stride;
+            for (int32_t col = 0; col < w; ++col) {
+                uint8_t packed = in[col >> 1];
+                *out++ = palette[(col & 1) ? (packed & 0x0F) : (packed >> 4)];
+            }
+        }
+        send(buffers[buffer], rows * w);
+        buffer ^= 1;
+        ++chunks;
+    }
+    return chunks;
+}
@@ -0,0 +1,151 @@
+#include "banks.h"
+#include "config.h"
+#include "display.h"
+#include "utils.h"
+#include "log.h"
+#include "events.h"
+#include <atomic>
+
+static_assert(BANK_COUNT >= 1 && BANK_COUNT <= 32, "Bank residency is a 32-bit mask");
+
+// All banks plus one staging table, contiguous; only resident banks hold
+// valid data. A bank starts in the slot of the same index and moves when a
+// whole-bank update is swapped in (bankTables[bank] is then set).
+static FootswitchConfig bankArena[BANK_COUNT + 1][NUM_FOOTSWITCHES];
+static FootswitchConfig *bankTables[BANK_COUNT];
+static FootswitchConfig *stagingTable = bankArena[BANK_COUNT];
+
+FootswitchConfig *footswitches = bankArena[0];
+
+BankNavConfig bankNav = {BANK_NAV_NONE, BANK_NAV_NONE};
+BankStats bankStats = {0, 0};
+
+static std::atomic<uint8_t> activeBank(0);
+static std::atomic<uint32_t> residentBanks(0);
+static std::atomic<int> deferredBank(-1);   // Requested but not yet resident
+static std::atomic<uint32_t> switchCount(0);
+static unsigned long lastPrefetchTime = 0;
+
+// The boot bank was filled by loadConfigFromFlash()
+void initializeBanks() {
+    residentBanks.store(1u << activeBank.load(), std::memory_order_release);
+    printJsonLogf("info", "Bank store ready: %u banks, %u bytes", (unsigned)BANK_COUNT, (unsigned)sizeof(bankArena));
+}
+
+uint8_t getActiveBank() {
+    return activeBank.load(std::memory_order_acquire);
+}
+
+bool isBankResident(uint8_t bank) {
+    return bank < BANK_COUNT && (residentBanks.load(std::memory_order_acquire) & (1u << bank));
+}
+
+static FootswitchConfig *bankTable(uint8_t bank) {
+    return bankTables[bank] != NULL ? bankTables[bank] : bankArena[bank];
+}
+
+// Fill an arena slot from flash (or defaults) and publish it. Loop only.
+static void loadBank(uint8_t bank) {
+    FootswitchConfig *table = bankTable(bank);
+    if (!loadBankFromFlash(bank, table)) {
+        initializeDefaultConfig(table);
+    }
+    ++bankStats.loads;
+    residentBanks.fetch_or(1u << bank, std::memory_order_release);
+}
+
+FootswitchConfig *getBankSwitches(uint8_t bank) {
+    if (bank >= BANK_COUNT) return NULL;
+    if (!isBankResident(bank)) loadBank(bank);
+    return bankTable(bank);
+}
+
+// Copy of the bank's table in the spare slot, filled by the loop off-lock
+FootswitchConfig *stageBankUpdate(uint8_t bank) {
+    FootswitchConfig *current = getBankSwitches(bank);
+    if (current == NULL) return NULL;
+    memcpy(stagingTable, current, sizeof(bankArena[0]));
+    return stagingTable;
+}
+
+// The staged table becomes the bank's and the one it replaces becomes the
+// next spare: only a pointer changes under the lock, so a press sees the
+// old table or the new one, never a mix
+void publishBankUpdate(uint8_t bank) {
+    FootswitchConfig *previous = bankTable(bank);
+    lockConfig();
+    bankTables[bank] = stagingTable;
+    if (bank == getActiveBank()) footswitches = stagingTable;
+    unlockConfig();
+    stagingTable = previous;
+}
+
+static void activateBank(uint8_t bank, DisplayProducer producer) {
+    lockConfig();
+    footswitches = bankTable(bank);
+    activeBank.store(bank, std::memory_order_release);
+    unlockConfig();
+
+    switchCount.fetch_add(1, std::memory_order_relaxed);
+    postHostEvent(HOST_EVENT_CONFIG, CONFIG_EVENT_BANK, bank, micros());
+    LOG_INFO("info", "Bank %u selected", bank + 1);
+    postDisplayEvent(producer, DISPLAY_EVENT_FOOTSWITCH);
+    postDisplayEvent(producer, DISPLAY_EVENT_CONFIG);
+}
+
+bool selectBank(uint8_t bank, DisplayProducer producer) {
+    if (bank >= BANK_COUNT) return false;
+    if (!isBankResident(bank)) {
+        deferredBank.store(bank, std::memory_order_release);
+        return false;
+    }
+    deferredBank.store(-1, std::memory_order_relaxed);
+    if (bank != getActiveBank()) activateBank(bank, producer);
+    return true;
+}
+
+bool stepBank(int delta, DisplayProducer producer) {
+    int bank = ((int)getActiveBank() + delta) % BANK_COUNT;
+    if (bank < 0) bank += BANK_COUNT;
+    return selectBank(bank, producer);
+}
+
+uint32_t getBankSwitchCount() {
+    return switchCount.load(std::memory_order_relaxed);
+}
+
+int bankNavDirection(int switchId) {
+    if (switchId < 0) return 0;
+    if (switchId == bankNav.prevSwitch) return -1;
+    if (switchId == bankNav.nextSwitch) return 1;
+    return 0;
+}
+
+// Nearest non-resident bank to the active one, or -1 when all are loaded
+static int nextPrefetchBank() {
+    uint32_t resident = residentBanks.load(std::memory_order_acquire);
+    int active = getActiveBank();
+    for (int distance = 1; distance <= BANK_COUNT / 2; ++distance) {
+        int up = (active + distance) % BANK_COUNT;
+        int down = (active - distance + BANK_COUNT) % BANK_COUNT;
+        if (!(resident & (1u << up))) return up;
+        if (!(resident & (1u << down))) return down;
+    }
+    return -1;
+}
+
+void serviceBanks() {
+    int deferred = deferredBank.exchange(-1, std::memory_order_acq_rel);
+    if (deferred >= 0) {
+        getBankSwitches(deferred);
+        ++bankStats.deferredSwitches;
+        if (deferred != getActiveBank()) activateBank(deferred, DISPLAY_PRODUCER_HOST);
+        return;
+    }
+
+    // One flash read per interval keeps the loop responsive while filling the arena
+    if (millis() - lastPrefetchTime < BANK_PREFETCH_INTERVAL_MS) return;
+    lastPrefetchTime = millis();
+    int bank = nextPrefetchBank();
+    if (bank >= 0) loadBank(bank);
+}
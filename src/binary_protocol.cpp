@@ -0,0 +1,538 @@
+#include "binary_protocol.h"
+#include "config.h"
+#include "utils.h"
+#include "switches.h"
+#include "ladder.h"
+#include "display.h"
+#include "banks.h"
+#include <atomic>
+
+BinaryProtocolStats binaryStats = {0, 0, 0, 0, 0, 0};
+
+static volatile bool binaryActive = false;
+
+// Outgoing frames may come from several tasks (logs), so the counter is atomic
+static std::atomic<uint8_t> txSequence(0);
+static uint8_t expectedRxSequence = 0;
+static bool rxSequenceKnown = false;
+
+static_assert(BINARY_HEADER_SIZE + 2 + NUM_FOOTSWITCHES * BINARY_SWITCH_RECORD_MAX + BINARY_CRC_SIZE <= BINARY_MAX_FRAME,
+              "a full switch list must fit in one frame");
+static_assert(NUM_FOOTSWITCHES <= 0xFF && BINARY_MAX_NAME_LENGTH <= 0xFF && MIDI_MAX_ACTIONS <= 0xFF,
+              "switch count, name length and action count are single bytes");
+
+// COBS adds one byte per 254 plus the leading code byte
+static const size_t ENCODED_MAX = BINARY_MAX_FRAME + BINARY_MAX_FRAME / 254 + 2;
+
+static uint8_t rxEncoded[ENCODED_MAX];
+static size_t rxEncodedLength = 0;
+static bool rxOverflowed = false;
+static uint8_t rxFrame[BINARY_MAX_FRAME];
+
+// Responses are built here on the Arduino loop; logs build on their own stack
+static uint8_t txFrame[BINARY_MAX_FRAME];
+
+static size_t cobsEncode(const uint8_t *input, size_t length, uint8_t *output) {
+    size_t read = 0;
+    size_t write = 1;
+    size_t codePos = 0;
+    uint8_t code = 1;
+
+    while (read < length) {
+        if (input[read] == 0) {
+            output[codePos] = code;
+            codePos = write++;
+            code = 1;
+        } else {
+            output[write++] = input[read];
+            if (++code == 0xFF) {
+                output[codePos] = code;
+                codePos = write++;
+                code = 1;
+            }
+        }
+        ++read;
+    }
+    output[codePos] = code;
+    return write;
+}
+
+// Returns decoded length, or 0 on malformed input
+static size_t cobsDecode(const uint8_t *input, size_t length, uint8_t *output, size_t capacity) {
+    size_t read = 0;
+    size_t write = 0;
+
+    while (read < length) {
+        uint8_t code = input[read++];
+        if (code == 0 || read + code - 1 > length) return 0;
+        for (uint8_t i = 1; i < code; ++i) {
+            if (write >= capacity) return 0;
+            output[write++] = input[read++];
+        }
+        if (code != 0xFF && read < length) {
+            if (write >= capacity) return 0;
+            output[write++] = 0;
+        }
+    }
+    return write;
+}
+
+static void putU16(uint8_t *out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static uint16_t getU16(const uint8_t *in) {
+    return (uint16_t)in[0] | ((uint16_t)in[1] << 8);
+}
+
+static void putU32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+// Fill header and CRC around payloadLength bytes already at frame + header,
+// then COBS-encode and write the whole frame with one Serial.write
+static void sendFrame(uint8_t *frame, uint8_t op, uint8_t flags, uint16_t requestId, size_t payloadLength) {
+    frame[0] = BINARY_PROTOCOL_VERSION;
+    frame[1] = op;
+    frame[2] = flags;
+    frame[3] = txSequence.fetch_add(1, std::memory_order_relaxed);
+    putU16(frame + 4, requestId);
+
+    size_t length = BINARY_HEADER_SIZE + payloadLength;
+    putU16(frame + length, crc16Ccitt(frame, length));
+    length += BINARY_CRC_SIZE;
+
+    uint8_t encoded[ENCODED_MAX + 1];
+    size_t encodedLength = cobsEncode(frame, length, encoded);
+    encoded[encodedLength++] = 0x00;
+    Serial.write(encoded, encodedLength);
+    ++binaryStats.framesSent;
+}
+
+static uint8_t *txPayload() {
+    return txFrame + BINARY_HEADER_SIZE;
+}
+
+static void sendResponse(uint8_t op, uint16_t requestId, size_t payloadLength) {
+    sendFrame(txFrame, op, BINARY_FLAG_RESPONSE, requestId, payloadLength);
+}
+
+static void sendError(uint8_t op, uint16_t requestId, const char *message) {
+    size_t length = strnlen(message, BINARY_MAX_FRAME - BINARY_HEADER_SIZE - BINARY_CRC_SIZE);
+    memcpy(txPayload(), message, length);
+    sendFrame(txFrame, op, BINARY_FLAG_RESPONSE | BINARY_FLAG_ERROR, requestId, length);
+    blinkLed(BLINK_ERROR);
+}
+
+void sendBinaryLog(const char *type, const char *message) {
+    uint8_t frame[BINARY_HEADER_SIZE + JSON_LOG_MAX_LENGTH + BINARY_CRC_SIZE];
+    uint8_t *payload = frame + BINARY_HEADER_SIZE;
+    size_t capacity = JSON_LOG_MAX_LENGTH;
+
+    size_t typeLength = strnlen(type, capacity - 1);
+    memcpy(payload, type, typeLength);
+    payload[typeLength] = '\0';
+    size_t messageLength = strnlen(message, capacity - typeLength - 1);
+    memcpy(payload + typeLength + 1, message, messageLength);
+
+    sendFrame(frame, OP_LOG, BINARY_FLAG_EVENT, 0, typeLength + 1 + messageLength);
+}
+
+// Action list encoding: u8 count, count x (u8 type, u8 channel, u8 data1, u8 data2)
+static size_t writeActions(uint8_t *out, const FootswitchConfig &fs) {
+    out[0] = fs.actionCount;
+    for (uint8_t i = 0; i < fs.actionCount; ++i) {
+        const MidiAction &action = fs.actions[i];
+        uint8_t *entry = out + 1 + i * 4;
+        entry[0] = action.type;
+        entry[1] = action.channel;
+        entry[2] = action.data1;
+        entry[3] = action.data2;
+    }
+    return 1 + fs.actionCount * 4;
+}
+
+// Size of an encoded action list, or 0 if it is malformed or runs past `available`
+static size_t actionsLength(const uint8_t *in, size_t available) {
+    if (available < 1 || in[0] > MIDI_MAX_ACTIONS) return 0;
+    size_t length = 1 + in[0] * 4;
+    if (length > available) return 0;
+    for (uint8_t i = 0; i < in[0]; ++i) {
+        if (in[1 + i * 4] >= MIDI_ACTION_TYPE_COUNT) return 0;
+    }
+    return length;
+}
+
+// Decode an action list already checked by actionsLength()
+static void readActions(const uint8_t *in, FootswitchConfig &fs) {
+    fs.actionCount = in[0];
+    for (uint8_t i = 0; i < fs.actionCount; ++i) {
+        const uint8_t *entry = in + 1 + i * 4;
+        fs.actions[i] = {entry[0], entry[1], entry[2], entry[3]};
+    }
+}
+
+// Encode one switch into at most `capacity` bytes; 0 if it does not fit
+static size_t writeSwitchRecord(uint8_t *out, size_t capacity, int index, const FootswitchConfig *switches) {
+    const FootswitchConfig &fs = switches[index];
+    size_t nameLength = min(strlen(fs.name), (size_t)BINARY_MAX_NAME_LENGTH);
+    if (fs.actionCount > MIDI_MAX_ACTIONS || 8 + nameLength + 1 + fs.actionCount * 4 > capacity) return 0;
+
+    out[0] = index;
+    out[1] = fs.midiChannel;
+    out[2] = fs.midiCC;
+    out[3] = fs.midiValue;
+    out[4] = fs.enabled ? 1 : 0;
+    putU16(out + 5, fs.color);
+    out[7] = nameLength;
+    memcpy(out + 8, fs.name, nameLength);
+    return 8 + nameLength + writeActions(out + 8 + nameLength, fs);
+}
+
+// Bank byte of a request: BINARY_ACTIVE_BANK selects the active bank
+static int requestBank(uint8_t value) {
+    if (value == BINARY_ACTIVE_BANK) return getActiveBank();
+    return value < BANK_COUNT ? value : -1;
+}
+
+static void handleGetConfig(uint16_t requestId, const uint8_t *request, size_t requestLength) {
+    int bank = requestBank(requestLength > 0 ? request[0] : BINARY_ACTIVE_BANK);
+    if (bank < 0) {
+        sendError(OP_GET_CONFIG, requestId, "Invalid bank");
+        return;
+    }
+
+    const FootswitchConfig *switches = getBankSwitches(bank);
+    uint8_t *payload = txPayload();
+    size_t length = 2;
+    payload[0] = bank;
+    payload[1] = NUM_FOOTSWITCHES;
+    const size_t capacity = BINARY_MAX_FRAME - BINARY_HEADER_SIZE - BINARY_CRC_SIZE;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        size_t written = writeSwitchRecord(payload + length, capacity - length, i, switches);
+        if (written == 0) {
+            sendError(OP_GET_CONFIG, requestId, "Configuration does not fit in a frame");
+            return;
+        }
+        length += written;
+    }
+    sendResponse(OP_GET_CONFIG, requestId, length);
+}
+
+static void handleSetConfig(uint16_t requestId, const uint8_t *payload, size_t length) {
+    int bank = requestBank(length > 0 ? payload[0] : BINARY_ACTIVE_BANK);
+    if (bank < 0) {
+        sendError(OP_SET_CONFIG, requestId, "Invalid bank");
+        return;
+    }
+    if (length < 2 || payload[1] != NUM_FOOTSWITCHES) {
+        sendError(OP_SET_CONFIG, requestId, "Invalid number of switches");
+        return;
+    }
+
+    // Validate every record before touching the live configuration
+    bool seen[NUM_FOOTSWITCHES] = {};
+    size_t pos = 2;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        size_t actions = 0;
+        if (pos + 8 > length || payload[pos] >= NUM_FOOTSWITCHES ||
+            pos + 8 + payload[pos + 7] > length || payload[pos + 7] > BINARY_MAX_NAME_LENGTH ||
+            (actions = actionsLength(payload + pos + 8 + payload[pos + 7],
+                                     length - pos - 8 - payload[pos + 7])) == 0) {
+            sendError(OP_SET_CONFIG, requestId, "Malformed switch record");
+            return;
+        }
+        if (seen[payload[pos]]) {
+            sendError(OP_SET_CONFIG, requestId, "Duplicate switch ID");
+            return;
+        }
+        seen[payload[pos]] = true;
+        pos += 8 + payload[pos + 7] + actions;
+    }
+
+    FootswitchConfig *switches = stageBankUpdate(bank);
+    pos = 2;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        const uint8_t *record = payload + pos;
+        FootswitchConfig &fs = switches[record[0]];
+
+        fs.midiChannel = record[1];
+        fs.midiCC = record[2];
+        fs.midiValue = record[3];
+        fs.enabled = record[4] != 0;
+        fs.color = getU16(record + 5);
+        memcpy(fs.name, record + 8, record[7]);
+        fs.name[record[7]] = '\0';
+        readActions(record + 8 + record[7], fs);
+        compileSwitchMidi(fs);
+        pos += 8 + record[7] + 1 + fs.actionCount * 4;
+    }
+    publishBankUpdate(bank);
+
+    commitConfigUpdate(bank);
+    sendResponse(OP_SET_CONFIG, requestId, 0);
+}
+
+static void handlePatchSwitch(uint16_t requestId, const uint8_t *payload, size_t length) {
+    if (length < 2 || payload[0] >= NUM_FOOTSWITCHES) {
+        sendError(OP_PATCH_SWITCH, requestId, "Invalid switch ID");
+        return;
+    }
+
+    uint8_t mask = payload[1];
+    size_t needed = 2;
+    if (mask & PATCH_CHANNEL) needed += 1;
+    if (mask & PATCH_CC) needed += 1;
+    if (mask & PATCH_VALUE) needed += 1;
+    if (mask & PATCH_ENABLED) needed += 1;
+    if (mask & PATCH_COLOR) needed += 2;
+    size_t nameAt = needed;
+    if (mask & PATCH_NAME) {
+        if (nameAt >= length || payload[nameAt] > BINARY_MAX_NAME_LENGTH) {
+            sendError(OP_PATCH_SWITCH, requestId, "Malformed patch");
+            return;
+        }
+        needed += 1 + payload[nameAt];
+    }
+    size_t actionsAt = needed;
+    if (mask & PATCH_ACTIONS) {
+        size_t actions = needed < length ? actionsLength(payload + actionsAt, length - actionsAt) : 0;
+        if (actions == 0) {
+            sendError(OP_PATCH_SWITCH, requestId, "Malformed patch");
+            return;
+        }
+        needed += actions;
+    }
+    if (needed > length) {
+        sendError(OP_PATCH_SWITCH, requestId, "Malformed patch");
+        return;
+    }
+
+    lockConfig();
+    uint8_t bank = getActiveBank();
+    FootswitchConfig &fs = footswitches[payload[0]];
+    FootswitchConfig before = fs;
+    size_t pos = 2;
+    if (mask & PATCH_CHANNEL) fs.midiChannel = payload[pos++];
+    if (mask & PATCH_CC) fs.midiCC = payload[pos++];
+    if (mask & PATCH_VALUE) fs.midiValue = payload[pos++];
+    if (mask & PATCH_ENABLED) fs.enabled = payload[pos++] != 0;
+    if (mask & PATCH_COLOR) {
+        fs.color = getU16(payload + pos);
+        pos += 2;
+    }
+    if (mask & PATCH_NAME) {
+        memcpy(fs.name, payload + pos + 1, payload[pos]);
+        fs.name[payload[pos]] = '\0';
+    }
+    if (mask & PATCH_ACTIONS) readActions(payload + actionsAt, fs);
+    bool changed = fs.midiChannel != before.midiChannel || fs.midiCC != before.midiCC ||
+                   fs.midiValue != before.midiValue || fs.enabled != before.enabled ||
+                   fs.color != before.color || strcmp(fs.name, before.name) != 0 ||
+                   fs.actionCount != before.actionCount ||
+                   memcmp(fs.actions, before.actions, fs.actionCount * sizeof(MidiAction)) != 0;
+    if (changed) compileSwitchMidi(fs);
+    unlockConfig();
+
+    if (changed) {
+        ++configPersistStats.patches;
+        scheduleConfigCommit(bank, payload[0]);
+        postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_FOOTSWITCH);
+        postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_CONFIG);
+    }
+    sendResponse(OP_PATCH_SWITCH, requestId, 0);
+}
+
+static void handleCommit(uint16_t requestId) {
+    uint8_t *payload = txPayload();
+    payload[0] = commitPendingConfig() ? 1 : 0;
+    putU32(payload + 1, configPersistStats.flashWrites);
+    putU32(payload + 5, configPersistStats.writesAvoided);
+    sendResponse(OP_COMMIT, requestId, 9);
+}
+
+static void handleTestSwitch(uint16_t requestId, const uint8_t *payload, size_t length) {
+    if (length < 1 || payload[0] >= NUM_FOOTSWITCHES) {
+        sendError(OP_TEST_SWITCH, requestId, "Invalid switch ID");
+        return;
+    }
+    blinkLed(BLINK_TEST_SWITCH);
+    queueSwitchMidi(MIDI_PRODUCER_HOST, payload[0]);
+    sendResponse(OP_TEST_SWITCH, requestId, 0);
+}
+
+static void handleCalibrateLadder(uint16_t requestId, const uint8_t *payload, size_t length) {
+    if (length < 2) {
+        sendError(OP_CALIBRATE_LADDER, requestId, "Missing calibration action");
+        return;
+    }
+
+    uint8_t action = payload[0];
+    int switchId = (int8_t)payload[1];
+    uint16_t value = 0;
+
+    if (action == 0) {
+        if (switchId >= NUM_FOOTSWITCHES) {
+            sendError(OP_CALIBRATE_LADDER, requestId, "Invalid switch ID");
+            return;
+        }
+        value = captureLadderLevel(switchId);
+    } else if (action == 1) {
+        char error[48];
+        if (!saveLadderCalibration(error, sizeof(error))) {
+            sendError(OP_CALIBRATE_LADDER, requestId, error);
+            return;
+        }
+        blinkLed(BLINK_SET_CONFIG);
+    } else if (action == 2) {
+        resetLadderCalibration();
+    } else {
+        sendError(OP_CALIBRATE_LADDER, requestId, "Unknown calibration action");
+        return;
+    }
+
+    putU16(txPayload(), value);
+    sendResponse(OP_CALIBRATE_LADDER, requestId, 2);
+}
+
+static void handleSelectBank(uint16_t requestId, const uint8_t *payload, size_t length) {
+    if (length < 1 || payload[0] >= BANK_COUNT) {
+        sendError(OP_SELECT_BANK, requestId, "Invalid bank");
+        return;
+    }
+    if (!selectBank(payload[0], DISPLAY_PRODUCER_HOST)) serviceBanks();
+    txPayload()[0] = getActiveBank();
+    txPayload()[1] = BANK_COUNT;
+    sendResponse(OP_SELECT_BANK, requestId, 2);
+}
+
+static void handleGetStats(uint16_t requestId) {
+    uint8_t *payload = txPayload();
+    putU32(payload + 0, binaryStats.framesReceived);
+    putU32(payload + 4, binaryStats.framesSent);
+    putU32(payload + 8, binaryStats.crcErrors);
+    putU32(payload + 12, binaryStats.framingErrors);
+    putU32(payload + 16, binaryStats.sequenceGaps);
+    putU32(payload + 20, binaryStats.sessions);
+    sendResponse(OP_GET_STATS, requestId, 24);
+}
+
+static void dispatchFrame(const uint8_t *frame, size_t length) {
+    uint8_t op = frame[1];
+    uint8_t seq = frame[3];
+    uint16_t requestId = getU16(frame + 4);
+    const uint8_t *payload = frame + BINARY_HEADER_SIZE;
+    size_t payloadLength = length - BINARY_HEADER_SIZE;
+
+    if (rxSequenceKnown && seq != expectedRxSequence) {
+        binaryStats.sequenceGaps += (uint8_t)(seq - expectedRxSequence);
+    }
+    expectedRxSequence = seq + 1;
+    rxSequenceKnown = true;
+
+    switch (op) {
+        case OP_HELLO:
+            txPayload()[0] = BINARY_PROTOCOL_VERSION;
+            txPayload()[1] = NUM_FOOTSWITCHES;
+            txPayload()[2] = BANK_COUNT;
+            sendResponse(OP_HELLO, requestId, 3);
+            break;
+        case OP_PING:
+            blinkLed(BLINK_PING);
+            sendResponse(OP_PING, requestId, 0);
+            break;
+        case OP_GET_CONFIG:
+            blinkLed(BLINK_GET_CONFIG);
+            handleGetConfig(requestId, payload, payloadLength);
+            break;
+        case OP_SET_CONFIG:
+            handleSetConfig(requestId, payload, payloadLength);
+            break;
+        case OP_TEST_SWITCH:
+            handleTestSwitch(requestId, payload, payloadLength);
+            break;
+        case OP_PATCH_SWITCH:
+            handlePatchSwitch(requestId, payload, payloadLength);
+            break;
+        case OP_COMMIT:
+            handleCommit(requestId);
+            break;
+        case OP_SELECT_BANK:
+            handleSelectBank(requestId, payload, payloadLength);
+            break;
+        case OP_CALIBRATE_LADDER:
+            handleCalibrateLadder(requestId, payload, payloadLength);
+            break;
+        case OP_GET_STATS:
+            handleGetStats(requestId);
+            break;
+        case OP_BYE:
+            sendResponse(OP_BYE, requestId, 0);
+            Serial.flush();
+            binaryActive = false;
+            break;
+        default:
+            sendError(op, requestId, "Unknown op");
+            break;
+    }
+}
+
+static void processEncodedFrame() {
+    if (rxOverflowed || rxEncodedLength == 0) {
+        if (rxOverflowed) ++binaryStats.framingErrors;
+        return;
+    }
+
+    size_t length = cobsDecode(rxEncoded, rxEncodedLength, rxFrame, sizeof(rxFrame));
+    if (length < BINARY_HEADER_SIZE + BINARY_CRC_SIZE || rxFrame[0] != BINARY_PROTOCOL_VERSION) {
+        ++binaryStats.framingErrors;
+        return;
+    }
+
+    length -= BINARY_CRC_SIZE;
+    if (crc16Ccitt(rxFrame, length) != getU16(rxFrame + length)) {
+        ++binaryStats.crcErrors;
+        return;
+    }
+
+    ++binaryStats.framesReceived;
+    dispatchFrame(rxFrame, length);
+}
+
+// Switch the host UART to binary framing (called after the JSON handshake reply)
+void startBinaryProtocol() {
+    rxEncodedLength = 0;
+    rxOverflowed = false;
+    rxSequenceKnown = false;
+    ++binaryStats.sessions;
+    binaryActive = true;
+}
+
+bool isBinaryProtocolActive() {
+    return binaryActive;
+}
+
+// Feed one received byte; a 0x00 completes the frame
+void binaryProtocolReceive(uint8_t byte) {
+    if (byte == 0x00) {
+        processEncodedFrame();
+        rxEncodedLength = 0;
+        rxOverflowed = false;
+        return;
+    }
+    if (rxEncodedLength < sizeof(rxEncoded)) {
+        rxEncoded[rxEncodedLength++] = byte;
+    } else {
+        rxOverflowed = true;
+    }
+}
+
+// Leave binary framing without OP_BYE (the host sent a JSON command instead)
+void stopBinaryProtocol() {
+    rxEncodedLength = 0;
+    rxOverflowed = false;
+    binaryActive = false;
+}
@@ -0,0 +1,59 @@
+#include "boot.h"
+#include "utils.h"
+#include <atomic>
+
+static_assert(BOOT_STAGE_COUNT <= 16, "Reached stages are a 16-bit mask");
+
+static const char *STAGE_NAMES[BOOT_STAGE_COUNT] = {
+    "setup", "uart", "midi", "ladder", "config", "input_ready", "display_init", "first_paint"
+};
+
+static std::atomic<uint32_t> stageTimes[BOOT_STAGE_COUNT];
+static std::atomic<uint16_t> reachedStages(0);
+static bool profileSent = false;   // Loop only
+
+void markBootStage(BootStage stage) {
+    if (bootStageReached(stage)) return;
+    stageTimes[stage].store((uint32_t)esp_timer_get_time(), std::memory_order_relaxed);
+    reachedStages.fetch_or(1u << stage, std::memory_order_release);
+}
+
+bool bootStageReached(BootStage stage) {
+    return (reachedStages.load(std::memory_order_acquire) & (1u << stage)) != 0;
+}
+
+uint32_t bootStageUs(BootStage stage) {
+    return bootStageReached(stage) ? stageTimes[stage].load(std::memory_order_relaxed) : 0;
+}
+
+void sendBootProfile() {
+    JsonDocument doc(responseArena.reset());
+    doc["type"] = "boot_profile";
+    doc["status"] = "success";
+
+    // Stages not reached yet are left out
+    JsonObject stages = doc["stages_us"].to<JsonObject>();
+    for (int i = 0; i < BOOT_STAGE_COUNT; ++i) {
+        if (bootStageReached((BootStage)i)) stages[STAGE_NAMES[i]] = bootStageUs((BootStage)i);
+    }
+
+    if (bootStageReached(BOOT_STAGE_INPUT_READY)) {
+        uint32_t readyUs = bootStageUs(BOOT_STAGE_INPUT_READY);
+        doc["input_ready_us"] = readyUs;
+        doc["target_us"] = BOOT_INPUT_READY_TARGET_US;
+        doc["target_met"] = readyUs <= BOOT_INPUT_READY_TARGET_US;
+    }
+    if (bootStageReached(BOOT_STAGE_FIRST_PAINT) && bootStageReached(BOOT_STAGE_INPUT_READY)) {
+        // How long switches were live before the screens showed anything
+        doc["paint_after_input_us"] = bootStageUs(BOOT_STAGE_FIRST_PAINT) - bootStageUs(BOOT_STAGE_INPUT_READY);
+    }
+    doc["complete"] = bootStageReached(BOOT_STAGE_FIRST_PAINT);
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+void serviceBootProfile() {
+    if (profileSent || !bootStageReached(BOOT_STAGE_FIRST_PAINT)) return;
+    profileSent = true;
+    sendBootProfile();
+}
@@ -2,106 +2,676 @@
 #include "utils.h"
 #include "midi.h"
 #include "switches.h"
+#include "display.h"
+#include "banks.h"
+#include "gestures.h"
+#include "pedals.h"
+#include "events.h"
 
 // Preferences for storing configuration
 Preferences preferences;
 
-void initializeDefaultConfig() {
+// Mutex protecting the bank arena and the footswitches pointer while they are
+// copied, rewritten or swapped
+static SemaphoreHandle_t configMutex = NULL;
+
+void initializeConfigLock() {
+    if (configMutex == NULL) {
+        configMutex = xSemaphoreCreateMutex();
+    }
+}
+
+void lockConfig() {
+    if (configMutex != NULL) xSemaphoreTake(configMutex, portMAX_DELAY);
+}
+
+void unlockConfig() {
+    if (configMutex != NULL) xSemaphoreGive(configMutex);
+}
+
+void initializeDefaultConfig(FootswitchConfig *switches) {
     // Set default configuration for each footswitch with more descriptive names
-    String defaultNames[] = {"CLEAN", "CRUNCH", "AMBIENT", "LOOP", "SOLO", "RHYTHM"};
+    // Boards with more switches number the rest and cycle the colours
+    const char *defaultNames[] = {"CLEAN", "CRUNCH", "AMBIENT", "LOOP", "SOLO", "RHYTHM"};
     uint16_t defaultColors[] = {GREEN, RED, BLUE, MAGENTA, YELLOW, CYAN};
+    const int defaultCount = sizeof(defaultNames) / sizeof(defaultNames[0]);
     
     for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
-        footswitches[i].name = defaultNames[i];
-        footswitches[i].midiChannel = 1;
-        footswitches[i].midiCC = 20 + i; // CC 20-25 by default
-        footswitches[i].midiValue = 127;
-        footswitches[i].enabled = true;
-        footswitches[i].color = defaultColors[i];
+        if (i < defaultCount) {
+            setFootswitchName(switches[i], defaultNames[i]);
+        } else {
+            snprintf(switches[i].name, sizeof(switches[i].name), "FS %d", i + 1);
+        }
+        switches[i].midiChannel = 1;
+        switches[i].midiCC = 20 + i; // CC 20 upwards by default
+        switches[i].midiValue = 127;
+        switches[i].enabled = true;
+        switches[i].color = defaultColors[i % defaultCount];
+        switches[i].actionCount = 0;
+        setDefaultGestures(switches[i].gestures);
+        compileSwitchMidi(switches[i]);
     }
 }
 
-void saveConfigToFlash() {
-    preferences.begin("midi-config", false);
+static const char *CONFIG_NAMESPACE = "midi-config";
+static const char *CONFIG_BLOB_KEY = "config_bin";
+static const char *LEGACY_CONFIG_KEY = "config";
+static const char *BANK_NAV_KEY = "bank_nav";
+
+uint32_t configLoadTimeUs = 0;
+
+ConfigPersistStats configPersistStats = {0, 0, 0, 0};
+static bool commitPending = false;
+static unsigned long lastEditTime = 0;
+static uint8_t commitFailures = 0;   // Consecutive failed writes
+static uint32_t dirtyBanks = 0;   // Banks changed in RAM but not yet written
+
+// Staging area for the persisted record (too large for the loop stack)
+static PackedConfig configBlob;
+
+// Record layout written before action lists existed
+struct __attribute__((packed)) PackedSwitchConfigV1 {
+    char name[FOOTSWITCH_NAME_MAX + 1];
+    uint8_t midiChannel;
+    uint8_t midiCC;
+    uint8_t midiValue;
+    uint8_t enabled;
+    uint16_t color;
+};
+
+struct __attribute__((packed)) PackedConfigV1 {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t count;
+    PackedSwitchConfigV1 switches[NUM_FOOTSWITCHES];
+    uint16_t crc;
+};
+
+static_assert(sizeof(PackedConfigV1) <= sizeof(PackedConfig), "Version 1 records are read into configBlob");
+
+// Record layout written before gestures existed
+struct __attribute__((packed)) PackedSwitchConfigV2 {
+    char name[FOOTSWITCH_NAME_MAX + 1];
+    uint8_t midiChannel;
+    uint8_t midiCC;
+    uint8_t midiValue;
+    uint8_t enabled;
+    uint16_t color;
+    uint8_t actionCount;
+    MidiAction actions[MIDI_MAX_ACTIONS];
+};
+
+struct __attribute__((packed)) PackedConfigV2 {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t count;
+    PackedSwitchConfigV2 switches[NUM_FOOTSWITCHES];
+    uint16_t crc;
+};
+
+static_assert(sizeof(PackedConfigV2) <= sizeof(PackedConfig), "Version 2 records are read into configBlob");
+
+// Bank 0 keeps the key used before banks existed
+static void bankKey(uint8_t bank, char key[16]) {
+    if (bank == 0) {
+        strcpy(key, CONFIG_BLOB_KEY);
+    } else {
+        snprintf(key, 16, "bank_%u", (unsigned)bank);
+    }
+}
+
+// Field names of data1/data2 for each action type
+static const char *actionData1Key(uint8_t type) {
+    switch (type) {
+        case MIDI_ACTION_PC: return "program";
+        case MIDI_ACTION_CC: return "cc";
+        default: return "note";
+    }
+}
+
+static const char *actionData2Key(uint8_t type) {
+    return type == MIDI_ACTION_CC ? "value" : "velocity";
+}
+
+static void writeMidiActionJson(JsonObject out, const MidiAction &action) {
+    out["type"] = midiActionTypeName(action.type);
+    out["channel"] = action.channel;
+    out[actionData1Key(action.type)] = action.data1;
+    if (action.type != MIDI_ACTION_PC) {
+        out[actionData2Key(action.type)] = action.data2;
+    }
+}
+
+// Replace a switch's action list. Returns false (leaving it unchanged) if
+// the list is too long or has an unknown action type.
+static bool parseMidiActions(FootswitchConfig &fs, JsonArrayConst actions) {
+    if (actions.size() > MIDI_MAX_ACTIONS) return false;
 
-    // Create JSON document
-    JsonDocument doc;
-    JsonArray switches = doc["switches"].to<JsonArray>();
+    MidiAction parsed[MIDI_MAX_ACTIONS];
+    uint8_t count = 0;
+    for (JsonObjectConst action : actions) {
+        MidiAction &out = parsed[count++];
+        if (!parseMidiActionType(action["type"] | "", out.type)) return false;
+        out.channel = action["channel"] | fs.midiChannel;
+        out.data1 = action[actionData1Key(out.type)] | 0;
+        out.data2 = action[actionData2Key(out.type)] | 127;
+    }
+
+    fs.actionCount = count;
+    memcpy(fs.actions, parsed, count * sizeof(MidiAction));
+    return true;
+}
+
+// Gesture binding types: the MIDI action types plus bank steps
+static const char *GESTURE_BANK_NEXT_NAME = "bank_next";
+static const char *GESTURE_BANK_PREV_NAME = "bank_prev";
+
+static void writeGestureBindingJson(JsonObject out, const GestureBinding &binding) {
+    switch (binding.kind) {
+        case GESTURE_ACTION_MIDI: writeMidiActionJson(out, binding.midi); break;
+        case GESTURE_ACTION_BANK_NEXT: out["type"] = GESTURE_BANK_NEXT_NAME; break;
+        case GESTURE_ACTION_BANK_PREV: out["type"] = GESTURE_BANK_PREV_NAME; break;
+        default: break;
+    }
+}
 
+static bool gesturesAreDefault(const GestureConfig &gestures) {
+    GestureConfig defaults;
+    setDefaultGestures(defaults);
+    return memcmp(&gestures, &defaults, sizeof(defaults)) == 0;
+}
+
+static void writeGesturesJson(JsonObject out, const GestureConfig &gestures) {
+    out["long_press_ms"] = gestures.longPressMs;
+    out["double_tap_ms"] = gestures.doubleTapMs;
+    out["repeat_delay_ms"] = gestures.repeatDelayMs;
+    out["repeat_interval_ms"] = gestures.repeatIntervalMs;
+    for (uint8_t i = 0; i < GESTURE_BINDING_COUNT; i++) {
+        if (gestures.bindings[i].kind == GESTURE_ACTION_NONE) continue;
+        writeGestureBindingJson(out[gestureEventName(i + 1)].to<JsonObject>(), gestures.bindings[i]);
+    }
+}
+
+// A binding object; {"type": "none"} unbinds
+static bool parseGestureBinding(GestureBinding &out, JsonVariantConst in, uint8_t defaultChannel) {
+    memset(&out, 0, sizeof(out));
+    const char *type = in["type"] | "";
+    if (strcmp(type, "none") == 0) return true;
+    if (strcmp(type, GESTURE_BANK_NEXT_NAME) == 0) {
+        out.kind = GESTURE_ACTION_BANK_NEXT;
+        return true;
+    }
+    if (strcmp(type, GESTURE_BANK_PREV_NAME) == 0) {
+        out.kind = GESTURE_ACTION_BANK_PREV;
+        return true;
+    }
+    if (!parseMidiActionType(type, out.midi.type)) return false;
+    out.kind = GESTURE_ACTION_MIDI;
+    out.midi.channel = in["channel"] | defaultChannel;
+    out.midi.data1 = in[actionData1Key(out.midi.type)] | 0;
+    out.midi.data2 = in[actionData2Key(out.midi.type)] | 127;
+    return true;
+}
+
+static uint16_t parseGestureTime(JsonVariantConst value, uint16_t current) {
+    if (value.isNull()) return current;
+    return min(max(value.as<uint32_t>(), (uint32_t)GESTURE_MIN_MS), (uint32_t)GESTURE_MAX_MS);
+}
+
+// Apply the keys present in a "gestures" object on top of the given
+// settings. Returns false (leaving them unchanged) on an unknown binding type.
+static bool parseGestures(GestureConfig &gestures, JsonObjectConst in, uint8_t defaultChannel) {
+    GestureConfig parsed = gestures;
+    parsed.longPressMs = parseGestureTime(in["long_press_ms"], parsed.longPressMs);
+    parsed.doubleTapMs = parseGestureTime(in["double_tap_ms"], parsed.doubleTapMs);
+    parsed.repeatDelayMs = parseGestureTime(in["repeat_delay_ms"], parsed.repeatDelayMs);
+    parsed.repeatIntervalMs = parseGestureTime(in["repeat_interval_ms"], parsed.repeatIntervalMs);
+    for (uint8_t i = 0; i < GESTURE_BINDING_COUNT; i++) {
+        JsonVariantConst binding = in[gestureEventName(i + 1)];
+        if (binding.isNull()) continue;
+        if (!parseGestureBinding(parsed.bindings[i], binding, defaultChannel)) return false;
+    }
+    gestures = parsed;
+    return true;
+}
+
+// Fill a JSON array with one object per footswitch
+static void writeSwitchesJson(JsonArray switches, const FootswitchConfig *bank) {
     for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
+        char color[8];
+        colorToHexString(bank[i].color, color);
+
         JsonObject sw = switches.add<JsonObject>();
         sw["id"] = i;
-        sw["name"] = footswitches[i].name;
-        sw["channel"] = footswitches[i].midiChannel;
-        sw["cc"] = footswitches[i].midiCC;
-        sw["value"] = footswitches[i].midiValue;
-        sw["enabled"] = footswitches[i].enabled;
-        sw["color"] = colorToHexString(footswitches[i].color);
+        sw["name"] = (const char *)bank[i].name;   // Stored by reference, the bank outlives the document
+        sw["channel"] = bank[i].midiChannel;
+        sw["cc"] = bank[i].midiCC;
+        sw["value"] = bank[i].midiValue;
+        sw["enabled"] = (bool)bank[i].enabled;
+        sw["color"] = color;  // char[] is copied into the document
+
+        if (bank[i].actionCount > 0) {
+            JsonArray actions = sw["actions"].to<JsonArray>();
+            for (uint8_t a = 0; a < bank[i].actionCount; a++) {
+                writeMidiActionJson(actions.add<JsonObject>(), bank[i].actions[a]);
+            }
+        }
+        if (!gesturesAreDefault(bank[i].gestures)) {
+            writeGesturesJson(sw["gestures"].to<JsonObject>(), bank[i].gestures);
+        }
     }
+}
+
+// Copy a name, truncated to FOOTSWITCH_NAME_MAX characters
+void setFootswitchName(FootswitchConfig &fs, const char *name) {
+    strncpy(fs.name, name, FOOTSWITCH_NAME_MAX);
+    fs.name[FOOTSWITCH_NAME_MAX] = '\0';
+}
 
-    String jsonString;
-    serializeJson(doc, jsonString);
+// Copy one JSON switch object into a footswitch entry
+void applySwitchConfig(FootswitchConfig &fs, JsonObjectConst sw) {
+    setFootswitchName(fs, sw["name"] | "");
+    fs.midiChannel = sw["channel"];
+    fs.midiCC = sw["cc"];
+    fs.midiValue = sw["value"];
+    fs.enabled = sw["enabled"];
+    fs.color = hexStringToColor(sw["color"] | "");
+    if (!parseMidiActions(fs, sw["actions"])) {
+        printJsonLog("error", "Invalid MIDI action list, actions cleared");
+        fs.actionCount = 0;
+    }
+    setDefaultGestures(fs.gestures);
+    if (!parseGestures(fs.gestures, sw["gestures"], fs.midiChannel)) {
+        printJsonLog("error", "Invalid gesture binding, gestures reset");
+        setDefaultGestures(fs.gestures);
+    }
+    compileSwitchMidi(fs);
+}
 
-    preferences.putString("config", jsonString);
+static uint16_t packedConfigCrc(const PackedConfig &blob) {
+    return crc16Ccitt(reinterpret_cast<const uint8_t *>(&blob), offsetof(PackedConfig, crc));
+}
+
+static void packConfig(PackedConfig &blob, const FootswitchConfig *switches) {
+    memset(&blob, 0, sizeof(blob));
+    blob.magic = CONFIG_BLOB_MAGIC;
+    blob.version = CONFIG_BLOB_VERSION;
+    blob.count = NUM_FOOTSWITCHES;
+    for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
+        PackedSwitchConfig &out = blob.switches[i];
+        memcpy(out.name, switches[i].name, sizeof(out.name));
+        out.midiChannel = switches[i].midiChannel;
+        out.midiCC = switches[i].midiCC;
+        out.midiValue = switches[i].midiValue;
+        out.enabled = switches[i].enabled ? 1 : 0;
+        out.color = switches[i].color;
+        out.actionCount = switches[i].actionCount;
+        memcpy(out.actions, switches[i].actions, sizeof(out.actions));
+        memcpy(&out.gestures, &switches[i].gestures, sizeof(out.gestures));
+    }
+    blob.crc = packedConfigCrc(blob);
+}
+
+static bool unpackConfig(const PackedConfig &blob, FootswitchConfig *switches) {
+    if (blob.magic != CONFIG_BLOB_MAGIC || blob.version != CONFIG_BLOB_VERSION ||
+        blob.count != NUM_FOOTSWITCHES || blob.crc != packedConfigCrc(blob)) {
+        return false;
+    }
+    for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
+        const PackedSwitchConfig &in = blob.switches[i];
+        memcpy(switches[i].name, in.name, FOOTSWITCH_NAME_MAX);
+        switches[i].name[FOOTSWITCH_NAME_MAX] = '\0';
+        switches[i].midiChannel = in.midiChannel;
+        switches[i].midiCC = in.midiCC;
+        switches[i].midiValue = in.midiValue;
+        switches[i].enabled = in.enabled != 0;
+        switches[i].color = in.color;
+        switches[i].actionCount = min(in.actionCount, (uint8_t)MIDI_MAX_ACTIONS);
+        memcpy(switches[i].actions, in.actions, sizeof(in.actions));
+        memcpy(&switches[i].gestures, &in.gestures, sizeof(in.gestures));
+        compileSwitchMidi(switches[i]);
+    }
+    return true;
+}
+
+static bool unpackConfigV2(const PackedConfigV2 &blob, FootswitchConfig *switches) {
+    if (blob.magic != CONFIG_BLOB_MAGIC || blob.version != 2 || blob.count != NUM_FOOTSWITCHES ||
+        blob.crc != crc16Ccitt(reinterpret_cast<const uint8_t *>(&blob), offsetof(PackedConfigV2, crc))) {
+        return false;
+    }
+    for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
+        const PackedSwitchConfigV2 &in = blob.switches[i];
+        memcpy(switches[i].name, in.name, FOOTSWITCH_NAME_MAX);
+        switches[i].name[FOOTSWITCH_NAME_MAX] = '\0';
+        switches[i].midiChannel = in.midiChannel;
+        switches[i].midiCC = in.midiCC;
+        switches[i].midiValue = in.midiValue;
+        switches[i].enabled = in.enabled != 0;
+        switches[i].color = in.color;
+        switches[i].actionCount = min(in.actionCount, (uint8_t)MIDI_MAX_ACTIONS);
+        memcpy(switches[i].actions, in.actions, sizeof(in.actions));
+        setDefaultGestures(switches[i].gestures);
+        compileSwitchMidi(switches[i]);
+    }
+    return true;
+}
+
+static bool unpackConfigV1(const PackedConfigV1 &blob, FootswitchConfig *switches) {
+    if (blob.magic != CONFIG_BLOB_MAGIC || blob.version != 1 || blob.count != NUM_FOOTSWITCHES ||
+        blob.crc != crc16Ccitt(reinterpret_cast<const uint8_t *>(&blob), offsetof(PackedConfigV1, crc))) {
+        return false;
+    }
+    for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
+        const PackedSwitchConfigV1 &in = blob.switches[i];
+        memcpy(switches[i].name, in.name, FOOTSWITCH_NAME_MAX);
+        switches[i].name[FOOTSWITCH_NAME_MAX] = '\0';
+        switches[i].midiChannel = in.midiChannel;
+        switches[i].midiCC = in.midiCC;
+        switches[i].midiValue = in.midiValue;
+        switches[i].enabled = in.enabled != 0;
+        switches[i].color = in.color;
+        switches[i].actionCount = 0;
+        setDefaultGestures(switches[i].gestures);
+        compileSwitchMidi(switches[i]);
+    }
+    return true;
+}
+
+void markBankDirty(uint8_t bank) {
+    if (bank < BANK_COUNT) dirtyBanks |= 1u << bank;
+}
+
+// Write every dirty bank, one record each
+void saveConfigToFlash() {
+    bool failed = false;
+
+    preferences.begin(CONFIG_NAMESPACE, false);
+    for (uint8_t bank = 0; bank < BANK_COUNT; bank++) {
+        if (!(dirtyBanks & (1u << bank))) continue;
+
+        char key[16];
+        bankKey(bank, key);
+        packConfig(configBlob, getBankSwitches(bank));
+        if (preferences.putBytes(key, &configBlob, sizeof(configBlob)) != sizeof(configBlob)) {
+            failed = true;
+            continue;
+        }
+        dirtyBanks &= ~(1u << bank);
+        ++configPersistStats.flashWrites;
+    }
     preferences.end();
 
+    if (failed) {
+        // Retry after a quiet period like an edit, and report the run of
+        // failures once rather than on every attempt
+        ++configPersistStats.writeFailures;
+        if (commitFailures == 0) printJsonLog("error", "Failed to save configuration to flash");
+        if (++commitFailures > CONFIG_COMMIT_MAX_RETRIES) {
+            commitPending = false;
+            commitFailures = 0;
+            printJsonLog("error", "Configuration not saved; retrying after the next change");
+            return;
+        }
+        commitPending = true;
+        lastEditTime = millis();
+        return;
+    }
+    commitFailures = 0;
+    commitPending = false;
+    postHostEvent(HOST_EVENT_CONFIG, CONFIG_EVENT_SAVED, 0, micros());
     printJsonLog("info", "Configuration saved to flash");
 }
 
-void loadConfigFromFlash() {
-    preferences.begin("midi-config", true);
-    String jsonString = preferences.getString("config", "");
+// Read one bank's record. Returns false if it is missing or does not validate.
+// Older records are converted in RAM and rewritten on the next edit.
+bool loadBankFromFlash(uint8_t bank, FootswitchConfig *switches) {
+    char key[16];
+    bankKey(bank, key);
+
+    preferences.begin(CONFIG_NAMESPACE, true);
+    size_t stored = preferences.getBytesLength(key);
+    size_t length = 0;
+    if (stored == sizeof(PackedConfig) || stored == sizeof(PackedConfigV2) || stored == sizeof(PackedConfigV1)) {
+        length = preferences.getBytes(key, &configBlob, stored);
+    }
     preferences.end();
 
-    if (jsonString.length() == 0) {
-        printJsonLog("warn", "No configuration found, using defaults");
-        initializeDefaultConfig();
-        saveConfigToFlash();
-        return;
+    if (length == sizeof(PackedConfig) && unpackConfig(configBlob, switches)) {
+        return true;
     }
+    if (length == sizeof(PackedConfigV2) &&
+        unpackConfigV2(*reinterpret_cast<const PackedConfigV2 *>(&configBlob), switches)) {
+        return true;
+    }
+    if (length == sizeof(PackedConfigV1) &&
+        unpackConfigV1(*reinterpret_cast<const PackedConfigV1 *>(&configBlob), switches)) {
+        return true;
+    }
+    if (length > 0) {
+        printJsonLogf("error", "Stored bank %u is corrupt or from another build", (unsigned)bank);
+    }
+    return false;
+}
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonString);
+void saveBankNavToFlash() {
+    preferences.begin(CONFIG_NAMESPACE, false);
+    preferences.putBytes(BANK_NAV_KEY, &bankNav, sizeof(bankNav));
+    preferences.end();
+}
 
-    if (error) {
-        printJsonLog("error", "Failed to parse configuration JSON, using defaults");
-        initializeDefaultConfig();
-        return;
+static void loadBankNavFromFlash() {
+    preferences.begin(CONFIG_NAMESPACE, true);
+    if (preferences.getBytesLength(BANK_NAV_KEY) == sizeof(bankNav)) {
+        preferences.getBytes(BANK_NAV_KEY, &bankNav, sizeof(bankNav));
     }
+    preferences.end();
+}
+
+enum LegacyConfigResult {
+    LEGACY_CONFIG_NONE,
+    LEGACY_CONFIG_MIGRATED,
+    LEGACY_CONFIG_FAILED     // Present but unreadable; left in flash untouched
+};
 
-    JsonArray switches = doc["switches"];
-    for (int i = 0; i < NUM_FOOTSWITCHES && i < switches.size(); i++) {
-        JsonObject sw = switches[i];
-        footswitches[i].name = sw["name"].as<String>();
-        footswitches[i].midiChannel = sw["channel"];
-        footswitches[i].midiCC = sw["cc"];
-        footswitches[i].midiValue = sw["value"];
-        footswitches[i].enabled = sw["enabled"];
-        footswitches[i].color = hexStringToColor(sw["color"].as<String>());
+// One-time upgrade from the JSON string written by older firmware.
+// The read-and-parse time is logged as the baseline for the binary record.
+static LegacyConfigResult migrateLegacyConfig() {
+    uint32_t start = micros();
+
+    // Read at whatever length it was stored (older firmware did not bound
+    // it); a one-off heap String, only reached when there is no binary record
+    preferences.begin(CONFIG_NAMESPACE, true);
+    bool present = preferences.isKey(LEGACY_CONFIG_KEY);
+    String json = present ? preferences.getString(LEGACY_CONFIG_KEY) : String();
+    preferences.end();
+
+    if (!present) {
+        return LEGACY_CONFIG_NONE;
+    }
+    if (json.length() == 0) {
+        printJsonLog("error", "Failed to read legacy configuration JSON");
+        return LEGACY_CONFIG_FAILED;
     }
 
-    printJsonLog("info", "Configuration loaded from flash");
+    JsonDocument doc(responseArena.reset());
+    if (deserializeJson(doc, json.c_str(), json.length())) {
+        printJsonLog("error", "Failed to parse legacy configuration JSON");
+        return LEGACY_CONFIG_FAILED;
+    }
+
+    JsonArrayConst switches = doc["switches"];
+    for (size_t i = 0; i < NUM_FOOTSWITCHES && i < switches.size(); i++) {
+        applySwitchConfig(footswitches[i], switches[i]);
+    }
+    markBankDirty(0);
+    configLoadTimeUs = micros() - start;
+    printJsonLogf("info", "Legacy JSON configuration loaded in %lu us", (unsigned long)configLoadTimeUs);
+
+    saveConfigToFlash();
+    preferences.begin(CONFIG_NAMESPACE, false);
+    preferences.remove(LEGACY_CONFIG_KEY);
+    preferences.end();
+
+    printJsonLog("info", "Migrated JSON configuration to binary record");
+    return LEGACY_CONFIG_MIGRATED;
 }
 
-void sendCurrentConfig() {
-    JsonDocument doc;
-    JsonArray switches = doc["switches"].to<JsonArray>();
+// Boot: fill the active (first) bank and the navigation assignment. The
+// remaining banks are read later by the bank store, off the boot path.
+void loadConfigFromFlash() {
+    uint32_t start = micros();
 
-    for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
-        JsonObject sw = switches.add<JsonObject>();
-        sw["id"] = i;
-        sw["name"] = footswitches[i].name;
-        sw["channel"] = footswitches[i].midiChannel;
-        sw["cc"] = footswitches[i].midiCC;
-        sw["value"] = footswitches[i].midiValue;
-        sw["enabled"] = footswitches[i].enabled;
-        sw["color"] = colorToHexString(footswitches[i].color);
+    loadBankNavFromFlash();
+
+    if (loadBankFromFlash(0, footswitches)) {
+        configLoadTimeUs = micros() - start;
+        printJsonLogf("info", "Configuration loaded from flash in %lu us", (unsigned long)configLoadTimeUs);
+        return;
+    }
+
+    LegacyConfigResult legacy = migrateLegacyConfig();
+    if (legacy == LEGACY_CONFIG_MIGRATED) {
+        return;
     }
 
+    initializeDefaultConfig(footswitches);
+    if (legacy == LEGACY_CONFIG_FAILED) {
+        // Run on defaults, but keep the user's data for a later firmware
+        // or a manual recovery instead of writing defaults over it
+        printJsonLog("warn", "Legacy configuration kept in flash, using defaults");
+    } else {
+        printJsonLog("warn", "No configuration found, using defaults");
+        markBankDirty(0);
+        saveConfigToFlash();
+    }
+    configLoadTimeUs = micros() - start;
+}
+
+void sendCurrentConfig(uint8_t bank) {
+    JsonDocument doc(responseArena.reset());
+    writeSwitchesJson(doc["switches"].to<JsonArray>(), getBankSwitches(bank));
+
     doc["type"] = "config";
     doc["status"] = "success";
+    doc["bank"] = bank;
+    doc["active_bank"] = getActiveBank();
+    doc["bank_count"] = BANK_COUNT;
+
+    JsonObject nav = doc["bank_nav"].to<JsonObject>();
+    nav["prev"] = bankNav.prevSwitch;
+    nav["next"] = bankNav.nextSwitch;
+    writePedalsJson(doc["pedals"].to<JsonArray>());
+
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+// Persist and show a configuration just received from the host
+// (shared by the JSON and binary transports)
+void commitConfigUpdate(uint8_t bank) {
+    markBankDirty(bank);
+    postHostEvent(HOST_EVENT_CONFIG, CONFIG_EVENT_SET, bank, micros());
+    saveConfigToFlash();
+    blinkLed(BLINK_SET_CONFIG);
 
-    String response;
-    serializeJson(doc, response);
-    Serial.println(response); // Already JSON, keep as is
+    // The new table is live: redraw only what changed, and flag the update
+    // with a badge instead of covering the screens
+    postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_FOOTSWITCH);
+    postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_CONFIG);
+    showStatusBadge();
+}
+
+// Apply only the fields present in a patch object. Returns true if anything changed.
+bool patchSwitchConfig(FootswitchConfig &fs, JsonObjectConst patch) {
+    bool changed = false;
+
+    if (!patch["name"].isNull()) {
+        char name[FOOTSWITCH_NAME_MAX + 1];
+        strncpy(name, patch["name"] | "", FOOTSWITCH_NAME_MAX);
+        name[FOOTSWITCH_NAME_MAX] = '\0';
+        if (strcmp(fs.name, name) != 0) {
+            memcpy(fs.name, name, sizeof(fs.name));
+            changed = true;
+        }
+    }
+    if (!patch["channel"].isNull()) {
+        uint8_t channel = patch["channel"];
+        changed |= fs.midiChannel != channel;
+        fs.midiChannel = channel;
+    }
+    if (!patch["cc"].isNull()) {
+        uint8_t cc = patch["cc"];
+        changed |= fs.midiCC != cc;
+        fs.midiCC = cc;
+    }
+    if (!patch["value"].isNull()) {
+        uint8_t value = patch["value"];
+        changed |= fs.midiValue != value;
+        fs.midiValue = value;
+    }
+    if (!patch["enabled"].isNull()) {
+        bool enabled = patch["enabled"];
+        changed |= fs.enabled != enabled;
+        fs.enabled = enabled;
+    }
+    if (!patch["color"].isNull()) {
+        uint16_t color = hexStringToColor(patch["color"] | "");
+        changed |= fs.color != color;
+        fs.color = color;
+    }
+    if (!patch["actions"].isNull()) {
+        uint8_t oldCount = fs.actionCount;
+        MidiAction oldActions[MIDI_MAX_ACTIONS];
+        memcpy(oldActions, fs.actions, sizeof(oldActions));
+        if (parseMidiActions(fs, patch["actions"])) {
+            changed |= fs.actionCount != oldCount ||
+                       memcmp(fs.actions, oldActions, fs.actionCount * sizeof(MidiAction)) != 0;
+        } else {
+            printJsonLog("error", "Invalid MIDI action list ignored");
+        }
+    }
+    if (!patch["gestures"].isNull()) {
+        GestureConfig oldGestures = fs.gestures;
+        if (parseGestures(fs.gestures, patch["gestures"], fs.midiChannel)) {
+            changed |= memcmp(&fs.gestures, &oldGestures, sizeof(oldGestures)) != 0;
+        } else {
+            printJsonLog("error", "Invalid gesture binding ignored");
+        }
+    }
+
+    if (changed) {
+        compileSwitchMidi(fs);
+        ++configPersistStats.patches;
+    }
+    return changed;
+}
+
+// Note an edit and (re)start the quiet-period timer. Edits that arrive while
+// a commit is already pending share its single flash write.
+void scheduleConfigCommit(uint8_t bank, uint8_t switchId) {
+    markBankDirty(bank);
+    postHostEvent(HOST_EVENT_CONFIG, CONFIG_EVENT_PATCH, bank, micros(), switchId);
+    if (commitPending) {
+        ++configPersistStats.writesAvoided;
+    }
+    commitPending = true;
+    lastEditTime = millis();
+}
+
+// Write a pending configuration now. Returns false if nothing was pending.
+bool commitPendingConfig() {
+    if (!commitPending) return false;
+    saveConfigToFlash();
+    return true;
+}
+
+bool isConfigCommitPending() {
+    return commitPending;
+}
+
+// Called from the loop: flush the pending commit once edits have stopped
+void serviceConfigCommit() {
+    if (commitPending && millis() - lastEditTime >= CONFIG_COMMIT_DELAY_MS) {
+        saveConfigToFlash();
+    }
 }
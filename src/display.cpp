@@ -1,11 +1,94 @@
 #include "display.h"
 #include "utils.h"
 #include "switches.h"
+#include "config.h"
+#include "spsc_queue.h"
+#include "banks.h"
+#include "stats.h"
+#include "tile_cache.h"
+#include "layout.h"
+#include "boot.h"
+#include "log.h"
+#include "MultiTFTBus.hpp"
+#include <atomic>
 
 // Display setup
 MultiTFT footswitchDisplay(TFT_CS1);  // Display for footswitch states
 MultiTFT configDisplay(TFT_CS2);      // Display for bank/config info
 
+// Both panels share one SPI bus; all drawing is queued on it as batches and
+// flushed once per burst of display events, alternating between panels
+static MultiTFTBus displayBus;
+
+DisplayFrameStats footswitchDisplayStats = {0, 0, 0, 0};
+DisplayFrameStats configDisplayStats = {0, 0, 0, 0};
+
+// Retained model of what is currently on each panel. Updates diff the
+// live configuration against it and repaint only the regions that changed.
+struct TileModel {
+    bool valid;
+    char name[FOOTSWITCH_NAME_MAX + 1];
+    uint8_t midiCC;
+    uint8_t midiChannel;
+    bool enabled;
+    uint16_t color;
+    bool selected;
+};
+
+// Longest list of active switch names; longer lists end in "..."
+static const size_t ACTIVE_NAMES_MAX = 35;
+
+struct ConfigScreenModel {
+    bool valid;            // false forces a full repaint
+    uint16_t background;
+    char title[FOOTSWITCH_NAME_MAX + 1];
+    int activeCount;
+    char activeNames[ACTIVE_NAMES_MAX + 1];
+    uint8_t midiChannel;
+    uint8_t bank;
+    bool statusBadge;
+};
+
+// Snapshot of the configuration being drawn, copied under the config lock
+// so the display task never reads a switch while the host is rewriting it.
+static FootswitchConfig viewSwitches[NUM_FOOTSWITCHES];
+static int viewSelected = -1;
+static uint8_t viewBank = 0;
+static bool viewStatusBadge = false;
+
+// "CONFIG UPDATED" badge: set by the loop, drawn by the display task
+static std::atomic<bool> statusBadgeVisible(false);
+static unsigned long statusBadgeShownAt = 0;   // Loop only
+
+static bool footswitchScreenValid = false;
+static TileModel tileModels[NUM_FOOTSWITCHES];
+static ConfigScreenModel configModel;
+
+// Config screen text field regions (cleared to background before redraw)
+static const int TITLE_Y = 40;
+static const int ACTIVE_COUNT_Y = 90;
+static const int ACTIVE_NAMES_Y = 120;
+static const int MIDI_CHANNEL_Y = 160;
+static const int STATUS_Y = 200;
+static const int BANK_Y = 240;
+static const int FIELD_X = 2;
+static const int FIELD_WIDTH = 476;
+static const int STATUS_BADGE_X = 14;
+static const int STATUS_BADGE_WIDTH = 184;   // "CONFIG UPDATED" at text size 2, plus margins
+static const int STATUS_BADGE_HEIGHT = 24;
+
+// Config screen fields, one draw batch each. The batch context is the field
+// id, with CONFIG_FIELD_CLEAR set when the old text has to be erased first.
+enum ConfigField : uint8_t {
+    CONFIG_FIELD_TITLE,
+    CONFIG_FIELD_ACTIVE_COUNT,
+    CONFIG_FIELD_ACTIVE_NAMES,
+    CONFIG_FIELD_MIDI_CHANNEL,
+    CONFIG_FIELD_STATUS,
+    CONFIG_FIELD_BANK
+};
+static const uintptr_t CONFIG_FIELD_CLEAR = 0x100;
+
 // Helper: extract RGB components from RGB565 and compute brightness
 static uint16_t computeBrightnessFromRGB565(uint16_t color) {
     uint8_t r = (color >> 8) & 0xF8;
@@ -21,7 +104,7 @@ uint16_t getTextColorForBackground(uint16_t backgroundColor) {
 }
 
 // Small helper to draw a centered title on a display
-static void drawCenteredTitle(MultiTFT &display, const String &text, uint16_t color, int y) {
+static void drawCenteredTitle(MultiTFT &display, const char *text, uint16_t color, int y) {
     display.setTextDatum(MC_DATUM);
     display.setTextColor(color);
     display.setTextSize(4);
@@ -30,182 +113,481 @@ static void drawCenteredTitle(MultiTFT &display, const String &text, uint16_t co
 
 // Display initialization
 void initializeDisplays() {
-    footswitchDisplay.begin(1); // Landscape
-    configDisplay.begin(3);     // Landscape (rotated)
-    printJsonLog("info", "Displays initialized");
+    footswitchDisplay.begin(FOOTSWITCH_ROTATION);
+    configDisplay.begin(CONFIG_ROTATION);
+    displayBus.attach(footswitchDisplay);
+    displayBus.attach(configDisplay);
+    initializeTileCache(footswitchDisplay, FootswitchLayout::tileWidth, FootswitchLayout::tileHeight);
+    // Runs on the display task at boot, so the record is deferred
+    LOG_INFO("info", "Displays initialized (DMA: footswitch %u, config %u)",
+             (unsigned)footswitchDisplay.dmaEnabled(), (unsigned)configDisplay.dmaEnabled());
 }
 
-// Internal: draw a single footswitch tile at x,y with given dimensions
-static void drawFootswitchTile(MultiTFT &display, int x, int y, int w, int h, const FootswitchConfig &fs) {
-    uint16_t bgColor = fs.enabled ? fs.color : BLACK;
-    uint16_t textColor = fs.enabled ? getTextColorForBackground(fs.color) : RED;
+static bool tileMatches(const TileModel &model, const FootswitchConfig &fs, bool selected) {
+    return model.valid &&
+           model.selected == selected &&
+           model.enabled == fs.enabled &&
+           model.color == fs.color &&
+           model.midiCC == fs.midiCC &&
+           model.midiChannel == fs.midiChannel &&
+           strcmp(model.name, fs.name) == 0;
+}
 
-    display.fillRect(x, y, w, h, bgColor);
-    display.drawRect(x, y, w, h, WHITE);
+static void rememberTile(TileModel &model, const FootswitchConfig &fs, bool selected) {
+    model.valid = true;
+    model.selected = selected;
+    memcpy(model.name, fs.name, sizeof(model.name));
+    model.midiCC = fs.midiCC;
+    model.midiChannel = fs.midiChannel;
+    model.enabled = fs.enabled;
+    model.color = fs.color;
+}
 
-    display.setTextColor(textColor);
-    display.setTextSize(3);
-    display.setTextDatum(MC_DATUM);
-    display.drawString(fs.name, x + w / 2, y + 30);
+// Close a frame: record bytes pushed, or count it as skipped if nothing was drawn
+static void finishFrame(MultiTFT &display, DisplayFrameStats &stats) {
+    uint32_t bytes = display.bytesPushed();
+    display.resetBytesPushed();
+    if (bytes == 0) {
+        stats.framesSkipped++;
+        return;
+    }
+    stats.lastFrameBytes = bytes;
+    stats.totalBytes += bytes;
+    stats.framesDrawn++;
+}
 
-    display.setTextSize(2);
-    display.drawString("CC" + String(fs.midiCC) + " Ch" + String(fs.midiChannel), x + w / 2, y + 65);
+struct FrameTarget {
+    MultiTFT *display;
+    DisplayFrameStats *stats;
+};
+
+static FrameTarget footswitchFrame = {&footswitchDisplay, &footswitchDisplayStats};
+static FrameTarget configFrame = {&configDisplay, &configDisplayStats};
+
+static void frameLanded(void *context) {
+    FrameTarget *target = static_cast<FrameTarget *>(context);
+    finishFrame(*target->display, *target->stats);
 }
 
-// Draw the footswitch states screen (based on ST7796 current state screen)
-void drawFootswitchScreen() {
-    footswitchDisplay.select();
-    footswitchDisplay.fillScreen(BLACK);
-    footswitchDisplay.drawRect(0, 0, 480, 320, WHITE);
+// Queue the end of a frame: its stats close once the panel has drawn it
+static void queueFrameEnd(FrameTarget &target) {
+    displayBus.submit(*target.display, NULL, NULL, frameLanded, &target);
+}
 
-    const int switch_width = 220;
-    const int switch_height = 90;
+static void refreshView() {
+    lockConfig();
+    memcpy(viewSwitches, footswitches, sizeof(viewSwitches));
+    viewSelected = currentSelectedFootswitch;
+    viewBank = getActiveBank();
+    unlockConfig();
+    viewStatusBadge = statusBadgeVisible.load(std::memory_order_relaxed);
+}
+
+static void drawFootswitchBackground(MultiTFT &display, void *context) {
+    (void)context;
+    display.fillScreen(BLACK);
+    display.drawRect(0, 0, layout::panelWidth(FOOTSWITCH_ROTATION), layout::panelHeight(FOOTSWITCH_ROTATION), WHITE);
+}
+
+// Tiles draw from the view snapshot as it is when the bus gets to them
+static void drawTileBatch(MultiTFT &display, void *context) {
+    (void)display;
+    int i = (int)(intptr_t)context;
+    const TileOrigin &origin = FootswitchLayout::origin(i);
+    drawFootswitchTile(i, origin.x, origin.y, viewSwitches[i], i == viewSelected);
+}
 
-    const int row_y[] = {10, 115, 220};
-    const int col_x[] = {10, 250};
+// Queue a batch for every tile whose configuration or selection changed.
+// Tiles are blitted from the tile cache.
+static void queueFootswitchUpdate() {
+    if (!footswitchScreenValid) {
+        displayBus.submit(footswitchDisplay, drawFootswitchBackground, NULL);
+        footswitchScreenValid = true;
+    }
 
     for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
-        int row = i / 2;
-        int col = i % 2;
-        int x = col_x[col];
-        int y = row_y[row];
-        drawFootswitchTile(footswitchDisplay, x, y, switch_width, switch_height, footswitches[i]);
+        bool highlighted = (i == viewSelected);
+        if (tileMatches(tileModels[i], viewSwitches[i], highlighted)) continue;
+        displayBus.submit(footswitchDisplay, drawTileBatch, (void *)(intptr_t)i);
+        rememberTile(tileModels[i], viewSwitches[i], highlighted);
     }
 
-    footswitchDisplay.deselect();
+    queueFrameEnd(footswitchFrame);
 }
 
-// Draw the configuration/bank screen (based on ST7796 bank list screen)
-void drawConfigScreen() {
-    configDisplay.select();
-
-    // Determine background color; if no selection use BLACK
-    uint16_t backgroundColor = BLACK;
-    if (currentSelectedFootswitch >= 0 && currentSelectedFootswitch < NUM_FOOTSWITCHES) {
-        backgroundColor = footswitches[currentSelectedFootswitch].color;
+static void queueFootswitchScreen() {
+    footswitchScreenValid = false;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        tileModels[i].valid = false;
     }
+    queueFootswitchUpdate();
+}
+
+// Update footswitch display: repaint only tiles whose configuration or
+// selection changed
+void updateFootswitchDisplay() {
+    refreshView();
+    queueFootswitchUpdate();
+    displayBus.flush();
+}
+
+// Draw the footswitch states screen (based on ST7796 current state screen)
+void drawFootswitchScreen() {
+    refreshView();
+    queueFootswitchScreen();
+    displayBus.flush();
+}
+
+// Clear a full-width text field to the background colour
+static void redrawField(MultiTFT &display, int y, int height, uint16_t background) {
+    display.fillRect(FIELD_X, y, FIELD_WIDTH, height, background);
+}
+
+static void drawConfigBackground(MultiTFT &display, void *context) {
+    (void)context;
+    uint16_t primaryTextColor = getTextColorForBackground(configModel.background);
 
-    configDisplay.fillScreen(backgroundColor);
+    display.fillScreen(configModel.background);
+    display.drawRect(0, 0, 480, 320, primaryTextColor);
 
+    // Static navigation hints
+    display.setTextSize(2);
+    display.setTextColor(primaryTextColor);
+    display.setTextDatum(TL_DATUM);
+    display.drawString("<< PREV BANK", 30, 280);
+    display.setTextDatum(TR_DATUM);
+    display.drawString("NEXT BANK >>", 450, 280);
+}
+
+// Fields draw the model as it is when the bus gets to them, so a later
+// update queued before the flush only repeats work, never leaves stale text
+static void drawConfigField(MultiTFT &display, void *context) {
+    uintptr_t field = (uintptr_t)context;
+    char text[32];
+    bool clear = (field & CONFIG_FIELD_CLEAR) != 0;
+    uint16_t backgroundColor = configModel.background;
     uint16_t primaryTextColor = getTextColorForBackground(backgroundColor);
     uint16_t accentColor = (primaryTextColor == BLACK) ? WHITE : BLACK;
 
-    configDisplay.drawRect(0, 0, 480, 320, primaryTextColor);
-
-    // Title (guard against invalid selection)
-    String title = "";
-    if (currentSelectedFootswitch >= 0 && currentSelectedFootswitch < NUM_FOOTSWITCHES) {
-        title = footswitches[currentSelectedFootswitch].name;
+    display.setTextSize(2);
+    display.setTextDatum(TL_DATUM);
+    display.setTextColor(primaryTextColor);
+
+    switch (field & ~CONFIG_FIELD_CLEAR) {
+        case CONFIG_FIELD_TITLE:
+            if (clear) redrawField(display, TITLE_Y - 18, 36, backgroundColor);
+            drawCenteredTitle(display, configModel.title, primaryTextColor, TITLE_Y);
+            break;
+        case CONFIG_FIELD_ACTIVE_COUNT:
+            if (clear) redrawField(display, ACTIVE_COUNT_Y - 2, 20, backgroundColor);
+            snprintf(text, sizeof(text), "ACTIVE EFFECTS: %d", configModel.activeCount);
+            display.drawString(text, 20, ACTIVE_COUNT_Y);
+            break;
+        case CONFIG_FIELD_ACTIVE_NAMES:
+            if (clear) redrawField(display, ACTIVE_NAMES_Y - 2, 20, backgroundColor);
+            display.drawString(configModel.activeNames, 20, ACTIVE_NAMES_Y);
+            break;
+        case CONFIG_FIELD_MIDI_CHANNEL:
+            if (clear) redrawField(display, MIDI_CHANNEL_Y - 2, 28, backgroundColor);
+            display.setTextSize(3);
+            display.setTextColor(accentColor);
+            snprintf(text, sizeof(text), "MIDI CH: %u", (unsigned)configModel.midiChannel);
+            display.drawString(text, 20, MIDI_CHANNEL_Y);
+            break;
+        case CONFIG_FIELD_STATUS:
+            // The badge is a small box over the status line, never the whole panel
+            if (clear) {
+                display.fillRect(STATUS_BADGE_X, STATUS_Y - 4, STATUS_BADGE_WIDTH, STATUS_BADGE_HEIGHT, backgroundColor);
+            }
+            if (configModel.statusBadge) {
+                display.fillRect(STATUS_BADGE_X, STATUS_Y - 4, STATUS_BADGE_WIDTH, STATUS_BADGE_HEIGHT, YELLOW);
+                display.setTextColor(BLACK);
+                display.drawString("CONFIG UPDATED", STATUS_BADGE_X + 8, STATUS_Y);
+            } else {
+                display.drawString("SYSTEM READY", 20, STATUS_Y);
+            }
+            break;
+        case CONFIG_FIELD_BANK:
+            if (clear) redrawField(display, BANK_Y - 2, 20, backgroundColor);
+            snprintf(text, sizeof(text), "BANK %u/%u", (unsigned)(configModel.bank + 1), (unsigned)BANK_COUNT);
+            display.drawString(text, 20, BANK_Y);
+            break;
     }
-    drawCenteredTitle(configDisplay, title, primaryTextColor, 40);
+}
 
-    // Count active switches and build truncated list
-    int activeCount = 0;
-    String activeNames = "";
+static void queueConfigField(ConfigField field, bool dirty, bool fullRepaint) {
+    if (!dirty) return;
+    uintptr_t context = field | (fullRepaint ? 0 : CONFIG_FIELD_CLEAR);
+    displayBus.submit(configDisplay, drawConfigField, (void *)context);
+}
+
+// Comma-separated names of the enabled switches. A list longer than
+// ACTIVE_NAMES_MAX is cut to leave room for "..."
+static void buildActiveNames(char *out, int &activeCount) {
+    size_t length = 0;
+    bool truncated = false;
     for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
-        if (footswitches[i].enabled) {
-            ++activeCount;
-            if (activeNames.length() > 0) activeNames += ", ";
-            activeNames += footswitches[i].name;
+        if (!viewSwitches[i].enabled) continue;
+        ++activeCount;
+        const char *parts[2] = {length > 0 ? ", " : "", viewSwitches[i].name};
+        for (int p = 0; p < 2 && !truncated; ++p) {
+            for (const char *c = parts[p]; *c != '\0'; ++c) {
+                if (length == ACTIVE_NAMES_MAX) {
+                    truncated = true;
+                    break;
+                }
+                out[length++] = *c;
+            }
         }
     }
+    if (truncated) {
+        length = ACTIVE_NAMES_MAX - 3;
+        memcpy(out + length, "...", 3);
+        length += 3;
+    }
+    out[length] = '\0';
+}
 
-    configDisplay.setTextSize(2);
-    configDisplay.setTextDatum(TL_DATUM);
-    configDisplay.setTextColor(primaryTextColor);
-    configDisplay.drawString("ACTIVE EFFECTS: " + String(activeCount), 20, 90);
-
-    if (activeNames.length() > 35) {
-        activeNames = activeNames.substring(0, 32) + "...";
+// Queue batches for the text fields whose content changed. A new background
+// colour (selection of a differently coloured switch) still needs a full
+// repaint.
+static void queueConfigUpdate() {
+    // Determine background color; if no selection use BLACK
+    uint16_t backgroundColor = BLACK;
+    const char *title = "";
+    if (viewSelected >= 0 && viewSelected < NUM_FOOTSWITCHES) {
+        backgroundColor = viewSwitches[viewSelected].color;
+        title = viewSwitches[viewSelected].name;
     }
-    configDisplay.drawString(activeNames, 20, 120);
+
+    // Count active switches and build truncated list
+    int activeCount = 0;
+    char activeNames[ACTIVE_NAMES_MAX + 1];
+    buildActiveNames(activeNames, activeCount);
 
     // MIDI Channel info (uses footswitch 0 as original code did)
-    configDisplay.setTextSize(3);
-    configDisplay.setTextColor(accentColor);
-    configDisplay.drawString("MIDI CH: " + String(footswitches[0].midiChannel), 20, 160);
+    uint8_t midiChannel = viewSwitches[0].midiChannel;
+
+    bool fullRepaint = !configModel.valid || configModel.background != backgroundColor;
+    bool titleDirty = fullRepaint || strcmp(configModel.title, title) != 0;
+    bool countDirty = fullRepaint || configModel.activeCount != activeCount;
+    bool namesDirty = fullRepaint || strcmp(configModel.activeNames, activeNames) != 0;
+    bool channelDirty = fullRepaint || configModel.midiChannel != midiChannel;
+    bool bankDirty = fullRepaint || configModel.bank != viewBank;
+    bool statusDirty = fullRepaint || configModel.statusBadge != viewStatusBadge;
+
+    configModel.valid = true;
+    configModel.background = backgroundColor;
+    strcpy(configModel.title, title);
+    configModel.activeCount = activeCount;
+    strcpy(configModel.activeNames, activeNames);
+    configModel.midiChannel = midiChannel;
+    configModel.bank = viewBank;
+    configModel.statusBadge = viewStatusBadge;
+
+    if (fullRepaint) displayBus.submit(configDisplay, drawConfigBackground, NULL);
+    queueConfigField(CONFIG_FIELD_TITLE, titleDirty, fullRepaint);
+    queueConfigField(CONFIG_FIELD_ACTIVE_COUNT, countDirty, fullRepaint);
+    queueConfigField(CONFIG_FIELD_ACTIVE_NAMES, namesDirty, fullRepaint);
+    queueConfigField(CONFIG_FIELD_MIDI_CHANNEL, channelDirty, fullRepaint);
+    queueConfigField(CONFIG_FIELD_STATUS, statusDirty, fullRepaint);
+    queueConfigField(CONFIG_FIELD_BANK, bankDirty, fullRepaint);
+    queueFrameEnd(configFrame);
+}
 
-    // Status indicator and navigation
-    configDisplay.setTextSize(2);
-    configDisplay.setTextColor(primaryTextColor);
-    configDisplay.drawString("SYSTEM READY", 20, 200);
+// Update config display: repaint only the text fields whose content changed
+void updateConfigDisplay() {
+    refreshView();
+    queueConfigUpdate();
+    displayBus.flush();
+}
 
-    configDisplay.setTextDatum(TL_DATUM);
-    configDisplay.drawString("<< PREV BANK", 30, 280);
-    configDisplay.setTextDatum(TR_DATUM);
-    configDisplay.drawString("NEXT BANK >>", 450, 280);
+// Draw the configuration/bank screen (based on ST7796 bank list screen)
+void drawConfigScreen() {
+    refreshView();
+    configModel.valid = false;
+    queueConfigUpdate();
+    displayBus.flush();
+}
 
-    configDisplay.deselect();
+// Forget what is on the panels so the next update repaints everything.
+// Needed after anything draws outside the retained model (splash).
+void invalidateDisplays() {
+    footswitchScreenValid = false;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        tileModels[i].valid = false;
+    }
+    configModel.valid = false;
 }
 
-// Update footswitch display when states change
-void updateFootswitchDisplay() {
-    drawFootswitchScreen();
+// Flag a configuration change with the status badge for STATUS_BADGE_MS.
+// The screens keep showing the (already updated) configuration.
+void showStatusBadge() {
+    statusBadgeShownAt = millis();
+    if (!statusBadgeVisible.exchange(true, std::memory_order_relaxed)) {
+        postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_CONFIG);
+    }
 }
 
-// Update config display (can be called when configuration changes)
-void updateConfigDisplay() {
-    drawConfigScreen();
+void serviceStatusBadge() {
+    if (!statusBadgeVisible.load(std::memory_order_relaxed)) return;
+    if (millis() - statusBadgeShownAt < STATUS_BADGE_MS) return;
+    statusBadgeVisible.store(false, std::memory_order_relaxed);
+    postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_CONFIG);
 }
 
-// Small helper to show a centered message on a display
-static void showCenteredMessage(MultiTFT &display, const char *message, uint16_t color, int y) {
+static void drawLoadingBatch(MultiTFT &display, void *context) {
+    (void)context;
     display.fillScreen(BLACK);
     display.drawRect(0, 0, 480, 320, WHITE);
     display.setTextDatum(MC_DATUM);
-    display.setTextColor(color);
+    display.setTextColor(GREEN);
     display.setTextSize(4);
-    display.drawString(message, 240, y);
+    display.drawString("LOADING...", 240, 120);
+    display.setTextColor(WHITE);
+    display.setTextSize(2);
+    display.drawString("MIDI Footswitch Controller", 240, 180);
+    display.setTextSize(1);
+    display.drawString("Initializing System...", 240, 220);
 }
 
-// Show "CONFIGURING..." message on both displays
-void showConfiguringMessage() {
-    isConfiguring = true;
-    configuringStartTime = millis();
+// Show loading screen on both displays
+void showLoadingScreen() {
+    displayBus.submit(footswitchDisplay, drawLoadingBatch, NULL);
+    displayBus.submit(configDisplay, drawLoadingBatch, NULL);
+    queueFrameEnd(footswitchFrame);
+    queueFrameEnd(configFrame);
+    displayBus.flush();
+    invalidateDisplays();
+}
 
-    footswitchDisplay.select();
-    showCenteredMessage(footswitchDisplay, "CONFIGURING...", YELLOW, 160);
-    footswitchDisplay.deselect();
+// Report SPI traffic counters for both panels
+void sendDisplayStats() {
+    JsonDocument doc(responseArena.reset());
+    doc["type"] = "display_stats";
+    doc["status"] = "success";
+
+    JsonObject fs = doc["footswitch"].to<JsonObject>();
+    fs["last_frame_bytes"] = footswitchDisplayStats.lastFrameBytes;
+    fs["total_bytes"] = footswitchDisplayStats.totalBytes;
+    fs["frames_drawn"] = footswitchDisplayStats.framesDrawn;
+    fs["frames_skipped"] = footswitchDisplayStats.framesSkipped;
+
+    JsonObject cfg = doc["config"].to<JsonObject>();
+    cfg["last_frame_bytes"] = configDisplayStats.lastFrameBytes;
+    cfg["total_bytes"] = configDisplayStats.totalBytes;
+    cfg["frames_drawn"] = configDisplayStats.framesDrawn;
+    cfg["frames_skipped"] = configDisplayStats.framesSkipped;
+
+    JsonObject cache = doc["tile_cache"].to<JsonObject>();
+    cache["budget_bytes"] = tileCacheStats.budgetBytes;
+    cache["used_bytes"] = tileCacheStats.usedBytes;
+    cache["hits"] = tileCacheStats.hits;
+    cache["renders"] = tileCacheStats.renders;
+    cache["evictions"] = tileCacheStats.evictions;
+    cache["fallbacks"] = tileCacheStats.fallbacks;
+
+    JsonObject bus = doc["bus"].to<JsonObject>();
+    bus["batches"] = displayBus.batchesRun();
+    bus["panel_switches"] = displayBus.panelSwitches();
+    bus["dma_footswitch"] = footswitchDisplay.dmaEnabled();
+    bus["dma_config"] = configDisplay.dmaEnabled();
+
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+// Display task: producers post redraw requests into per-producer lock-free
+// queues and never touch SPI themselves. A request that is already pending
+// is not queued again, so a burst of presses costs one redraw.
+struct DisplayEventChannel {
+    SpscQueue<DisplayEvent, DISPLAY_EVENT_QUEUE_SIZE> queue;
+    std::atomic<uint8_t> pending;
+};
+
+// Coalescing bounds each queue to one entry per event type, so it cannot fill
+static_assert(DISPLAY_EVENT_QUEUE_SIZE > 4, "display event queue too small");
+
+static DisplayEventChannel displayChannels[DISPLAY_PRODUCER_COUNT];
+static TaskHandle_t displayTaskHandle = NULL;
+
+void postDisplayEvent(DisplayProducer producer, DisplayEvent event) {
+    DisplayEventChannel &channel = displayChannels[producer];
+
+    // Coalesce: skip if the same request is still waiting to be drawn
+    uint8_t previous = channel.pending.fetch_or(event, std::memory_order_acq_rel);
+    if (previous & event) return;
 
-    configDisplay.select();
-    showCenteredMessage(configDisplay, "CONFIGURING...", YELLOW, 160);
-    configDisplay.deselect();
+    channel.queue.push(event);
+
+    if (displayTaskHandle != NULL) {
+        xTaskNotifyGive(displayTaskHandle);
+    }
+}
+
+// Queue the drawing for one event; the caller flushes the bus
+static void handleDisplayEvent(DisplayEvent event) {
+    switch (event) {
+        case DISPLAY_EVENT_FOOTSWITCH:
+            queueFootswitchUpdate();
+            break;
+        case DISPLAY_EVENT_CONFIG:
+            queueConfigUpdate();
+            break;
+    }
 }
 
-// Hide configuring message and restore normal displays
-void hideConfiguringMessage() {
-    isConfiguring = false;
+// Draw everything requested since the last pass and return the events
+// handled (0 if none). Trace replay calls it directly.
+uint8_t serviceDisplayEvents() {
+    // Take the whole burst first, so one snapshot and one flush of the
+    // bus serve it and both panels' batches can interleave
+    DisplayEvent events[DISPLAY_PRODUCER_COUNT * DISPLAY_EVENT_QUEUE_SIZE];
+    int eventCount = 0;
+    uint8_t handled = 0;
+    for (int p = 0; p < DISPLAY_PRODUCER_COUNT; ++p) {
+        DisplayEventChannel &channel = displayChannels[p];
+        DisplayEvent event;
+        while (channel.queue.pop(event)) {
+            // Clear before drawing so a request made mid-draw is not lost
+            channel.pending.fetch_and((uint8_t)~event, std::memory_order_acq_rel);
+            events[eventCount++] = event;
+            handled |= event;
+        }
+    }
+    if (eventCount == 0) return 0;
+
+    uint32_t drawStartUs = micros();
+    refreshView();
+    for (int i = 0; i < eventCount; ++i) {
+        handleDisplayEvent(events[i]);
+    }
+    displayBus.flush();
+    recordLatency(HIST_REDRAW, micros() - drawStartUs);
+    return handled;
+}
+
+// Panel reset and the first full paint, done by the display task after
+// setup() has made the switches live. Redraw requests that arrive meanwhile
+// wait in their queues and are served right after.
+void bringUpDisplays() {
+    initializeDisplays();
+    markBootStage(BOOT_STAGE_DISPLAY_INIT);
     drawFootswitchScreen();
     drawConfigScreen();
+    markBootStage(BOOT_STAGE_FIRST_PAINT);
 }
 
-// Show loading screen on both displays
-void showLoadingScreen() {
-    footswitchDisplay.select();
-    footswitchDisplay.fillScreen(BLACK);
-    footswitchDisplay.drawRect(0, 0, 480, 320, WHITE);
-    footswitchDisplay.setTextDatum(MC_DATUM);
-    footswitchDisplay.setTextColor(GREEN);
-    footswitchDisplay.setTextSize(4);
-    footswitchDisplay.drawString("LOADING...", 240, 120);
-    footswitchDisplay.setTextColor(WHITE);
-    footswitchDisplay.setTextSize(2);
-    footswitchDisplay.drawString("MIDI Footswitch Controller", 240, 180);
-    footswitchDisplay.setTextSize(1);
-    footswitchDisplay.drawString("Initializing System...", 240, 220);
-    footswitchDisplay.deselect();
-
-    configDisplay.select();
-    configDisplay.fillScreen(BLACK);
-    configDisplay.drawRect(0, 0, 480, 320, WHITE);
-    configDisplay.setTextDatum(MC_DATUM);
-    configDisplay.setTextColor(GREEN);
-    configDisplay.setTextSize(4);
-    configDisplay.drawString("LOADING...", 240, 120);
-    configDisplay.setTextColor(WHITE);
-    configDisplay.setTextSize(2);
-    configDisplay.drawString("MIDI Footswitch Controller", 240, 180);
-    configDisplay.setTextSize(1);
-    configDisplay.drawString("Initializing System...", 240, 220);
-    configDisplay.deselect();
-}
\ No newline at end of file
+static void displayTask(void *parameter) {
+    bringUpDisplays();
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        serviceDisplayEvents();
+    }
+}
+
+void startDisplayTask() {
+    xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_TASK_STACK_SIZE, NULL,
+                            DISPLAY_TASK_PRIORITY, &displayTaskHandle, DISPLAY_TASK_CORE);
+    printJsonLog("info", "Display task started, panels initializing");
+}
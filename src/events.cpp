@@ -0,0 +1,173 @@
+#include "events.h"
+#include "mpsc_queue.h"
+#include "midi.h"
+#include "gestures.h"
+#include "stats.h"
+
+EventStats eventStats = {0, 0, 0};
+std::atomic<uint8_t> subscribedEvents(0);
+
+static const char *KIND_NAMES[HOST_EVENT_KIND_COUNT] = {"switch", "gesture", "midi", "config"};
+static const char *SOURCE_NAMES[MIDI_PRODUCER_COUNT + 1] = {"input", "host", "thru", "pedal"};
+static const char *CONFIG_NAMES[CONFIG_EVENT_COUNT] = {"bank", "set", "patch", "saved", "pedals"};
+
+static MpscQueue<HostEventRecord, EVENT_RING_SIZE> eventRing;
+static std::atomic<uint32_t> droppedCount(0);
+
+// Arduino loop only
+static uint32_t poppedCount = 0;      // Records taken from the ring, written or discarded
+static uint32_t reportedDrops = 0;    // Drops already covered by a "dropped" line
+static HostEventRecord heldRecord;    // Waits behind the "dropped" line that precedes it
+static bool recordHeld = false;
+static char pendingLine[EVENT_LINE_MAX_LENGTH];
+static size_t pendingLength = 0;      // Formatted, waiting for room in the UART
+
+void initializeEvents() {
+    subscribedEvents.store(0, std::memory_order_relaxed);
+    eventRing.clear();
+    droppedCount.store(0, std::memory_order_relaxed);
+    poppedCount = 0;
+    reportedDrops = 0;
+    recordHeld = false;
+    pendingLength = 0;
+}
+
+bool postHostEvent(HostEventKind kind, uint8_t code, uint8_t index, uint32_t timeUs,
+                   uint8_t data0, uint8_t data1) {
+    if (!isEventSubscribed(kind)) return false;
+
+    HostEventRecord record;
+    record.timeUs = timeUs;
+    record.dropsBefore = droppedCount.load(std::memory_order_relaxed);
+    record.kind = kind;
+    record.code = code;
+    record.index = index;
+    record.data[0] = data0;
+    record.data[1] = data1;
+    if (!eventRing.push(record)) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool parseEventKind(const char *name, HostEventKind &kind) {
+    for (uint8_t i = 0; i < HOST_EVENT_KIND_COUNT; ++i) {
+        if (strcmp(name, KIND_NAMES[i]) == 0) {
+            kind = (HostEventKind)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *eventKindName(uint8_t kind) {
+    return kind < HOST_EVENT_KIND_COUNT ? KIND_NAMES[kind] : "unknown";
+}
+
+uint32_t subscribeEvents(uint8_t mask) {
+    subscribedEvents.store(0, std::memory_order_relaxed);
+    HostEventRecord record;
+    while (eventRing.pop(record)) ++poppedCount;
+    reportedDrops = droppedCount.load(std::memory_order_relaxed);
+    recordHeld = false;
+    pendingLength = 0;
+    subscribedEvents.store(mask, std::memory_order_relaxed);
+    return poppedCount + reportedDrops;
+}
+
+static void formatDropped(uint32_t count) {
+    int length = snprintf(pendingLine, sizeof(pendingLine), "{\"ev\":\"dropped\",\"seq\":%lu,\"count\":%lu}\r\n",
+                          (unsigned long)(poppedCount + reportedDrops), (unsigned long)count);
+    pendingLength = min((size_t)length, sizeof(pendingLine) - 1);
+    reportedDrops += count;
+}
+
+static void formatRecord(const HostEventRecord &r, uint32_t sequence) {
+    uint32_t nowUs = micros();
+    // MIDI events carry the time the block will have left the pin, which can be ahead of now
+    uint32_t ageUs = (int32_t)(nowUs - r.timeUs) > 0 ? nowUs - r.timeUs : 0;
+    recordLatency(HIST_EVENT_DELIVERY, ageUs);
+
+    char *line = pendingLine;
+    size_t size = sizeof(pendingLine) - 2;
+    int length = snprintf(line, size, "{\"ev\":\"%s\",\"seq\":%lu,\"t\":%lu,\"age\":%lu", eventKindName(r.kind),
+                          (unsigned long)sequence, (unsigned long)r.timeUs,
+                          (unsigned long)ageUs);
+    switch (r.kind) {
+        case HOST_EVENT_SWITCH:
+            length += snprintf(line + length, size - length, ",\"id\":%u,\"state\":\"%s\"}", r.index,
+                               r.code ? "down" : "up");
+            break;
+        case HOST_EVENT_GESTURE:
+            length += snprintf(line + length, size - length, ",\"id\":%u,\"gesture\":\"%s\"}", r.index,
+                               gestureEventName(r.code));
+            break;
+        case HOST_EVENT_MIDI:
+            length += snprintf(line + length, size - length, ",\"source\":\"%s\",\"status\":%u,\"length\":%u}",
+                               r.code <= MIDI_PRODUCER_COUNT ? SOURCE_NAMES[r.code] : "unknown", r.data[0],
+                               r.data[1]);
+            break;
+        default:
+            length += snprintf(line + length, size - length, ",\"change\":\"%s\"",
+                               r.code < CONFIG_EVENT_COUNT ? CONFIG_NAMES[r.code] : "unknown");
+            if (r.code == CONFIG_EVENT_BANK || r.code == CONFIG_EVENT_SET || r.code == CONFIG_EVENT_PATCH) {
+                length += snprintf(line + length, size - length, ",\"bank\":%u", r.index);
+            }
+            if (r.code == CONFIG_EVENT_PATCH && r.data[0] != EVENT_NO_SWITCH) {
+                length += snprintf(line + length, size - length, ",\"id\":%u", r.data[0]);
+            }
+            length += snprintf(line + length, size - length, "}");
+            break;
+    }
+    length = min((size_t)length, size - 1);
+    line[length++] = '\r';
+    line[length++] = '\n';
+    pendingLength = length;
+}
+
+// Format the next line: a held record, a "dropped" marker, or a new record
+static bool formatNext() {
+    if (recordHeld) {
+        recordHeld = false;
+        formatRecord(heldRecord, poppedCount + reportedDrops);
+        ++poppedCount;
+        return true;
+    }
+
+    HostEventRecord record;
+    if (!eventRing.pop(record)) {
+        // Events dropped after the last one in the ring
+        uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+        if (dropped == reportedDrops) return false;
+        formatDropped(dropped - reportedDrops);
+        return true;
+    }
+    // Events were dropped since the previous record: say so before this one
+    if ((int32_t)(record.dropsBefore - reportedDrops) > 0) {
+        heldRecord = record;
+        recordHeld = true;
+        formatDropped(record.dropsBefore - reportedDrops);
+        return true;
+    }
+    formatRecord(record, poppedCount + reportedDrops);
+    ++poppedCount;
+    return true;
+}
+
+// Arduino loop: write what the host UART takes without blocking. A line
+// that does not fit waits for the next pass, and everything behind it
+// waits in the ring.
+void serviceEvents() {
+    eventStats.posted = eventRing.pushed();
+    eventStats.dropped = droppedCount.load(std::memory_order_relaxed);
+    if (subscribedEvents.load(std::memory_order_relaxed) == 0) return;
+
+    for (int i = 0; i < EVENT_FLUSH_PER_PASS; ++i) {
+        if (pendingLength == 0 && !formatNext()) break;
+        if ((size_t)Serial.availableForWrite() < pendingLength) break;
+        Serial.write((const uint8_t *)pendingLine, pendingLength);
+        pendingLength = 0;
+        ++eventStats.sent;
+    }
+}
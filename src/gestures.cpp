@@ -0,0 +1,188 @@
+#include "gestures.h"
+#include "config.h"
+
+enum GesturePhase : uint8_t {
+    PHASE_IDLE,
+    PHASE_DOWN,
+    PHASE_TAPPED,   // Released after a short tap, waiting for a second one
+};
+
+struct GestureState {
+    uint8_t phase;
+    uint8_t mask;           // Bound events, copied at the press
+    bool pressPending;      // Press held back for a possible double tap
+    bool longFired;
+    uint32_t pressUs;
+    uint32_t releaseUs;
+    uint32_t nextRepeatUs;
+    uint32_t longPressUs;
+    uint32_t doubleTapUs;
+    uint32_t repeatDelayUs;
+    uint32_t repeatIntervalUs;
+};
+
+static_assert(NUM_FOOTSWITCHES <= 32, "gesture activity is tracked in one word");
+
+static const char *EVENT_NAMES[GESTURE_EVENT_COUNT] = {
+    "press", "release", "long_press", "double_tap", "hold_repeat"
+};
+
+static GestureHandler gestureHandler = NULL;
+static GestureState states[NUM_FOOTSWITCHES];
+static uint32_t activeSwitches = 0;   // Bit per switch that is not idle
+
+void initializeGestures(GestureHandler handler) {
+    gestureHandler = handler;
+    memset(states, 0, sizeof(states));
+    activeSwitches = 0;
+}
+
+void setDefaultGestures(GestureConfig &gestures) {
+    memset(&gestures, 0, sizeof(gestures));
+    gestures.longPressMs = GESTURE_LONG_PRESS_MS;
+    gestures.doubleTapMs = GESTURE_DOUBLE_TAP_MS;
+    gestures.repeatDelayMs = GESTURE_REPEAT_DELAY_MS;
+    gestures.repeatIntervalMs = GESTURE_REPEAT_INTERVAL_MS;
+}
+
+uint8_t gestureBindingMask(const GestureConfig &gestures) {
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < GESTURE_BINDING_COUNT; ++i) {
+        uint8_t kind = gestures.bindings[i].kind;
+        if (kind != GESTURE_ACTION_NONE && kind < GESTURE_ACTION_KIND_COUNT) {
+            mask |= gestureBit((GestureEvent)(i + 1));
+        }
+    }
+    return mask;
+}
+
+const char *gestureEventName(uint8_t event) {
+    return event < GESTURE_EVENT_COUNT ? EVENT_NAMES[event] : "unknown";
+}
+
+static void emit(int switchIndex, GestureEvent event, uint32_t timeUs) {
+    if (gestureHandler != NULL) gestureHandler(switchIndex, event, timeUs);
+}
+
+static void setIdle(int switchIndex) {
+    states[switchIndex].phase = PHASE_IDLE;
+    activeSwitches &= ~(1u << switchIndex);
+}
+
+// Deliver a press that was held back, before anything that follows it
+static void releasePendingPress(int switchIndex) {
+    GestureState &s = states[switchIndex];
+    if (!s.pressPending) return;
+    s.pressPending = false;
+    emit(switchIndex, GESTURE_PRESS, s.pressUs);
+}
+
+// The double-tap window closed on a single tap: report it as it happened
+static void finishTap(int switchIndex) {
+    GestureState &s = states[switchIndex];
+    releasePendingPress(switchIndex);
+    setIdle(switchIndex);
+    emit(switchIndex, GESTURE_RELEASE, s.releaseUs);
+}
+
+static void startHold(GestureState &s, uint32_t edgeUs) {
+    s.phase = PHASE_DOWN;
+    s.pressUs = edgeUs;
+    s.longFired = false;
+    s.nextRepeatUs = edgeUs + s.repeatDelayUs;
+}
+
+// A press on another switch ends every double-tap wait, so held-back
+// presses go out before the new one and the last switch pressed ends up
+// selected
+static void settleOtherSwitches(int switchIndex) {
+    uint32_t others = activeSwitches & ~(1u << switchIndex);
+    for (int i = 0; others != 0; ++i, others >>= 1) {
+        if (!(others & 1)) continue;
+        if (states[i].phase == PHASE_TAPPED) {
+            finishTap(i);
+        } else {
+            releasePendingPress(i);
+        }
+    }
+}
+
+void gestureSwitchDown(int switchIndex, uint32_t edgeUs) {
+    if (switchIndex < 0 || switchIndex >= NUM_FOOTSWITCHES) return;
+    GestureState &s = states[switchIndex];
+    settleOtherSwitches(switchIndex);
+
+    if (s.phase == PHASE_TAPPED) {
+        if (edgeUs - s.releaseUs <= s.doubleTapUs) {
+            s.pressPending = false;
+            startHold(s, edgeUs);
+            emit(switchIndex, GESTURE_DOUBLE_TAP, edgeUs);
+            return;
+        }
+        finishTap(switchIndex);
+    }
+
+    lockConfig();
+    const FootswitchConfig &fs = footswitches[switchIndex];
+    s.mask = fs.gestureMask;
+    s.longPressUs = fs.gestures.longPressMs * 1000UL;
+    s.doubleTapUs = fs.gestures.doubleTapMs * 1000UL;
+    s.repeatDelayUs = fs.gestures.repeatDelayMs * 1000UL;
+    s.repeatIntervalUs = fs.gestures.repeatIntervalMs * 1000UL;
+    unlockConfig();
+
+    startHold(s, edgeUs);
+    activeSwitches |= 1u << switchIndex;
+    s.pressPending = (s.mask & gestureBit(GESTURE_DOUBLE_TAP)) != 0;
+    if (!s.pressPending) emit(switchIndex, GESTURE_PRESS, edgeUs);
+}
+
+void gestureSwitchUp(int switchIndex, uint32_t edgeUs) {
+    if (switchIndex < 0 || switchIndex >= NUM_FOOTSWITCHES) return;
+    GestureState &s = states[switchIndex];
+    if (s.phase != PHASE_DOWN) return;
+
+    if (s.pressPending && edgeUs - s.pressUs <= s.doubleTapUs) {
+        // A tap: the press and this release wait for the window to close
+        s.phase = PHASE_TAPPED;
+        s.releaseUs = edgeUs;
+        return;
+    }
+    releasePendingPress(switchIndex);
+    setIdle(switchIndex);
+    emit(switchIndex, GESTURE_RELEASE, edgeUs);
+}
+
+static void serviceHeld(int switchIndex, uint32_t nowUs) {
+    GestureState &s = states[switchIndex];
+    uint32_t heldUs = nowUs - s.pressUs;
+
+    if (heldUs > s.doubleTapUs) releasePendingPress(switchIndex);
+
+    if ((s.mask & gestureBit(GESTURE_LONG_PRESS)) && !s.longFired && heldUs >= s.longPressUs) {
+        releasePendingPress(switchIndex);
+        s.longFired = true;
+        emit(switchIndex, GESTURE_LONG_PRESS, nowUs);
+    }
+
+    if ((s.mask & gestureBit(GESTURE_HOLD_REPEAT)) && (int32_t)(nowUs - s.nextRepeatUs) >= 0) {
+        releasePendingPress(switchIndex);
+        emit(switchIndex, GESTURE_HOLD_REPEAT, nowUs);
+        s.nextRepeatUs += s.repeatIntervalUs;
+        // After a stall, repeat from now rather than in a burst
+        if ((int32_t)(nowUs - s.nextRepeatUs) >= 0) s.nextRepeatUs = nowUs + s.repeatIntervalUs;
+    }
+}
+
+void serviceGestures(uint32_t nowUs) {
+    if (activeSwitches == 0) return;
+
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        if (!(activeSwitches & (1u << i))) continue;
+        if (states[i].phase == PHASE_TAPPED) {
+            if (nowUs - states[i].releaseUs > states[i].doubleTapUs) finishTap(i);
+        } else {
+            serviceHeld(i, nowUs);
+        }
+    }
+}
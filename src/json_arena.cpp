@@ -0,0 +1,81 @@
+#include "json_arena.h"
+
+// Every block is prefixed with its size so reallocate() can copy it
+struct ArenaBlockHeader {
+    uint32_t size;
+    uint32_t reserved;  // Keeps the payload 8-byte aligned
+};
+
+static const size_t ARENA_ALIGNMENT = 8;
+
+static size_t alignUp(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static ArenaBlockHeader *headerOf(void *ptr) {
+    return reinterpret_cast<ArenaBlockHeader *>(static_cast<uint8_t *>(ptr) - sizeof(ArenaBlockHeader));
+}
+
+JsonArena::JsonArena(uint8_t *buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _used(0), _peak(0), _failures(0), _lastBlock(NULL) {}
+
+ArduinoJson::Allocator *JsonArena::reset() {
+    _used = 0;
+    _lastBlock = NULL;
+    return this;
+}
+
+void *JsonArena::allocate(size_t size) {
+    size_t needed = sizeof(ArenaBlockHeader) + alignUp(size);
+    if (_used + needed > _capacity) {
+        ++_failures;
+        return NULL;
+    }
+
+    ArenaBlockHeader *header = reinterpret_cast<ArenaBlockHeader *>(_buffer + _used);
+    header->size = size;
+    _used += needed;
+    if (_used > _peak) _peak = _used;
+
+    _lastBlock = reinterpret_cast<uint8_t *>(header + 1);
+    return _lastBlock;
+}
+
+void JsonArena::deallocate(void *ptr) {
+    // Only the most recent block can be given back; the rest waits for reset()
+    if (ptr != NULL && ptr == _lastBlock) {
+        _used = (_lastBlock - _buffer) - sizeof(ArenaBlockHeader);
+        _lastBlock = NULL;
+    }
+}
+
+void *JsonArena::reallocate(void *ptr, size_t newSize) {
+    if (ptr == NULL) return allocate(newSize);
+
+    ArenaBlockHeader *header = headerOf(ptr);
+
+    // The last block can grow or shrink in place
+    if (ptr == _lastBlock) {
+        size_t start = _lastBlock - _buffer;
+        size_t end = start + alignUp(newSize);
+        if (end > _capacity) {
+            ++_failures;
+            return NULL;
+        }
+        header->size = newSize;
+        _used = end;
+        if (_used > _peak) _peak = _used;
+        return ptr;
+    }
+
+    if (newSize <= header->size) {
+        header->size = newSize;
+        return ptr;
+    }
+
+    void *moved = allocate(newSize);
+    if (moved != NULL) {
+        memcpy(moved, ptr, header->size);
+    }
+    return moved;
+}
@@ -0,0 +1,326 @@
+#include "ladder.h"
+#include "utils.h"
+#include "spsc_queue.h"
+#include "pedals.h"
+#include "trace.h"
+#include <Preferences.h>
+#include <atomic>
+
+// Factory thresholds used until the ladder is calibrated: switch i reads
+// from i * LADDER_FACTORY_STEP up to the next switch's threshold; the last
+// switch takes everything above its own
+static_assert(NUM_FOOTSWITCHES * LADDER_FACTORY_STEP < LADDER_ADC_CODES,
+              "factory ladder thresholds exceed the ADC range");
+
+static const char *CALIBRATION_NAMESPACE = "midi-config";
+static const char *CALIBRATION_KEY = "ladder_cal";
+
+static hw_timer_t *ladderTimer = NULL;
+static TaskHandle_t samplerTaskHandle = NULL;
+static TaskHandle_t consumerTaskHandle = NULL;
+
+static uint32_t sampleRateHz = LADDER_SAMPLE_RATE_HZ;
+static volatile uint32_t tickTimestampUs = 0;
+static uint32_t overruns = 0;
+static volatile uint16_t lastFilteredValue = 0;
+
+// Two tables so a rebuild never changes entries under the input task
+static int8_t ladderTables[2][LADDER_ADC_CODES];
+static std::atomic<const int8_t *> activeTable(nullptr);
+
+static LadderCalibration calibration;         // Being captured
+static LadderCalibration appliedCalibration;  // Behind the active table, if calibrated
+static bool calibrated = false;
+
+// Sampler task -> input task
+static SpscQueue<LadderSample, LADDER_QUEUE_SIZE> sampleQueue;
+
+static void IRAM_ATTR onLadderTimer() {
+    tickTimestampUs = (uint32_t)esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(samplerTaskHandle, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+// Median of the last LADDER_MEDIAN_TAPS raw reads (insertion sort on a copy)
+static uint16_t medianOf(const uint16_t *window) {
+    uint16_t sorted[LADDER_MEDIAN_TAPS];
+    for (int i = 0; i < LADDER_MEDIAN_TAPS; ++i) {
+        uint16_t v = window[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            --j;
+        }
+        sorted[j] = v;
+    }
+    return sorted[LADDER_MEDIAN_TAPS / 2];
+}
+
+static void samplerTask(void *parameter) {
+    uint16_t window[LADDER_MEDIAN_TAPS] = {0};
+    uint8_t windowPos = 0;
+    uint8_t filled = 0;
+    uint8_t pedalTick = 0;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t timestamp = tickTimestampUs;
+
+        // Expression pedals share the timer at a lower rate
+        if (++pedalTick == PEDAL_SAMPLE_DIVIDER) {
+            pedalTick = 0;
+            samplePedals();
+        }
+
+        window[windowPos] = (uint16_t)analogRead(FOOTSWITCH_LADDER_PIN);
+        windowPos = (windowPos + 1) % LADDER_MEDIAN_TAPS;
+        if (filled < LADDER_MEDIAN_TAPS) {
+            ++filled;
+            continue;
+        }
+
+        LadderSample sample = {medianOf(window), timestamp};
+        lastFilteredValue = sample.value;
+        traceLadderSample(sample);
+        queueLadderSample(sample);
+    }
+}
+
+void initializeLadderSampler(uint32_t rateHz) {
+    sampleRateHz = rateHz;
+
+    xTaskCreatePinnedToCore(samplerTask, "ladder", LADDER_TASK_STACK_SIZE, NULL,
+                            LADDER_TASK_PRIORITY, &samplerTaskHandle, LADDER_TASK_CORE);
+
+    // 80 MHz APB / 80 = 1 MHz timer clock
+    ladderTimer = timerBegin(LADDER_TIMER_ID, 80, true);
+    timerAttachInterrupt(ladderTimer, &onLadderTimer, true);
+    timerAlarmWrite(ladderTimer, 1000000UL / sampleRateHz, true);
+    timerAlarmEnable(ladderTimer);
+
+    printJsonLogf("info", "Ladder sampler running at %u Hz", (unsigned)sampleRateHz);
+}
+
+// Task to notify whenever new samples are queued
+void attachLadderConsumer(TaskHandle_t task) {
+    consumerTaskHandle = task;
+}
+
+// Sampler task, or a trace replay standing in for it
+bool queueLadderSample(const LadderSample &sample) {
+    if (!sampleQueue.push(sample)) {
+        ++overruns;
+        return false;
+    }
+    if (consumerTaskHandle != NULL) {
+        xTaskNotifyGive(consumerTaskHandle);
+    }
+    return true;
+}
+
+bool readLadderSample(LadderSample &sample) {
+    return sampleQueue.pop(sample);
+}
+
+uint32_t getLadderSampleRate() {
+    return sampleRateHz;
+}
+
+uint32_t getLadderOverruns() {
+    return overruns;
+}
+
+uint16_t getLadderValue() {
+    return lastFilteredValue;
+}
+
+int classifyLadder(uint16_t value, int previous) {
+    const int8_t *table = activeTable.load(std::memory_order_acquire);
+    int8_t entry = table[value & (LADDER_ADC_CODES - 1)];
+    return (entry == LADDER_HOLD) ? previous : entry;
+}
+
+// Fill the inactive table from bandCount bands (ids in ascending ADC order)
+// separated by bandCount - 1 boundaries, then publish it. Each boundary gets
+// a LADDER_HOLD guard band so a reading sitting between two levels keeps the
+// previous classification instead of toggling.
+static void buildLadderTable(int bandCount, const int8_t *ids, const uint16_t *boundaries) {
+    const int8_t *current = activeTable.load(std::memory_order_acquire);
+    int8_t *table = (current == ladderTables[0]) ? ladderTables[1] : ladderTables[0];
+
+    int band = 0;
+    for (int code = 0; code < LADDER_ADC_CODES; ++code) {
+        while (band < bandCount - 1 && code >= boundaries[band]) {
+            ++band;
+        }
+        table[code] = ids[band];
+    }
+
+    for (int b = 0; b < bandCount - 1; ++b) {
+        int lower = (b == 0) ? 0 : boundaries[b - 1];
+        int upper = (b + 2 < bandCount) ? boundaries[b + 1] : LADDER_ADC_CODES;
+        int narrower = min((int)boundaries[b] - lower, upper - (int)boundaries[b]);
+        int guard = narrower * LADDER_GUARD_PERCENT / 100;
+        int from = max(0, (int)boundaries[b] - guard);
+        int to = min(LADDER_ADC_CODES, (int)boundaries[b] + guard);
+        for (int code = from; code < to; ++code) {
+            table[code] = LADDER_HOLD;
+        }
+    }
+
+    activeTable.store(table, std::memory_order_release);
+}
+
+static void buildDefaultLadderTable() {
+    int8_t ids[NUM_FOOTSWITCHES];
+    uint16_t boundaries[NUM_FOOTSWITCHES - 1];
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        ids[i] = i;
+        if (i > 0) boundaries[i - 1] = i * LADDER_FACTORY_STEP;
+    }
+    buildLadderTable(NUM_FOOTSWITCHES, ids, boundaries);
+}
+
+// Sort captured levels and place boundaries halfway between neighbours.
+// Returns false (with a reason) if a level is missing or two are too close.
+static bool buildCalibratedLadderTable(const LadderCalibration &cal, char *error, size_t errorSize) {
+    const int maxBands = NUM_FOOTSWITCHES + 1;
+    int8_t ids[maxBands];
+    uint16_t levels[maxBands];
+    int bandCount = 0;
+
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        if (cal.levels[i] == LADDER_LEVEL_UNSET) {
+            snprintf(error, errorSize, "Switch %d not calibrated", i + 1);
+            return false;
+        }
+        ids[bandCount] = i;
+        levels[bandCount] = cal.levels[i];
+        ++bandCount;
+    }
+    if (cal.idleLevel != LADDER_LEVEL_UNSET) {
+        ids[bandCount] = LADDER_NONE;
+        levels[bandCount] = cal.idleLevel;
+        ++bandCount;
+    }
+
+    // Insertion sort by level (at most NUM_FOOTSWITCHES + 1 entries)
+    for (int i = 1; i < bandCount; ++i) {
+        int8_t id = ids[i];
+        uint16_t level = levels[i];
+        int j = i;
+        while (j > 0 && levels[j - 1] > level) {
+            ids[j] = ids[j - 1];
+            levels[j] = levels[j - 1];
+            --j;
+        }
+        ids[j] = id;
+        levels[j] = level;
+    }
+
+    uint16_t boundaries[maxBands - 1];
+    for (int i = 0; i < bandCount - 1; ++i) {
+        if (levels[i + 1] - levels[i] < LADDER_MIN_LEVEL_GAP) {
+            snprintf(error, errorSize, "Ladder levels too close together");
+            return false;
+        }
+        boundaries[i] = (levels[i] + levels[i + 1]) / 2;
+    }
+
+    buildLadderTable(bandCount, ids, boundaries);
+    appliedCalibration = cal;
+    return true;
+}
+
+static void clearCalibration() {
+    calibration.version = LADDER_CALIBRATION_VERSION;
+    calibration.idleLevel = LADDER_LEVEL_UNSET;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        calibration.levels[i] = LADDER_LEVEL_UNSET;
+    }
+}
+
+// Load the stored calibration, falling back to the factory thresholds
+void loadLadderCalibration() {
+    clearCalibration();
+    calibrated = false;
+
+    Preferences prefs;
+    prefs.begin(CALIBRATION_NAMESPACE, true);
+    LadderCalibration stored;
+    size_t length = prefs.getBytes(CALIBRATION_KEY, &stored, sizeof(stored));
+    prefs.end();
+
+    char error[48];
+    if (length == sizeof(stored) && stored.version == LADDER_CALIBRATION_VERSION &&
+        buildCalibratedLadderTable(stored, error, sizeof(error))) {
+        calibration = stored;
+        calibrated = true;
+        printJsonLog("info", "Ladder calibration loaded");
+        return;
+    }
+
+    buildDefaultLadderTable();
+    printJsonLog("info", "Using default ladder thresholds");
+}
+
+// Record the current filtered reading as the level of switchId (-1 = idle)
+uint16_t captureLadderLevel(int switchId) {
+    uint16_t value = getLadderValue();
+    if (switchId < 0) {
+        calibration.idleLevel = value;
+    } else if (switchId < NUM_FOOTSWITCHES) {
+        calibration.levels[switchId] = value;
+    }
+    return value;
+}
+
+// Rebuild the table from captured levels and persist them
+bool saveLadderCalibration(char *error, size_t errorSize) {
+    if (!buildCalibratedLadderTable(calibration, error, errorSize)) {
+        return false;
+    }
+
+    Preferences prefs;
+    prefs.begin(CALIBRATION_NAMESPACE, false);
+    prefs.putBytes(CALIBRATION_KEY, &calibration, sizeof(calibration));
+    prefs.end();
+
+    calibrated = true;
+    printJsonLog("info", "Ladder calibration saved");
+    return true;
+}
+
+// Forget the stored calibration and return to the factory thresholds
+void resetLadderCalibration() {
+    Preferences prefs;
+    prefs.begin(CALIBRATION_NAMESPACE, false);
+    prefs.remove(CALIBRATION_KEY);
+    prefs.end();
+
+    clearCalibration();
+    calibrated = false;
+    buildDefaultLadderTable();
+    printJsonLog("info", "Ladder calibration reset");
+}
+
+bool isLadderCalibrated() {
+    return calibrated;
+}
+
+bool getLadderCalibration(LadderCalibration &cal) {
+    if (!calibrated) return false;
+    cal = appliedCalibration;
+    return true;
+}
+
+// Classify with the given levels without storing them (trace replay)
+bool useLadderCalibration(const LadderCalibration &cal, char *error, size_t errorSize) {
+    if (!buildCalibratedLadderTable(cal, error, errorSize)) {
+        return false;
+    }
+    calibration = cal;
+    calibrated = true;
+    return true;
+}
@@ -0,0 +1,49 @@
+#include "log.h"
+#include "utils.h"
+#include "mpsc_queue.h"
+
+LogStats logStats = {0, 0, 0};
+
+static MpscQueue<LogRecord, LOG_RING_SIZE> logRing;
+static std::atomic<uint32_t> droppedCount(0);
+static uint32_t reportedDrops = 0;
+
+void initializeLog() {
+    logRing.clear();
+}
+
+// Any task. Never blocks: a full ring drops the record and counts it.
+bool logPush(const char *type, const char *format, const uint32_t *args, uint8_t argCount) {
+    LogRecord record;
+    record.type = type;
+    record.format = format;
+    record.argCount = argCount;
+    for (uint8_t i = 0; i < LOG_MAX_ARGS; ++i) {
+        record.args[i] = i < argCount ? args[i] : 0;
+    }
+    if (!logRing.push(record)) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// Arduino loop: format a few records per pass so a burst cannot stall it
+void serviceLog() {
+    LogRecord record;
+    for (int i = 0; i < LOG_FLUSH_PER_PASS && logRing.pop(record); ++i) {
+        char message[JSON_LOG_MAX_LENGTH];
+        const uint32_t *a = record.args;
+        snprintf(message, sizeof(message), record.format, a[0], a[1], a[2], a[3]);
+        printJsonLog(record.type, message);
+        ++logStats.flushed;
+    }
+
+    uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+    logStats.dropped = dropped;
+    logStats.written = logRing.pushed();
+    if (dropped != reportedDrops) {
+        printJsonLogf("warn", "%lu log records dropped", (unsigned long)(dropped - reportedDrops));
+        reportedDrops = dropped;
+    }
+}
@@ -5,46 +5,88 @@
 #include "uart.h"
 #include "utils.h"
 #include "switches.h"
+#include "banks.h"
+#include "log.h"
+#include "stats.h"
+#include "pedals.h"
+#include "events.h"
+#include "trace.h"
+#include "boot.h"
 
+// Everything a press needs comes up first; the displays are initialized and
+// painted by their own task afterwards (see boot.h)
 void setup() {
+    markBootStage(BOOT_STAGE_SETUP);
+    initializeLog();
+    initializeEvents();
+    initializeConfigLock();
+
     // LED pin
     pinMode(LED_PIN, OUTPUT);
     digitalWrite(LED_PIN, LOW);
 
-    // Initialize displays first to show loading screen
-    initializeDisplays();
-    // showLoadingScreen();
-
     // Initialize UART for host commands
     uart_init(UART_BAUD_RATE);
+    markBootStage(BOOT_STAGE_UART);
 
     // Initialize MIDI
     initializeMIDI();
+    markBootStage(BOOT_STAGE_MIDI);
 
     // Initialize footswitch pins
     initializeFootswitchPins();
+    markBootStage(BOOT_STAGE_LADDER);
 
     // Load configuration from flash
     loadConfigFromFlash();
+    initializeBanks();
+    initializePedals();
+    markBootStage(BOOT_STAGE_CONFIG);
+
+    // Switches are live from here on
+    startInputTask();
+    markBootStage(BOOT_STAGE_INPUT_READY);
 
-    // Show normal displays after loading is complete
-    updateConfigDisplay();
-    updateFootswitchDisplay();
+    // Panel bring-up and first paint run in the background
+    startDisplayTask();
 
     printJsonLog("info", "App initialized");
 }
 
+static uint32_t lastLoopUs = 0;
+
 void loop() {
+    // Time between passes, delay(1) included
+    uint32_t now = micros();
+    if (lastLoopUs != 0) recordLatency(HIST_LOOP_PERIOD, now - lastLoopUs);
+    lastLoopUs = now;
+
     // Handle UART
     uart_loop();
 
-    // Handle footswitch input and MIDI
-    handleFootswitches();
+    // Write log records queued by the other tasks
+    serviceLog();
+
+    // Push subscribed events to the host, as far as the UART has room
+    serviceEvents();
+
+    // Report a full trace recording; write a trace dump as the UART has room
+    serviceTrace();
+
+    // Advance LED feedback patterns
+    updateLed();
+
+    // Write patched configuration to flash once edits go quiet
+    serviceConfigCommit();
+
+    // Finish deferred bank changes and read further banks into RAM
+    serviceBanks();
+
+    // Take the "CONFIG UPDATED" badge down once it has been seen
+    serviceStatusBadge();
 
-    // Check configuring message timeout
-    if (isConfiguring && (millis() - configuringStartTime > 3000)) {
-        hideConfiguringMessage();
-    }
+    // Report the boot profile once the displays are up
+    serviceBootProfile();
 
     // Small delay to avoid busy-loop
     delay(1);
@@ -1,30 +1,309 @@
 #include "midi.h"
 #include "utils.h"
 #include "display.h"
+#include "config.h"
+#include "spsc_queue.h"
+#include "log.h"
+#include "stats.h"
+#include "midi_input.h"
+#include "gestures.h"
+#include "events.h"
 
-// MIDI setup
-MIDI_CREATE_INSTANCE(HardwareSerial, Serial2, MIDI);
+MidiTxStats midiTxStats = {};
 
-// Footswitch configuration array is defined elsewhere (switches module)
-FootswitchConfig footswitches[NUM_FOOTSWITCHES];
+// Status nibble for each MidiActionType
+static const uint8_t ACTION_STATUS[MIDI_ACTION_TYPE_COUNT] = {0xC0, 0xB0, 0x90, 0x80};
+static const char *ACTION_NAMES[MIDI_ACTION_TYPE_COUNT] = {"pc", "cc", "note_on", "note_off"};
+
+// Producers push whole blocks; only the input task pops
+static SpscQueue<uint8_t, MIDI_TX_QUEUE_SIZE> txQueues[MIDI_PRODUCER_COUNT];
+static SpscQueue<uint8_t, MIDI_REALTIME_QUEUE_SIZE> realtimeQueue;
+static int txSource = MIDI_PRODUCER_COUNT;   // A producer, or TX_SOURCE_CONTINUOUS (the last)
+static uint8_t txBlockRemaining = 0;   // Bytes left in the block being sent from txSource
+static uint8_t txBlockLength = 0;
+static uint8_t txBlockStatus = 0;      // First byte of the block, before running status
+static uint8_t runningStatus = 0;      // Last channel status on the wire, 0 if none
+static unsigned long lastTxTime = 0;
+
+// Press edge time of each queued INPUT block, in block order, for the
+// latency histograms (input task only, both ends)
+static SpscQueue<uint32_t, MIDI_PRESS_ORIGIN_QUEUE_SIZE> pressOrigins;
+static uint32_t txBlockQueuedAt = 0;
+static uint32_t txBlockOriginUs = 0;   // 0 when the block is not a timed press
+
+// Continuous controller slots take their turn after the producers.
+// Written and sent by the input task only.
+static const int TX_SOURCE_CONTINUOUS = MIDI_PRODUCER_COUNT;
+
+struct ContinuousSlot {
+    uint8_t length;
+    uint8_t bytes[MIDI_CONTINUOUS_MAX_BYTES];
+    uint32_t queuedAt;
+};
+
+static ContinuousSlot continuousSlots[MIDI_CONTINUOUS_SLOTS];
+static uint8_t continuousPending = 0;    // Bit per slot holding an unsent message
+static uint8_t continuousNext = 0;       // Slot to try first
+static uint8_t continuousBlock[MIDI_CONTINUOUS_MAX_BYTES];   // Block being sent
+static uint8_t continuousBlockPos = 0;
+
+static_assert(MIDI_CONTINUOUS_SLOTS <= 8, "continuous slots are tracked in one byte");
 
 void initializeMIDI() {
-    // Initialize MIDI on Serial2 (pins 16=RX, 17=TX)
+    // Initialize MIDI on Serial2 (pins 16=RX, 17=TX). Both directions are
+    // handled byte by byte in the input task (see midi_input.h).
     Serial2.begin(MIDI_BAUD_RATE, SERIAL_8N1, MIDI_RX_PIN, MIDI_TX_PIN);
-    MIDI.begin();
     printJsonLog("info", "MIDI initialized");
 }
 
-void sendMidiCC(int switchIndex) {
-    if (switchIndex < 0 || switchIndex >= NUM_FOOTSWITCHES) return;
-    if (!footswitches[switchIndex].enabled) return;
+bool parseMidiActionType(const char *name, uint8_t &type) {
+    for (uint8_t i = 0; i < MIDI_ACTION_TYPE_COUNT; ++i) {
+        if (strcmp(name, ACTION_NAMES[i]) == 0) {
+            type = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *midiActionTypeName(uint8_t type) {
+    return type < MIDI_ACTION_TYPE_COUNT ? ACTION_NAMES[type] : "unknown";
+}
+
+// Encode a switch's actions once, so a press only copies bytes
+void compileSwitchMidi(FootswitchConfig &fs) {
+    MidiAction fallback = {MIDI_ACTION_CC, fs.midiChannel, fs.midiCC, fs.midiValue};
+    const MidiAction *actions = fs.actionCount > 0 ? fs.actions : &fallback;
+    uint8_t count = fs.actionCount > 0 ? min(fs.actionCount, (uint8_t)MIDI_MAX_ACTIONS) : 1;
+
+    uint8_t length = 0;
+    uint8_t status = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        const MidiAction &action = actions[i];
+        if (action.type >= MIDI_ACTION_TYPE_COUNT) continue;
+
+        uint8_t channel = (action.channel >= 1 && action.channel <= 16) ? action.channel - 1 : 0;
+        uint8_t actionStatus = ACTION_STATUS[action.type] | channel;
+        if (actionStatus != status) {
+            fs.midiBytes[length++] = actionStatus;
+            status = actionStatus;
+        }
+        fs.midiBytes[length++] = action.data1 & 0x7F;
+        if (action.type != MIDI_ACTION_PC) {
+            fs.midiBytes[length++] = action.data2 & 0x7F;
+        }
+    }
+    fs.midiLength = length;
+    fs.gestureMask = gestureBindingMask(fs.gestures);
+}
+
+// Queue one block of complete messages. Never blocks on the UART;
+// serviceMidiOutput() puts it on the wire.
+bool queueMidiBlock(MidiProducer producer, const uint8_t *bytes, uint8_t length) {
+    if (length == 0 || length > MIDI_MAX_BLOCK) return false;
+
+    uint8_t block[MIDI_BLOCK_HEADER_SIZE + MIDI_MAX_BLOCK];
+    uint32_t now = micros();
+    block[0] = length;
+    memcpy(block + 1, &now, sizeof(now));
+    memcpy(block + MIDI_BLOCK_HEADER_SIZE, bytes, length);
+
+    if (!txQueues[producer].pushAll(block, MIDI_BLOCK_HEADER_SIZE + length)) {
+        ++midiTxStats.queueFull;
+        return false;
+    }
+    midiTxStats.bytesQueued += length;
+    return true;
+}
+
+// Real-time bytes may be sent between any two bytes of other messages.
+// Input task only (THRU).
+bool queueMidiRealtime(uint8_t byte) {
+    if (!realtimeQueue.push(byte)) {
+        ++midiTxStats.queueFull;
+        return false;
+    }
+    midiTxStats.bytesQueued++;
+    return true;
+}
+
+// Queue a single action (a gesture binding). originUs as for queueSwitchMidi().
+bool queueMidiAction(MidiProducer producer, const MidiAction &action, uint32_t originUs) {
+    if (action.type >= MIDI_ACTION_TYPE_COUNT) return false;
+
+    uint8_t channel = (action.channel >= 1 && action.channel <= 16) ? action.channel - 1 : 0;
+    uint8_t bytes[3] = {(uint8_t)(ACTION_STATUS[action.type] | channel), (uint8_t)(action.data1 & 0x7F),
+                        (uint8_t)(action.data2 & 0x7F)};
+    uint8_t length = action.type == MIDI_ACTION_PC ? 2 : 3;
+
+    if (!queueMidiBlock(producer, bytes, length)) return false;
+    if (producer == MIDI_PRODUCER_INPUT) pressOrigins.push(originUs);
+    return true;
+}
+
+// Replace the unsent message of a continuous controller, if any, with a newer
+// one. Input task only.
+bool queueMidiContinuous(uint8_t slot, const uint8_t *bytes, uint8_t length) {
+    if (slot >= MIDI_CONTINUOUS_SLOTS || length == 0 || length > MIDI_CONTINUOUS_MAX_BYTES) return false;
+
+    ContinuousSlot &pending = continuousSlots[slot];
+    if (continuousPending & (1u << slot)) ++midiTxStats.continuousCoalesced;
+    memcpy(pending.bytes, bytes, length);
+    pending.length = length;
+    pending.queuedAt = micros();
+    continuousPending |= 1u << slot;
+    midiTxStats.bytesQueued += length;
+    return true;
+}
+
+// Queue the compiled bytes of a switch in the active bank. originUs is the
+// press edge time for INPUT presses, carried through to the wire histogram.
+bool queueSwitchMidi(MidiProducer producer, int switchIndex, uint32_t originUs) {
+    if (switchIndex < 0 || switchIndex >= NUM_FOOTSWITCHES) return false;
+
+    uint8_t bytes[MIDI_MAX_SWITCH_BYTES];
+    lockConfig();
+    const FootswitchConfig &fs = footswitches[switchIndex];
+    bool enabled = fs.enabled;
+    uint8_t length = fs.midiLength;
+    memcpy(bytes, fs.midiBytes, length);
+    unlockConfig();
+
+    if (!enabled || length == 0) return false;
+    if (!queueMidiBlock(producer, bytes, length)) return false;
+    if (producer == MIDI_PRODUCER_INPUT) pressOrigins.push(originUs);
+
+    LOG_INFO("midi", "Switch %d: %u MIDI bytes queued", switchIndex + 1, length);
+    return true;
+}
+
+// Move the next pending controller message into continuousBlock
+static bool startContinuousBlock() {
+    for (uint8_t i = 0; i < MIDI_CONTINUOUS_SLOTS; ++i) {
+        uint8_t slot = (continuousNext + i) % MIDI_CONTINUOUS_SLOTS;
+        if (!(continuousPending & (1u << slot))) continue;
+
+        const ContinuousSlot &pending = continuousSlots[slot];
+        uint32_t latency = micros() - pending.queuedAt;
+        if (latency > midiTxStats.continuousMaxLatencyUs) midiTxStats.continuousMaxLatencyUs = latency;
+
+        memcpy(continuousBlock, pending.bytes, pending.length);
+        continuousBlockPos = 0;
+        continuousPending &= ~(1u << slot);
+        continuousNext = (slot + 1) % MIDI_CONTINUOUS_SLOTS;
+        ++midiTxStats.continuousSent;
+
+        txSource = TX_SOURCE_CONTINUOUS;
+        txBlockRemaining = pending.length;
+        txBlockLength = pending.length;
+        txBlockOriginUs = 0;
+        return true;
+    }
+    return false;
+}
+
+// At a block boundary: take the next block round-robin across producers,
+// so a busy THRU stream delays a press by at most one block and vice versa.
+// Controller messages take a turn too, but never while a switch block waits.
+static bool startNextBlock() {
+    for (int i = 1; i <= MIDI_PRODUCER_COUNT + 1; ++i) {
+        int source = (txSource + i) % (MIDI_PRODUCER_COUNT + 1);
+        if (source == TX_SOURCE_CONTINUOUS) {
+            if (continuousPending == 0 || !txQueues[MIDI_PRODUCER_INPUT].empty() ||
+                !txQueues[MIDI_PRODUCER_HOST].empty()) {
+                continue;
+            }
+            if (startContinuousBlock()) return true;
+            continue;
+        }
+
+        uint8_t header[MIDI_BLOCK_HEADER_SIZE];
+        if (!txQueues[source].pop(header[0])) continue;
+        for (int h = 1; h < MIDI_BLOCK_HEADER_SIZE; ++h) {
+            txQueues[source].pop(header[h]);
+        }
 
-    MIDI.sendProgramChange(
-        footswitches[switchIndex].midiCC,
-        footswitches[switchIndex].midiChannel
-    );
+        uint32_t queuedAt;
+        memcpy(&queuedAt, header + 1, sizeof(queuedAt));
+        uint32_t latency = micros() - queuedAt;
+        if (latency > midiTxStats.maxLatencyUs[source]) midiTxStats.maxLatencyUs[source] = latency;
 
-    printJsonLog("midi", "MIDI CC sent: Ch" + String(footswitches[switchIndex].midiChannel) +
-        " CC" + String(footswitches[switchIndex].midiCC) +
-        " Val" + String(footswitches[switchIndex].midiValue));
-}
\ No newline at end of file
+        txSource = source;
+        txBlockRemaining = header[0];
+        txBlockLength = header[0];
+        txBlockQueuedAt = queuedAt;
+        txBlockOriginUs = 0;
+        if (source == MIDI_PRODUCER_INPUT) pressOrigins.pop(txBlockOriginUs);
+        return true;
+    }
+    return false;
+}
+
+// A press block's last byte has been handed to the UART; wireUs is when it
+// will have left the pin
+static void recordPressOnWire(uint32_t wireUs) {
+    if (txBlockOriginUs == 0) return;
+    recordLatency(HIST_ENQUEUE_TO_WIRE, wireUs - txBlockQueuedAt);
+    recordLatency(HIST_EDGE_TO_WIRE, wireUs - txBlockOriginUs);
+    txBlockOriginUs = 0;
+}
+
+// Move as many queued bytes as the UART TX FIFO accepts, applying running
+// status: a channel status equal to the last one sent is dropped. Real-time
+// bytes go first and do not affect it. Input task only.
+void serviceMidiOutput() {
+    if (runningStatus != 0 && millis() - lastTxTime > MIDI_RUNNING_STATUS_REFRESH_MS) {
+        runningStatus = 0;
+    }
+
+    uint8_t out[64];
+    uint32_t passStartUs = micros();
+    size_t available = Serial2.availableForWrite();
+    size_t room = min(available, sizeof(out));
+    size_t length = 0;
+
+    // Bytes still ahead of ours in the FIFO; each takes MIDI_BYTE_TIME_US
+    size_t backlog = available < MIDI_UART_FIFO_SIZE ? MIDI_UART_FIFO_SIZE - available : 0;
+
+    while (length < room) {
+        uint8_t byte;
+        if (realtimeQueue.pop(byte)) {
+            out[length++] = byte;
+            continue;
+        }
+        if (txBlockRemaining == 0 && !startNextBlock()) break;
+
+        if (txSource == TX_SOURCE_CONTINUOUS) {
+            byte = continuousBlock[continuousBlockPos++];
+        } else if (!txQueues[txSource].pop(byte)) {
+            // pushAll() publishes whole blocks, so only a bad length gets here
+            txBlockRemaining = 0;
+            continue;
+        }
+        if (txBlockRemaining == txBlockLength) txBlockStatus = byte;
+        --txBlockRemaining;
+
+        bool elided = false;
+        if (byte >= 0x80 && byte < 0xF8) {
+            if (byte < 0xF0 && byte == runningStatus) {
+                ++midiTxStats.statusBytesSaved;
+                elided = true;
+            } else {
+                runningStatus = byte < 0xF0 ? byte : 0;
+            }
+        }
+        if (!elided) out[length++] = byte;
+
+        if (txBlockRemaining == 0) {
+            uint32_t wireUs = passStartUs + (backlog + length) * MIDI_BYTE_TIME_US;
+            recordPressOnWire(wireUs);
+            postHostEvent(HOST_EVENT_MIDI, txSource, 0, wireUs, txBlockStatus, txBlockLength);
+        }
+    }
+
+    if (length > 0) {
+        Serial2.write(out, length);
+        midiTxStats.bytesSent += length;
+        lastTxTime = millis();
+    }
+}
@@ -0,0 +1,239 @@
+#include "midi_input.h"
+#include "spsc_queue.h"
+#include "pedals.h"
+#include <atomic>
+
+MidiInputStats midiInputStats = {};
+volatile bool midiThruEnabled = true;
+
+static const char *INPUT_TYPE_NAMES[MIDI_IN_TYPE_COUNT] = {
+    "note_off", "note_on", "poly_pressure", "control_change", "program_change",
+    "channel_pressure", "pitch_bend", "sysex", "system_common", "clock",
+    "start", "continue", "stop", "active_sensing", "system_reset"
+};
+
+static SpscQueue<uint8_t, MIDI_INJECT_QUEUE_SIZE> injectQueue;
+static std::atomic<bool> statsResetRequested(false);
+static uint32_t lastInjectUs = 0;
+
+// Parser state (input task only)
+static uint8_t message[3];
+static uint8_t messageLength = 0;      // 0: waiting for a status (or running status data)
+static uint8_t messageExpected = 0;    // Data bytes the current status takes
+static uint8_t rxRunningStatus = 0;    // Channel status for running-status data, 0 if none
+static uint8_t sysex[MIDI_THRU_SYSEX_MAX];
+static size_t sysexLength = 0;         // Bytes seen, F0 included
+static bool inSysex = false;
+
+// Clock tracking
+static uint32_t clockTicks = 0;
+static uint32_t quarterStartUs = 0;
+static bool quarterStartValid = false;
+static unsigned long lastClockMs = 0;
+static std::atomic<uint32_t> quarterUs(0);
+
+const char *midiInputTypeName(uint8_t type) {
+    return type < MIDI_IN_TYPE_COUNT ? INPUT_TYPE_NAMES[type] : "unknown";
+}
+
+// Data bytes following a status byte (system common included)
+static uint8_t dataLength(uint8_t status) {
+    switch (status & 0xF0) {
+        case 0xC0:
+        case 0xD0:
+            return 1;
+        case 0xF0:
+            if (status == 0xF1 || status == 0xF3) return 1;
+            if (status == 0xF2) return 2;
+            return 0;
+        default:
+            return 2;
+    }
+}
+
+static uint8_t channelMessageType(const uint8_t *msg) {
+    switch (msg[0] & 0xF0) {
+        case 0x80: return MIDI_IN_NOTE_OFF;
+        case 0x90: return msg[2] == 0 ? MIDI_IN_NOTE_OFF : MIDI_IN_NOTE_ON;
+        case 0xA0: return MIDI_IN_POLY_PRESSURE;
+        case 0xB0: return MIDI_IN_CONTROL_CHANGE;
+        case 0xC0: return MIDI_IN_PROGRAM_CHANGE;
+        case 0xD0: return MIDI_IN_CHANNEL_PRESSURE;
+        case 0xE0: return MIDI_IN_PITCH_BEND;
+        default: return MIDI_IN_SYSTEM_COMMON;
+    }
+}
+
+static void forward(const uint8_t *bytes, size_t length) {
+    if (!midiThruEnabled) return;
+    if (queueMidiBlock(MIDI_PRODUCER_THRU, bytes, length)) {
+        ++midiInputStats.thruMessages;
+    } else {
+        midiInputStats.droppedBytes += length;
+    }
+}
+
+static void completeMessage() {
+    ++midiInputStats.messages[channelMessageType(message)];
+    forward(message, messageLength);
+    messageLength = 0;
+}
+
+static void endSysex(bool terminated) {
+    inSysex = false;
+    if (!terminated || sysexLength >= MIDI_THRU_SYSEX_MAX) {
+        // Truncated by another status, or too long to forward whole
+        midiInputStats.droppedBytes += sysexLength + (terminated ? 1 : 0);
+        return;
+    }
+    sysex[sysexLength++] = 0xF7;
+    ++midiInputStats.messages[MIDI_IN_SYSEX];
+    forward(sysex, sysexLength);
+}
+
+static void trackClock(uint8_t byte, uint32_t nowUs) {
+    if (byte == 0xFA) {
+        // Start: the next tick begins a new quarter note
+        clockTicks = 0;
+        quarterStartValid = false;
+        return;
+    }
+    if (byte != 0xF8) return;
+
+    if (millis() - lastClockMs > MIDI_CLOCK_TIMEOUT_MS) {
+        // Clock resumed after a gap: the old quarter start is meaningless
+        clockTicks = 0;
+        quarterStartValid = false;
+    }
+    if (clockTicks % MIDI_CLOCK_PPQN == 0) {
+        if (quarterStartValid) quarterUs.store(nowUs - quarterStartUs, std::memory_order_relaxed);
+        quarterStartUs = nowUs;
+        quarterStartValid = true;
+    }
+    ++clockTicks;
+    lastClockMs = millis();
+}
+
+static void handleRealtime(uint8_t byte, uint32_t nowUs) {
+    switch (byte) {
+        case 0xF8: ++midiInputStats.messages[MIDI_IN_CLOCK]; break;
+        case 0xFA: ++midiInputStats.messages[MIDI_IN_START]; break;
+        case 0xFB: ++midiInputStats.messages[MIDI_IN_CONTINUE]; break;
+        case 0xFC: ++midiInputStats.messages[MIDI_IN_STOP]; break;
+        case 0xFE: ++midiInputStats.messages[MIDI_IN_ACTIVE_SENSING]; break;
+        case 0xFF: ++midiInputStats.messages[MIDI_IN_SYSTEM_RESET]; break;
+        default:
+            ++midiInputStats.droppedBytes;   // 0xF9, 0xFD are undefined
+            return;
+    }
+    trackClock(byte, nowUs);
+    if (midiThruEnabled && !queueMidiRealtime(byte)) {
+        ++midiInputStats.droppedBytes;
+    }
+}
+
+static void parseByte(uint8_t byte, uint32_t nowUs) {
+    ++midiInputStats.bytesReceived;
+
+    // Real-time bytes may appear anywhere, even inside other messages
+    if (byte >= 0xF8) {
+        handleRealtime(byte, nowUs);
+        return;
+    }
+
+    if (byte & 0x80) {
+        if (inSysex) {
+            endSysex(byte == 0xF7);
+            if (byte == 0xF7) return;
+        }
+        if (messageLength > 0) {
+            // Status before the previous message was complete
+            midiInputStats.droppedBytes += messageLength;
+            messageLength = 0;
+        }
+
+        if (byte == 0xF0) {
+            inSysex = true;
+            sysex[0] = byte;
+            sysexLength = 1;
+            rxRunningStatus = 0;
+        } else if (byte == 0xF4 || byte == 0xF5 || byte == 0xF7) {
+            ++midiInputStats.droppedBytes;   // Undefined, or EOX without SysEx
+            rxRunningStatus = 0;
+        } else {
+            // System common cancels running status
+            rxRunningStatus = byte < 0xF0 ? byte : 0;
+            message[0] = byte;
+            messageLength = 1;
+            messageExpected = dataLength(byte);
+            if (messageExpected == 0) completeMessage();
+        }
+        return;
+    }
+
+    if (inSysex) {
+        if (sysexLength < MIDI_THRU_SYSEX_MAX) sysex[sysexLength] = byte;
+        ++sysexLength;
+        return;
+    }
+
+    if (messageLength == 0) {
+        if (rxRunningStatus == 0) {
+            ++midiInputStats.droppedBytes;   // Data byte with no status to belong to
+            return;
+        }
+        message[0] = rxRunningStatus;
+        messageLength = 1;
+        messageExpected = dataLength(rxRunningStatus);
+    }
+
+    message[messageLength++] = byte;
+    if (messageLength == 1 + messageExpected) completeMessage();
+}
+
+void serviceMidiInput() {
+    if (statsResetRequested.exchange(false)) {
+        memset(&midiInputStats, 0, sizeof(midiInputStats));
+        memset(&midiTxStats, 0, sizeof(midiTxStats));
+        for (int i = 0; i < PEDAL_COUNT; ++i) {
+            pedalStats[i].messages = 0;
+            pedalStats[i].rateLimited = 0;
+        }
+    }
+
+    // One timestamp per tick: bytes read together arrived within it
+    uint32_t now = micros();
+    while (Serial2.available()) {
+        parseByte((uint8_t)Serial2.read(), now);
+    }
+
+    // Injected bytes arrive no faster than they could on a real cable
+    if (injectQueue.empty()) {
+        lastInjectUs = now;
+        return;
+    }
+    uint32_t budget = (now - lastInjectUs) / MIDI_BYTE_TIME_US;
+    lastInjectUs += budget * MIDI_BYTE_TIME_US;
+    uint8_t byte;
+    while (budget-- > 0 && injectQueue.pop(byte)) {
+        parseByte(byte, now);
+    }
+}
+
+bool injectMidiInput(const uint8_t *bytes, size_t length) {
+    return injectQueue.pushAll(bytes, length);
+}
+
+void requestMidiStatsReset() {
+    statsResetRequested.store(true);
+}
+
+uint32_t getMidiClockQuarterUs() {
+    if (millis() - lastClockMs > MIDI_CLOCK_TIMEOUT_MS) return 0;
+    return quarterUs.load(std::memory_order_relaxed);
+}
+
+float getMidiClockBpm() {
+    uint32_t quarter = getMidiClockQuarterUs();
+    return quarter > 0 ? 60000000.0f / quarter : 0.0f;
+}
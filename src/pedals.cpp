@@ -0,0 +1,272 @@
+#include "pedals.h"
+#include "config.h"
+#include "utils.h"
+#include "events.h"
+#include <Preferences.h>
+#include <atomic>
+
+static const char *PEDAL_NAMESPACE = "midi-config";
+static const char *PEDAL_KEY = "pedals";
+
+static const uint8_t PEDAL_PINS[PEDAL_COUNT] = {EXPRESSION_PEDAL1_PIN, EXPRESSION_PEDAL2_PIN};
+
+struct StoredPedals {
+    uint16_t version;
+    PedalConfig pedals[PEDAL_COUNT];
+};
+
+// Input task state of one pedal
+struct PedalState {
+    bool accepted;            // acceptedLevel holds a reading
+    bool sent;                // value has been sent
+    bool held;                // A change is waiting for the rate limit
+    uint16_t acceptedLevel;   // Level the deadband is measured from
+    uint16_t value;
+    uint32_t lastSentUs;
+};
+
+PedalStats pedalStats[PEDAL_COUNT] = {};
+
+// Edited by the Arduino loop; the input task works from its own copy, taken
+// under the config lock when configChanged is set
+static PedalConfig pedalConfigs[PEDAL_COUNT];
+static PedalConfig activeConfigs[PEDAL_COUNT];
+static std::atomic<bool> configChanged(false);
+static std::atomic<uint8_t> enabledPedals(0);   // Bit per pedal the sampler reads
+
+// Sampler task -> input task
+static uint32_t accumulators[PEDAL_COUNT];      // Level << PEDAL_SMOOTHING_SHIFT, sampler only
+static volatile uint16_t pedalLevels[PEDAL_COUNT];
+static std::atomic<uint8_t> levelsReady(0);     // Bit per pedal with a smoothed level
+
+static PedalState states[PEDAL_COUNT];
+
+static void setDefaultPedals() {
+    static const uint8_t DEFAULT_CC[PEDAL_COUNT] = {11, 4};   // Expression, foot controller
+    for (int i = 0; i < PEDAL_COUNT; ++i) {
+        PedalConfig &p = pedalConfigs[i];
+        memset(&p, 0, sizeof(p));
+        p.channel = 1;
+        p.cc = DEFAULT_CC[i];
+        p.minLevel = 64;
+        p.maxLevel = PEDAL_ADC_MAX - 64;
+        p.deadband = PEDAL_DEFAULT_DEADBAND;
+        p.maxRateHz = PEDAL_DEFAULT_MAX_RATE_HZ;
+    }
+}
+
+// Hand the loop's configuration to the sampler and the input task
+static void publishPedals() {
+    uint8_t enabled = 0;
+    for (int i = 0; i < PEDAL_COUNT; ++i) {
+        if (pedalConfigs[i].enabled) enabled |= 1u << i;
+    }
+    enabledPedals.store(enabled, std::memory_order_release);
+    configChanged.store(true, std::memory_order_release);
+}
+
+static void savePedals() {
+    StoredPedals stored;
+    stored.version = PEDAL_CONFIG_VERSION;
+    memcpy(stored.pedals, pedalConfigs, sizeof(stored.pedals));
+
+    Preferences prefs;
+    prefs.begin(PEDAL_NAMESPACE, false);
+    prefs.putBytes(PEDAL_KEY, &stored, sizeof(stored));
+    prefs.end();
+}
+
+void initializePedals() {
+    setDefaultPedals();
+
+    Preferences prefs;
+    prefs.begin(PEDAL_NAMESPACE, true);
+    StoredPedals stored;
+    size_t length = 0;
+    if (prefs.getBytesLength(PEDAL_KEY) == sizeof(stored)) {
+        length = prefs.getBytes(PEDAL_KEY, &stored, sizeof(stored));
+    }
+    prefs.end();
+    if (length == sizeof(stored) && stored.version == PEDAL_CONFIG_VERSION) {
+        memcpy(pedalConfigs, stored.pedals, sizeof(pedalConfigs));
+    }
+
+    for (int i = 0; i < PEDAL_COUNT; ++i) {
+        pinMode(PEDAL_PINS[i], INPUT);
+    }
+    publishPedals();
+    printJsonLogf("info", "Expression pedals: %u enabled", (unsigned)__builtin_popcount(enabledPedals.load()));
+}
+
+void writePedalsJson(JsonArray pedals) {
+    for (int i = 0; i < PEDAL_COUNT; ++i) {
+        const PedalConfig &p = pedalConfigs[i];
+        JsonObject out = pedals.add<JsonObject>();
+        out["id"] = i;
+        out["enabled"] = p.enabled != 0;
+        out["channel"] = p.channel;
+        out["cc"] = p.cc;
+        out["high_res"] = p.highResolution != 0;
+        out["invert"] = p.invert != 0;
+        out["min"] = p.minLevel;
+        out["max"] = p.maxLevel;
+        out["deadband"] = p.deadband;
+        out["max_rate_hz"] = p.maxRateHz;
+    }
+}
+
+// Validate a number from the command before narrowing it
+static bool readRange(JsonVariantConst value, long low, long high, long &out) {
+    if (value.isNull()) return true;
+    long v = value.as<long>();
+    if (v < low || v > high) return false;
+    out = v;
+    return true;
+}
+
+bool applyPedalsConfig(JsonArrayConst pedals, char *error, size_t errorSize) {
+    PedalConfig updated[PEDAL_COUNT];
+    memcpy(updated, pedalConfigs, sizeof(updated));
+
+    for (JsonObjectConst in : pedals) {
+        int id = in["id"] | -1;
+        if (id < 0 || id >= PEDAL_COUNT) {
+            snprintf(error, errorSize, "Invalid pedal ID");
+            return false;
+        }
+        PedalConfig &p = updated[id];
+        long channel = p.channel, cc = p.cc, minLevel = p.minLevel, maxLevel = p.maxLevel;
+        long deadband = p.deadband, rate = p.maxRateHz;
+        if (!readRange(in["channel"], 1, 16, channel) || !readRange(in["cc"], 0, 119, cc) ||
+            !readRange(in["min"], 0, PEDAL_ADC_MAX, minLevel) || !readRange(in["max"], 0, PEDAL_ADC_MAX, maxLevel) ||
+            !readRange(in["deadband"], 0, PEDAL_ADC_MAX, deadband) ||
+            !readRange(in["max_rate_hz"], 1, PEDAL_MAX_RATE_HZ, rate)) {
+            snprintf(error, errorSize, "Pedal %d: value out of range", id + 1);
+            return false;
+        }
+        p.channel = channel;
+        p.cc = cc;
+        p.minLevel = minLevel;
+        p.maxLevel = maxLevel;
+        p.deadband = deadband;
+        p.maxRateHz = rate;
+        if (!in["enabled"].isNull()) p.enabled = in["enabled"].as<bool>() ? 1 : 0;
+        if (!in["high_res"].isNull()) p.highResolution = in["high_res"].as<bool>() ? 1 : 0;
+        if (!in["invert"].isNull()) p.invert = in["invert"].as<bool>() ? 1 : 0;
+
+        if (p.highResolution && p.cc > 31) {
+            snprintf(error, errorSize, "Pedal %d: 14-bit needs a CC from 0 to 31", id + 1);
+            return false;
+        }
+        if (p.minLevel >= p.maxLevel) {
+            snprintf(error, errorSize, "Pedal %d: min must be below max", id + 1);
+            return false;
+        }
+    }
+
+    lockConfig();
+    memcpy(pedalConfigs, updated, sizeof(pedalConfigs));
+    unlockConfig();
+    savePedals();
+    publishPedals();
+    postHostEvent(HOST_EVENT_CONFIG, CONFIG_EVENT_PEDALS, 0, micros());
+    return true;
+}
+
+// Every PEDAL_SAMPLE_DIVIDER ladder ticks: one read per enabled pedal,
+// smoothed with an exponential moving average
+void samplePedals() {
+    uint8_t enabled = enabledPedals.load(std::memory_order_acquire);
+    uint8_t ready = levelsReady.load(std::memory_order_relaxed);
+
+    for (int i = 0; i < PEDAL_COUNT; ++i) {
+        if (!(enabled & (1u << i))) {
+            ready &= ~(1u << i);
+            continue;
+        }
+        uint32_t raw = (uint32_t)analogRead(PEDAL_PINS[i]);
+        if (ready & (1u << i)) {
+            accumulators[i] += raw - (accumulators[i] >> PEDAL_SMOOTHING_SHIFT);
+        } else {
+            accumulators[i] = raw << PEDAL_SMOOTHING_SHIFT;
+        }
+        pedalLevels[i] = accumulators[i] >> PEDAL_SMOOTHING_SHIFT;
+        ready |= 1u << i;
+    }
+    levelsReady.store(ready, std::memory_order_release);
+}
+
+static uint16_t scalePedal(const PedalConfig &p, uint16_t level) {
+    uint32_t full = p.highResolution ? 16383 : 127;
+    uint32_t span = p.maxLevel - p.minLevel;
+    uint32_t travel = level <= p.minLevel ? 0 : level >= p.maxLevel ? span : level - p.minLevel;
+    uint32_t value = (travel * full + span / 2) / span;
+    return p.invert ? full - value : value;
+}
+
+// One Control Change, or an MSB/LSB pair sharing its status byte
+static uint8_t encodePedal(const PedalConfig &p, uint16_t value, uint8_t *bytes) {
+    bytes[0] = 0xB0 | ((p.channel - 1) & 0x0F);
+    bytes[1] = p.cc;
+    if (!p.highResolution) {
+        bytes[2] = value & 0x7F;
+        return 3;
+    }
+    bytes[2] = (value >> 7) & 0x7F;
+    bytes[3] = p.cc + 32;
+    bytes[4] = value & 0x7F;
+    return 5;
+}
+
+// Turn smoothed levels into controller values: a level counts once it moves
+// past the deadband (or reaches either end of the travel), and a changed
+// value waits until the pedal's rate interval has passed. Only the newest
+// value is kept, so the last position is always sent.
+void servicePedals(uint32_t nowUs) {
+    if (configChanged.exchange(false, std::memory_order_acquire)) {
+        lockConfig();
+        memcpy(activeConfigs, pedalConfigs, sizeof(activeConfigs));
+        unlockConfig();
+        memset(states, 0, sizeof(states));
+    }
+
+    uint8_t ready = levelsReady.load(std::memory_order_acquire);
+    if (ready == 0) return;
+
+    for (int i = 0; i < PEDAL_COUNT; ++i) {
+        const PedalConfig &p = activeConfigs[i];
+        if (!(ready & (1u << i)) || !p.enabled) continue;
+
+        PedalState &s = states[i];
+        uint16_t level = pedalLevels[i];
+        pedalStats[i].level = level;
+
+        int moved = (int)level - (int)s.acceptedLevel;
+        if (!s.accepted || moved > (int)p.deadband || -moved > (int)p.deadband ||
+            level <= p.minLevel || level >= p.maxLevel) {
+            s.acceptedLevel = level;
+            s.accepted = true;
+        }
+
+        uint16_t value = scalePedal(p, s.acceptedLevel);
+        if (s.sent && value == s.value) {
+            s.held = false;
+            continue;
+        }
+        if (s.sent && nowUs - s.lastSentUs < 1000000UL / p.maxRateHz) {
+            if (!s.held) ++pedalStats[i].rateLimited;
+            s.held = true;
+            continue;
+        }
+
+        uint8_t bytes[MIDI_CONTINUOUS_MAX_BYTES];
+        uint8_t length = encodePedal(p, value, bytes);
+        if (!queueMidiContinuous(i, bytes, length)) continue;
+        s.sent = true;
+        s.held = false;
+        s.value = value;
+        s.lastSentUs = nowUs;
+        pedalStats[i].value = value;
+        ++pedalStats[i].messages;
+    }
+}
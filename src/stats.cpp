@@ -0,0 +1,134 @@
+#include "stats.h"
+#include "utils.h"
+#include "midi.h"
+#include "midi_input.h"
+#include "display.h"
+#include "ladder.h"
+#include "banks.h"
+#include "log.h"
+#include "uart.h"
+#include "events.h"
+
+static LatencyHistogram histograms[HIST_COUNT];
+
+static const char *HISTOGRAM_NAMES[HIST_COUNT] = {
+    "edge_to_accept", "accept_to_enqueue", "enqueue_to_wire", "edge_to_wire",
+    "loop_period", "redraw", "uart_parse", "event_delivery"
+};
+
+static uint8_t bucketFor(uint32_t us) {
+    if (us < 4) return us;
+    uint8_t msb = 31 - __builtin_clz(us);
+    uint8_t index = (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+    return index < STATS_BUCKETS ? index : STATS_BUCKETS - 1;
+}
+
+// Smallest value that lands in a bucket
+static uint32_t bucketFloor(uint8_t bucket) {
+    if (bucket < 4) return bucket;
+    uint8_t msb = bucket / 4 + 1;
+    return (uint32_t)(4 + bucket % 4) << (msb - 2);
+}
+
+static void clearHistogram(LatencyHistogram &h) {
+    memset(h.buckets, 0, sizeof(h.buckets));
+    h.count = 0;
+    h.minUs = 0;
+    h.maxUs = 0;
+    h.totalUs = 0;
+}
+
+void recordLatency(StatsHistogramId id, uint32_t us) {
+    LatencyHistogram &h = histograms[id];
+    if (h.resetPending.exchange(false, std::memory_order_acquire)) {
+        clearHistogram(h);
+    }
+    ++h.buckets[bucketFor(us)];
+    ++h.count;
+    if (h.count == 1 || us < h.minUs) h.minUs = us;
+    if (us > h.maxUs) h.maxUs = us;
+    h.totalUs += us;
+}
+
+// Each writer clears its own histogram before its next sample
+void resetStats() {
+    for (int i = 0; i < HIST_COUNT; ++i) {
+        histograms[i].resetPending.store(true, std::memory_order_release);
+    }
+    requestMidiStatsReset();
+}
+
+// Floor of the bucket holding the given fraction of samples
+static uint32_t percentile(const LatencyHistogram &h, uint32_t count, uint32_t perMille) {
+    uint32_t target = (uint64_t)count * perMille / 1000;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < STATS_BUCKETS; ++b) {
+        seen += h.buckets[b];
+        if (seen > target) return bucketFloor(b);
+    }
+    return h.maxUs;
+}
+
+static void writeHistogramJson(JsonObject out, const LatencyHistogram &h, bool withBuckets) {
+    uint32_t count = h.resetPending.load(std::memory_order_acquire) ? 0 : h.count;
+    out["count"] = count;
+    if (count == 0) return;
+
+    out["min_us"] = h.minUs;
+    out["max_us"] = h.maxUs;
+    out["mean_us"] = (uint32_t)(h.totalUs / count);
+    out["p50_us"] = percentile(h, count, 500);
+    out["p90_us"] = percentile(h, count, 900);
+    out["p99_us"] = percentile(h, count, 990);
+    if (!withBuckets) return;
+
+    // Non-empty buckets only, as [floor_us, count]
+    JsonArray buckets = out["buckets"].to<JsonArray>();
+    for (uint8_t b = 0; b < STATS_BUCKETS; ++b) {
+        if (h.buckets[b] == 0) continue;
+        JsonArray bucket = buckets.add<JsonArray>();
+        bucket.add(bucketFloor(b));
+        bucket.add(h.buckets[b]);
+    }
+}
+
+// Returns false if the reply did not fit in the response arena (nothing sent)
+static bool sendStatsDocument(bool withBuckets) {
+    JsonDocument doc(responseArena.reset());
+    doc["type"] = "stats";
+    doc["status"] = "success";
+    doc["uptime_ms"] = millis();
+
+    JsonObject hist = doc["histograms"].to<JsonObject>();
+    for (int i = 0; i < HIST_COUNT; ++i) {
+        writeHistogramJson(hist[HISTOGRAM_NAMES[i]].to<JsonObject>(), histograms[i], withBuckets);
+    }
+
+    JsonObject counters = doc["counters"].to<JsonObject>();
+    counters["ladder_sample_rate_hz"] = getLadderSampleRate();
+    counters["ladder_overruns"] = getLadderOverruns();
+    counters["midi_bytes_sent"] = midiTxStats.bytesSent;
+    counters["midi_queue_full"] = midiTxStats.queueFull;
+    counters["midi_in_bytes"] = midiInputStats.bytesReceived;
+    counters["midi_in_dropped"] = midiInputStats.droppedBytes;
+    counters["frames_drawn"] = footswitchDisplayStats.framesDrawn + configDisplayStats.framesDrawn;
+    counters["frames_skipped"] = footswitchDisplayStats.framesSkipped + configDisplayStats.framesSkipped;
+    counters["bank_switches"] = getBankSwitchCount();
+    counters["uart_commands"] = uartStats.commands;
+    counters["log_dropped"] = logStats.dropped;
+    counters["events_sent"] = eventStats.sent;
+    counters["events_dropped"] = eventStats.dropped;
+    if (!withBuckets) doc["buckets_omitted"] = true;
+
+    if (doc.overflowed()) return false;
+    serializeJson(doc, Serial);
+    Serial.println();
+    return true;
+}
+
+// Wide distributions, usually when latency is at its worst, can list too
+// many buckets for the arena; the summary is still sent then
+void sendStats() {
+    if (sendStatsDocument(true)) return;
+    if (!sendStatsDocument(false)) printJsonLog("error", "Stats response too large");
+}
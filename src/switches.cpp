@@ -3,59 +3,157 @@
 #include "midi.h"
 #include "utils.h"
 #include "display.h"
-
-// Expected analog value ranges for each switch (tune these based on your resistor values)
-const int FOOTSWITCH_THRESHOLDS[NUM_FOOTSWITCHES + 1] = {
-    0,    // Min value for switch 0
-    200,  // Min value for switch 1
-    400,  // Min value for switch 2
-    600,  // Min value for switch 3
-    800,  // Min value for switch 4
-    1000, // Min value for switch 5
-    4096  // Max ADC value (ESP32 ADC is 12-bit)
-};
+#include "ladder.h"
+#include "banks.h"
+#include "midi_input.h"
+#include "stats.h"
+#include "gestures.h"
+#include "config.h"
+#include "log.h"
+#include "pedals.h"
+#include "events.h"
 
 // Footswitch state tracking
 int lastPressedFootswitch = -1;
-unsigned long lastDebounceTime = 0;
+uint32_t lastEdgeTimeUs = 0;
+uint32_t lastAcceptedEdgeUs = 0;
 int currentSelectedFootswitch = -1;
-bool isConfiguring = false;
-unsigned long configuringStartTime = 0;
+
+static TaskHandle_t inputTaskHandle = NULL;
+
+// Debounced ladder state, including releases; its edges feed the gesture engine
+static int debouncedFootswitch = -1;
+
+static void handleGesture(int switchIndex, GestureEvent event, uint32_t timeUs);
 
 void initializeFootswitchPins() {
     pinMode(FOOTSWITCH_LADDER_PIN, INPUT);
+    initializeGestures(handleGesture);
+    loadLadderCalibration();
     printJsonLog("info", "Footswitch resistor ladder initialized");
 }
 
-void handleFootswitches() {
-    int analogValue = analogRead(FOOTSWITCH_LADDER_PIN);
-    int pressedFootswitch = -1;
+// A debounced press: bank navigation switches step once per press and never
+// send MIDI, any other switch becomes selected and sends its actions
+static void acceptPress(int switchIndex, uint32_t edgeUs) {
+    lastAcceptedEdgeUs = edgeUs;
+    int bankStep = bankNavDirection(switchIndex);
+    if (bankStep != 0) {
+        stepBank(bankStep, DISPLAY_PRODUCER_INPUT);
+        return;
+    }
+    if (switchIndex == currentSelectedFootswitch) return;
 
-    // Determine which switch is pressed based on analog value
-    for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
-        if (analogValue >= FOOTSWITCH_THRESHOLDS[i] && analogValue < FOOTSWITCH_THRESHOLDS[i + 1]) {
-            pressedFootswitch = i;
+    currentSelectedFootswitch = switchIndex;
+    uint32_t acceptUs = micros();
+    recordLatency(HIST_EDGE_TO_ACCEPT, acceptUs - edgeUs);
+    if (queueSwitchMidi(MIDI_PRODUCER_INPUT, switchIndex, edgeUs)) {
+        recordLatency(HIST_ACCEPT_TO_ENQUEUE, micros() - acceptUs);
+    }
+    postDisplayEvent(DISPLAY_PRODUCER_INPUT, DISPLAY_EVENT_FOOTSWITCH);
+    postDisplayEvent(DISPLAY_PRODUCER_INPUT, DISPLAY_EVENT_CONFIG);
+}
+
+// Log line per gesture, indexed by GestureEvent (formats must be literals)
+static const char *GESTURE_LOG_FORMATS[GESTURE_EVENT_COUNT] = {
+    "Switch %d: press", "Switch %d: release", "Switch %d: long press",
+    "Switch %d: double tap", "Switch %d: hold repeat"
+};
+
+static void handleGesture(int switchIndex, GestureEvent event, uint32_t timeUs) {
+    postHostEvent(HOST_EVENT_GESTURE, event, switchIndex, timeUs);
+    if (event == GESTURE_PRESS) {
+        acceptPress(switchIndex, timeUs);
+        return;
+    }
+
+    lockConfig();
+    const FootswitchConfig &fs = footswitches[switchIndex];
+    GestureBinding binding = fs.gestures.bindings[event - 1];
+    bool enabled = fs.enabled;
+    unlockConfig();
+
+    switch (binding.kind) {
+        case GESTURE_ACTION_MIDI: {
+            if (!enabled) return;
+            // Timed gestures have no edge to measure latency from
+            bool timed = event == GESTURE_LONG_PRESS || event == GESTURE_HOLD_REPEAT;
+            queueMidiAction(MIDI_PRODUCER_INPUT, binding.midi, timed ? 0 : timeUs);
             break;
         }
+        case GESTURE_ACTION_BANK_NEXT:
+            stepBank(1, DISPLAY_PRODUCER_INPUT);
+            break;
+        case GESTURE_ACTION_BANK_PREV:
+            stepBank(-1, DISPLAY_PRODUCER_INPUT);
+            break;
+        default:
+            return;
     }
+    LOG_INFO("info", GESTURE_LOG_FORMATS[event], switchIndex + 1);
+}
+
+// Debounce on sample timestamps rather than millis(), so acceptance time
+// depends only on the ladder signal and not on when this task got to run.
+// Debounced edges and the sample clock drive the gesture engine.
+static void processLadderSample(const LadderSample &sample) {
+    int pressedFootswitch = classifyLadder(sample.value, lastPressedFootswitch);
 
-    // Debounce logic
     if (pressedFootswitch != lastPressedFootswitch) {
-        lastDebounceTime = millis();
-    }
-
-    if ((millis() - lastDebounceTime) > DEBOUNCE_DELAY) {
-        if (pressedFootswitch != -1 && pressedFootswitch != currentSelectedFootswitch) {
-            // Switch pressed
-            currentSelectedFootswitch = pressedFootswitch;
-            sendMidiCC(currentSelectedFootswitch);
-            updateConfigDisplay();
-        } else if (pressedFootswitch == -1 && currentSelectedFootswitch != -1) {
-            // Switch released
-            // currentSelectedFootswitch = -1;
-            // updateConfigDisplay();
+        lastEdgeTimeUs = sample.timestampUs;
+        lastPressedFootswitch = pressedFootswitch;
+    }
+
+    if ((sample.timestampUs - lastEdgeTimeUs) <= DEBOUNCE_DELAY * 1000UL) return;
+
+    if (pressedFootswitch != debouncedFootswitch) {
+        // The ladder reads one switch at a time, so moving straight from
+        // one to another releases the first
+        if (debouncedFootswitch != -1) {
+            postHostEvent(HOST_EVENT_SWITCH, 0, debouncedFootswitch, lastEdgeTimeUs);
+            gestureSwitchUp(debouncedFootswitch, lastEdgeTimeUs);
+        }
+        debouncedFootswitch = pressedFootswitch;
+        if (pressedFootswitch != -1) {
+            postHostEvent(HOST_EVENT_SWITCH, 1, pressedFootswitch, lastEdgeTimeUs);
+            gestureSwitchDown(pressedFootswitch, lastEdgeTimeUs);
         }
     }
+    serviceGestures(sample.timestampUs);
+}
 
-    lastPressedFootswitch = pressedFootswitch;
-}
\ No newline at end of file
+// Consume every sample queued by the ladder sampler since the last call
+void handleFootswitches() {
+    LadderSample sample;
+    while (readLadderSample(sample)) {
+        processLadderSample(sample);
+    }
+}
+
+// One wake of the input task; trace replay calls it directly
+void runInputPass() {
+    handleFootswitches();
+    servicePedals(micros());
+    serviceMidiInput();
+    serviceMidiOutput();
+}
+
+// High-priority input task: woken by the ladder sampler for each new sample
+// (or at least every INPUT_TASK_PERIOD_MS). It owns the MIDI UART: incoming
+// bytes are parsed here, and presses, pedal values, host tests and THRU
+// messages are queued and drained here without blocking.
+// Redraws are only requested here, never performed.
+static void inputTask(void *parameter) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(INPUT_TASK_PERIOD_MS));
+        runInputPass();
+    }
+}
+
+void startInputTask() {
+    xTaskCreatePinnedToCore(inputTask, "input", INPUT_TASK_STACK_SIZE, NULL,
+                            INPUT_TASK_PRIORITY, &inputTaskHandle, INPUT_TASK_CORE);
+    attachLadderConsumer(inputTaskHandle);
+    initializeLadderSampler(LADDER_SAMPLE_RATE_HZ);
+    printJsonLog("info", "Input task started");
+}
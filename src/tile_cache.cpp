@@ -0,0 +1,166 @@
+#include "tile_cache.h"
+#include "display.h"
+#include "utils.h"
+#include "layout.h"
+#include "log.h"
+
+// Palette slots of a tile sprite; direct drawing uses the same roles
+enum TileColor : uint8_t {
+    TILE_COLOR_BACKGROUND,
+    TILE_COLOR_BORDER,
+    TILE_COLOR_TEXT,
+    TILE_COLOR_COUNT
+};
+
+// The switch fields a tile shows, as last rendered into a sprite
+struct TileKey {
+    bool valid;
+    char name[FOOTSWITCH_NAME_MAX + 1];
+    uint8_t midiCC;
+    uint8_t midiChannel;
+    bool enabled;
+    uint16_t color;
+};
+
+struct TileEntry {
+    TFT_eSprite *sprite;
+    TileKey key;
+    uint32_t lastUsed;
+};
+
+TileCacheStats tileCacheStats = {0, 0, 0, 0, 0, 0};
+
+static MultiTFT *tileDisplay = NULL;
+static int16_t tileWidth = 0;
+static int16_t tileHeight = 0;
+static uint32_t tileBytes = 0;
+static uint32_t useCounter = 0;
+static TileEntry entries[NUM_FOOTSWITCHES][TILE_VARIANT_COUNT];
+
+void initializeTileCache(MultiTFT &display, int16_t width, int16_t height) {
+    tileDisplay = &display;
+    tileWidth = width;
+    tileHeight = height;
+    tileBytes = ((uint32_t)width * height + 1) / 2;   // 4 bits per pixel
+    tileCacheStats.budgetBytes = psramFound() ? TILE_CACHE_PSRAM_BUDGET_BYTES : TILE_CACHE_BUDGET_BYTES;
+
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        for (int v = 0; v < TILE_VARIANT_COUNT; ++v) {
+            entries[i][v].sprite = new TFT_eSprite(&display);
+            entries[i][v].sprite->setColorDepth(4);
+            entries[i][v].key.valid = false;
+            entries[i][v].lastUsed = 0;
+        }
+    }
+    // Runs on the display task at boot, so the record is deferred
+    LOG_INFO("info", "Tile cache: %u bytes per tile, %u byte budget (PSRAM %u)",
+             (unsigned)tileBytes, (unsigned)tileCacheStats.budgetBytes, (unsigned)psramFound());
+}
+
+static void tileColors(const FootswitchConfig &fs, uint16_t colors[TILE_COLOR_COUNT]) {
+    colors[TILE_COLOR_BACKGROUND] = fs.enabled ? fs.color : BLACK;
+    colors[TILE_COLOR_BORDER] = WHITE;
+    colors[TILE_COLOR_TEXT] = fs.enabled ? getTextColorForBackground(fs.color) : RED;
+}
+
+// Draw a tile at x,y. colors holds palette indices when gfx is a sprite and
+// RGB565 values when it is the panel.
+static void renderTile(TFT_eSPI &gfx, int x, int y, const FootswitchConfig &fs, bool selected,
+                       const uint16_t colors[TILE_COLOR_COUNT]) {
+    gfx.fillRect(x, y, tileWidth, tileHeight, colors[TILE_COLOR_BACKGROUND]);
+    gfx.drawRect(x, y, tileWidth, tileHeight, colors[TILE_COLOR_BORDER]);
+    for (int i = 1; selected && i <= TILE_SELECTED_BORDER; ++i) {
+        gfx.drawRect(x + i, y + i, tileWidth - 2 * i, tileHeight - 2 * i, colors[TILE_COLOR_TEXT]);
+    }
+
+    gfx.setTextColor(colors[TILE_COLOR_TEXT]);
+    gfx.setTextDatum(MC_DATUM);
+    gfx.setTextSize(FootswitchLayout::nameSize);
+    gfx.drawString(fs.name, x + FootswitchLayout::textX, y + FootswitchLayout::nameY);
+
+    char label[16];
+    snprintf(label, sizeof(label), "CC%u Ch%u", (unsigned)fs.midiCC, (unsigned)fs.midiChannel);
+    gfx.setTextSize(FootswitchLayout::labelSize);
+    gfx.drawString(label, x + FootswitchLayout::textX, y + FootswitchLayout::labelY);
+}
+
+static bool keyMatches(const TileKey &key, const FootswitchConfig &fs) {
+    return key.valid &&
+           key.enabled == fs.enabled &&
+           key.color == fs.color &&
+           key.midiCC == fs.midiCC &&
+           key.midiChannel == fs.midiChannel &&
+           strcmp(key.name, fs.name) == 0;
+}
+
+static void rememberKey(TileKey &key, const FootswitchConfig &fs) {
+    key.valid = true;
+    memcpy(key.name, fs.name, sizeof(key.name));
+    key.midiCC = fs.midiCC;
+    key.midiChannel = fs.midiChannel;
+    key.enabled = fs.enabled;
+    key.color = fs.color;
+}
+
+// Free the least recently used sprite other than keep. Returns false if none.
+static bool evictOne(const TileEntry *keep) {
+    TileEntry *victim = NULL;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        for (int v = 0; v < TILE_VARIANT_COUNT; ++v) {
+            TileEntry &entry = entries[i][v];
+            if (&entry == keep || !entry.sprite->created()) continue;
+            if (victim == NULL || entry.lastUsed < victim->lastUsed) victim = &entry;
+        }
+    }
+    if (victim == NULL) return false;
+
+    victim->sprite->deleteSprite();
+    victim->key.valid = false;
+    tileCacheStats.usedBytes -= tileBytes;
+    ++tileCacheStats.evictions;
+    return true;
+}
+
+// Make sure the entry owns a sprite buffer, within the budget
+static bool allocateSprite(TileEntry &entry) {
+    if (entry.sprite->created()) return true;
+
+    while (tileCacheStats.usedBytes + tileBytes > tileCacheStats.budgetBytes) {
+        if (!evictOne(&entry)) return false;
+    }
+    if (!psramFound() && ESP.getMaxAllocHeap() < tileBytes + TILE_CACHE_HEAP_RESERVE_BYTES) {
+        return false;
+    }
+    if (entry.sprite->createSprite(tileWidth, tileHeight) == NULL) {
+        return false;
+    }
+    tileCacheStats.usedBytes += tileBytes;
+    return true;
+}
+
+void drawFootswitchTile(int slot, int x, int y, const FootswitchConfig &fs, bool selected) {
+    TileEntry &entry = entries[slot][selected ? TILE_VARIANT_SELECTED : TILE_VARIANT_NORMAL];
+    uint16_t colors[TILE_COLOR_COUNT];
+    tileColors(fs, colors);
+
+    if (entry.sprite->created() && keyMatches(entry.key, fs)) {
+        ++tileCacheStats.hits;
+    } else if (allocateSprite(entry)) {
+        static const uint16_t PALETTE_INDEX[TILE_COLOR_COUNT] = {
+            TILE_COLOR_BACKGROUND, TILE_COLOR_BORDER, TILE_COLOR_TEXT
+        };
+        for (uint8_t c = 0; c < TILE_COLOR_COUNT; ++c) {
+            entry.sprite->setPaletteColor(c, colors[c]);
+        }
+        renderTile(*entry.sprite, 0, 0, fs, selected, PALETTE_INDEX);
+        rememberKey(entry.key, fs);
+        ++tileCacheStats.renders;
+    } else {
+        renderTile(*tileDisplay, x, y, fs, selected, colors);
+        ++tileCacheStats.fallbacks;
+        return;
+    }
+
+    entry.lastUsed = ++useCounter;
+    tileDisplay->pushSprite(*entry.sprite, x, y);
+}
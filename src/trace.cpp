@@ -0,0 +1,251 @@
+#include "trace.h"
+#include "utils.h"
+#include "config.h"
+#include "banks.h"
+#include "switches.h"
+
+#define TRACE_DUMP_LINES_PER_PASS 4
+#define TRACE_UART_RECORD_HEADER 6     // u32 time, u16 length
+
+std::atomic<bool> traceRecording(false);
+
+// Sampler task while recording; read by the loop once recording stopped
+static TraceLadderEntry ladderEntries[TRACE_LADDER_SAMPLES];
+static std::atomic<uint32_t> ladderCount(0);
+static std::atomic<bool> ladderFull(false);
+static uint32_t lastSampleUs = 0;
+
+// Arduino loop only
+static uint8_t uartRecords[TRACE_UART_BYTES];
+static size_t uartLength = 0;
+static bool uartFull = false;
+static bool recordingActive = false;   // Started and not yet seen to stop
+
+// What the firmware looked like when recording started
+static uint32_t traceStartUs = 0;
+static uint8_t traceBank = 0;
+static uint16_t traceConfig = 0;
+static LadderCalibration traceCalibration;
+static bool traceCalibrated = false;
+
+enum TraceDumpPhase : uint8_t {
+    TRACE_DUMP_IDLE,
+    TRACE_DUMP_LADDER,
+    TRACE_DUMP_UART,
+    TRACE_DUMP_END
+};
+
+static TraceDumpPhase dumpPhase = TRACE_DUMP_IDLE;
+static size_t dumpOffset = 0;
+static char dumpLine[128];
+static size_t dumpLineLength = 0;      // Formatted, waiting for room in the UART
+
+static bool isDumping() {
+    return dumpPhase != TRACE_DUMP_IDLE || dumpLineLength != 0;
+}
+
+void recordTraceSample(const LadderSample &sample) {
+    if (!traceRecording.load(std::memory_order_acquire)) return;
+    uint32_t count = ladderCount.load(std::memory_order_relaxed);
+    uint32_t previousUs = count == 0 ? traceStartUs : lastSampleUs;
+    // A tick taken just before the start counts as taken at the start
+    bool early = (int32_t)(sample.timestampUs - previousUs) < 0;
+    uint32_t dtUs = early ? 0 : sample.timestampUs - previousUs;
+
+    while (count < TRACE_LADDER_SAMPLES) {
+        if (dtUs <= 0xFFFF) {
+            TraceLadderEntry entry = {(uint16_t)dtUs, sample.value};
+            ladderEntries[count++] = entry;
+            lastSampleUs = early ? previousUs : sample.timestampUs;
+            ladderCount.store(count, std::memory_order_release);
+            return;
+        }
+        TraceLadderEntry gap = {0xFFFF, TRACE_GAP_VALUE};
+        ladderEntries[count++] = gap;
+        dtUs -= 0xFFFF;
+    }
+    ladderCount.store(count, std::memory_order_release);
+    ladderFull.store(true, std::memory_order_relaxed);
+    traceRecording.store(false, std::memory_order_relaxed);
+}
+
+void traceUartCommand(const char *command, size_t length) {
+    if (!traceRecording.load(std::memory_order_relaxed)) return;
+    if (uartLength + TRACE_UART_RECORD_HEADER + length > TRACE_UART_BYTES) {
+        uartFull = true;
+        traceRecording.store(false, std::memory_order_relaxed);
+        return;
+    }
+    uint32_t timeUs = micros();
+    uint8_t *record = uartRecords + uartLength;
+    for (int i = 0; i < 4; ++i) record[i] = (uint8_t)(timeUs >> (8 * i));
+    record[4] = (uint8_t)(length & 0xFF);
+    record[5] = (uint8_t)(length >> 8);
+    memcpy(record + TRACE_UART_RECORD_HEADER, command, length);
+    uartLength += TRACE_UART_RECORD_HEADER + length;
+}
+
+uint16_t traceConfigCrc() {
+    uint16_t crc = 0xFFFF;
+    lockConfig();
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        const FootswitchConfig &fs = footswitches[i];
+        uint8_t head[3] = {(uint8_t)fs.enabled, fs.gestureMask, fs.midiLength};
+        crc = crc16Ccitt(head, sizeof(head), crc);
+        crc = crc16Ccitt(fs.midiBytes, fs.midiLength, crc);
+    }
+    unlockConfig();
+    return crc;
+}
+
+bool startTrace() {
+    if (isDumping()) return false;
+    traceRecording.store(false, std::memory_order_relaxed);
+
+    traceBank = getActiveBank();
+    traceConfig = traceConfigCrc();
+    traceCalibrated = getLadderCalibration(traceCalibration);
+    ladderCount.store(0, std::memory_order_relaxed);
+    ladderFull.store(false, std::memory_order_relaxed);
+    uartLength = 0;
+    uartFull = false;
+    traceStartUs = micros();
+
+    recordingActive = true;
+    traceRecording.store(true, std::memory_order_release);
+    return true;
+}
+
+void stopTrace() {
+    traceRecording.store(false, std::memory_order_relaxed);
+    recordingActive = false;
+}
+
+static bool isTraceTruncated() {
+    return ladderFull.load(std::memory_order_relaxed) || uartFull;
+}
+
+// The header goes out at once, like any response; the streams follow
+// from serviceTrace()
+bool startTraceDump() {
+    if (isDumping()) return false;
+    stopTrace();
+
+    JsonDocument doc(responseArena.reset());
+    doc["type"] = "trace";
+    doc["status"] = "success";
+    doc["version"] = TRACE_VERSION;
+    doc["rate_hz"] = getLadderSampleRate();
+    doc["switches"] = NUM_FOOTSWITCHES;
+    doc["debounce_ms"] = DEBOUNCE_DELAY;
+    doc["bank"] = traceBank;
+    doc["config_crc"] = traceConfig;
+    doc["start_us"] = traceStartUs;
+    if (traceCalibrated) {
+        JsonObject cal = doc["calibration"].to<JsonObject>();
+        if (traceCalibration.idleLevel != LADDER_LEVEL_UNSET) {
+            cal["idle"] = traceCalibration.idleLevel;
+        }
+        JsonArray levels = cal["levels"].to<JsonArray>();
+        for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+            levels.add(traceCalibration.levels[i]);
+        }
+    } else {
+        doc["calibration"] = nullptr;
+    }
+    doc["ladder_samples"] = ladderCount.load(std::memory_order_acquire);
+    doc["uart_bytes"] = uartLength;
+    doc["truncated"] = isTraceTruncated();
+    serializeJson(doc, Serial);
+    Serial.println();
+
+    dumpPhase = TRACE_DUMP_LADDER;
+    dumpOffset = 0;
+    dumpLineLength = 0;
+    return true;
+}
+
+void sendTraceStatus() {
+    JsonDocument doc(responseArena.reset());
+    doc["type"] = "trace_status";
+    doc["status"] = "success";
+    const char *state = "idle";
+    if (isDumping()) {
+        state = "dumping";
+    } else if (traceRecording.load(std::memory_order_relaxed)) {
+        state = "recording";
+    }
+    doc["state"] = state;
+    doc["ladder_samples"] = ladderCount.load(std::memory_order_acquire);
+    doc["ladder_capacity"] = TRACE_LADDER_SAMPLES;
+    doc["uart_bytes"] = uartLength;
+    doc["uart_capacity"] = TRACE_UART_BYTES;
+    doc["truncated"] = isTraceTruncated();
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+static void formatDataLine(const char *stream, const uint8_t *data, size_t length) {
+    size_t chunk = min(length - dumpOffset, (size_t)TRACE_DUMP_CHUNK);
+    int used = snprintf(dumpLine, sizeof(dumpLine), "{\"type\":\"trace_data\",\"stream\":\"%s\",\"offset\":%lu,\"hex\":\"",
+                        stream, (unsigned long)dumpOffset);
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    for (size_t i = 0; i < chunk; ++i) {
+        uint8_t byte = data[dumpOffset + i];
+        dumpLine[used++] = HEX_DIGITS[byte >> 4];
+        dumpLine[used++] = HEX_DIGITS[byte & 0x0F];
+    }
+    memcpy(dumpLine + used, "\"}\r\n", 4);
+    dumpLineLength = used + 4;
+    dumpOffset += chunk;
+}
+
+// Format the next dump line; false once the dump is complete
+static bool formatNextDumpLine() {
+    // Little-endian on the ESP32: the tool reads u16 dt, u16 value
+    const uint8_t *ladderBytes = (const uint8_t *)ladderEntries;
+    size_t ladderBytesLength = ladderCount.load(std::memory_order_acquire) * sizeof(TraceLadderEntry);
+
+    switch (dumpPhase) {
+        case TRACE_DUMP_LADDER:
+            if (dumpOffset < ladderBytesLength) {
+                formatDataLine("ladder", ladderBytes, ladderBytesLength);
+                return true;
+            }
+            dumpPhase = TRACE_DUMP_UART;
+            dumpOffset = 0;
+            // Fall through
+        case TRACE_DUMP_UART:
+            if (dumpOffset < uartLength) {
+                formatDataLine("uart", uartRecords, uartLength);
+                return true;
+            }
+            dumpPhase = TRACE_DUMP_END;
+            // Fall through
+        case TRACE_DUMP_END:
+            dumpLineLength = snprintf(dumpLine, sizeof(dumpLine),
+                                      "{\"type\":\"trace_end\",\"ladder_samples\":%lu,\"uart_bytes\":%lu}\r\n",
+                                      (unsigned long)(ladderBytesLength / sizeof(TraceLadderEntry)),
+                                      (unsigned long)uartLength);
+            dumpPhase = TRACE_DUMP_IDLE;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Arduino loop: report a recording that filled up, and write as much of a
+// dump as the host UART takes without blocking
+void serviceTrace() {
+    if (recordingActive && !traceRecording.load(std::memory_order_relaxed)) {
+        recordingActive = false;
+        printJsonLog("info", "Trace buffer full, recording stopped");
+    }
+
+    for (int i = 0; i < TRACE_DUMP_LINES_PER_PASS; ++i) {
+        if (dumpLineLength == 0 && !formatNextDumpLine()) break;
+        if ((size_t)Serial.availableForWrite() < dumpLineLength) break;
+        Serial.write((const uint8_t *)dumpLine, dumpLineLength);
+        dumpLineLength = 0;
+    }
+}
@@ -3,52 +3,217 @@
 #include "utils.h"
 #include "display.h"
 #include "switches.h"
+#include "ladder.h"
+#include "binary_protocol.h"
+#include "banks.h"
+#include "midi_input.h"
+#include "stats.h"
+#include "pedals.h"
+#include "events.h"
+#include "trace.h"
+#include "boot.h"
+
+// Command line assembly: a fixed buffer, never the heap. Bytes beyond
+// UART_MAX_LINE_LENGTH are dropped until the next newline and reported.
+static char lineBuffer[UART_MAX_LINE_LENGTH + 1];
+static size_t lineLength = 0;
+static bool lineOverflowed = false;
+
+// Parse pool for incoming commands, reset for every line
+static uint8_t commandArenaBuffer[JSON_COMMAND_ARENA_SIZE];
+static JsonArena commandArena(commandArenaBuffer, sizeof(commandArenaBuffer));
+
+UartStats uartStats = {0, 0, 0};
 
 void uart_init(unsigned long baudRate) {
     Serial.begin(baudRate);
     printJsonLog("info", "UART initialized");
 }
 
-void uart_loop() {
-    static String uartBuffer = "";
-    static bool uartComplete = false;
+// Hand a complete line to the dispatcher with surrounding whitespace removed
+static void dispatchLine() {
+    size_t start = 0;
+    size_t end = lineLength;
+    while (start < end && isspace((unsigned char)lineBuffer[start])) ++start;
+    while (end > start && isspace((unsigned char)lineBuffer[end - 1])) --end;
+
+    if (end > start) {
+        lineBuffer[end] = '\0';
+        processUartCommand(lineBuffer + start, end - start);
+    }
+}
+
+// During a binary session, set once a control byte shows the current line is
+// frame data (every frame starts with the version byte); cleared at 0x00
+static bool lineInFrame = false;
+
+// A JSON command received during a binary session ends it
+static bool isJsonCommandLine() {
+    size_t start = 0;
+    size_t end = lineLength;
+    while (start < end && isspace((unsigned char)lineBuffer[start])) ++start;
+    while (end > start && isspace((unsigned char)lineBuffer[end - 1])) --end;
+    if (end - start < 2 || lineBuffer[start] != '{' || lineBuffer[end - 1] != '}') return false;
+
+    for (size_t i = start; i < end; ++i) {
+        if ((unsigned char)lineBuffer[i] < 0x20) return false;
+    }
+    return true;
+}
 
+void uart_loop() {
     while (Serial.available()) {
         char inChar = (char)Serial.read();
+
+        // The mode can change mid-batch (handshake or OP_BYE), so check per byte.
+        // Binary bytes are also tracked as lines, so a host that restarted in
+        // JSON mode gets its command answered.
+        bool binary = isBinaryProtocolActive();
+        if (binary) {
+            binaryProtocolReceive((uint8_t)inChar);
+            if ((uint8_t)inChar < 0x20 && !isspace((unsigned char)inChar)) {
+                lineInFrame = inChar != '\0';
+            }
+        }
+
         if (inChar == '\n') {
-            uartComplete = true;
+            if (binary) {
+                if (!lineInFrame && !lineOverflowed && isJsonCommandLine()) {
+                    stopBinaryProtocol();
+                    printJsonLog("warn", "JSON command during binary session, back to JSON");
+                    dispatchLine();
+                }
+            } else if (lineOverflowed) {
+                ++uartStats.lineOverflows;
+                printJsonLogf("error", "Line too long (max %u bytes)", (unsigned)UART_MAX_LINE_LENGTH);
+            } else {
+                dispatchLine();
+            }
+            lineLength = 0;
+            lineOverflowed = false;
+        } else if (binary && inChar == '\0') {
+            lineLength = 0;
+            lineOverflowed = false;
+        } else if (lineLength < UART_MAX_LINE_LENGTH) {
+            lineBuffer[lineLength++] = inChar;
         } else {
-            uartBuffer += inChar;
+            lineOverflowed = true;
         }
     }
+}
 
-    if (uartComplete) {
-        uartBuffer.trim();
-        if (uartBuffer.length() > 0) {
-            processUartCommand(uartBuffer);
-        }
-        uartBuffer = "";
-        uartComplete = false;
+static void sendMidiStats() {
+    JsonDocument doc(responseArena.reset());
+    doc["type"] = "midi_stats";
+    doc["status"] = "success";
+
+    JsonObject out = doc["output"].to<JsonObject>();
+    out["bytes_queued"] = midiTxStats.bytesQueued;
+    out["bytes_sent"] = midiTxStats.bytesSent;
+    out["status_bytes_saved"] = midiTxStats.statusBytesSaved;
+    out["queue_full"] = midiTxStats.queueFull;
+    JsonObject latency = out["max_latency_us"].to<JsonObject>();
+    latency["input"] = midiTxStats.maxLatencyUs[MIDI_PRODUCER_INPUT];
+    latency["host"] = midiTxStats.maxLatencyUs[MIDI_PRODUCER_HOST];
+    latency["thru"] = midiTxStats.maxLatencyUs[MIDI_PRODUCER_THRU];
+    latency["continuous"] = midiTxStats.continuousMaxLatencyUs;
+    out["continuous_sent"] = midiTxStats.continuousSent;
+    out["continuous_coalesced"] = midiTxStats.continuousCoalesced;
+
+    JsonObject in = doc["input"].to<JsonObject>();
+    in["bytes_received"] = midiInputStats.bytesReceived;
+    in["dropped_bytes"] = midiInputStats.droppedBytes;
+    in["thru"] = (bool)midiThruEnabled;
+    in["thru_messages"] = midiInputStats.thruMessages;
+    JsonObject messages = in["messages"].to<JsonObject>();
+    for (uint8_t i = 0; i < MIDI_IN_TYPE_COUNT; i++) {
+        messages[midiInputTypeName(i)] = midiInputStats.messages[i];
+    }
+
+    JsonObject clock = doc["clock"].to<JsonObject>();
+    clock["quarter_us"] = getMidiClockQuarterUs();
+    clock["bpm"] = getMidiClockBpm();
+
+    JsonArray pedals = doc["pedals"].to<JsonArray>();
+    for (int i = 0; i < PEDAL_COUNT; i++) {
+        JsonObject pedal = pedals.add<JsonObject>();
+        pedal["level"] = pedalStats[i].level;
+        pedal["value"] = pedalStats[i].value;
+        pedal["messages"] = pedalStats[i].messages;
+        pedal["rate_limited"] = pedalStats[i].rateLimited;
+    }
+
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+// Report heap and pool usage so allocation-free dispatch can be verified
+static void sendHeapStats() {
+    JsonDocument doc(responseArena.reset());
+    doc["type"] = "heap_stats";
+    doc["status"] = "success";
+    doc["free_heap"] = ESP.getFreeHeap();
+    doc["min_free_heap"] = ESP.getMinFreeHeap();
+    doc["max_alloc_heap"] = ESP.getMaxAllocHeap();
+    doc["commands"] = uartStats.commands;
+    doc["line_overflows"] = uartStats.lineOverflows;
+    doc["parse_failures"] = uartStats.parseFailures;
+
+    JsonObject command = doc["command_arena"].to<JsonObject>();
+    command["capacity"] = commandArena.capacity();
+    command["peak"] = commandArena.peak();
+    command["failures"] = commandArena.failures();
+
+    JsonObject response = doc["response_arena"].to<JsonObject>();
+    response["capacity"] = responseArena.capacity();
+    response["peak"] = responseArena.peak();
+    response["failures"] = responseArena.failures();
+
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+// Optional "bank" field of a command; defaults to the active bank.
+// Returns -1 (after reporting) if it is out of range.
+static int commandBank(JsonDocument &doc) {
+    int bank = doc["bank"] | (int)getActiveBank();
+    if (bank < 0 || bank >= BANK_COUNT) {
+        blinkLed(BLINK_ERROR);
+        printJsonLog("error", "Invalid bank");
+        return -1;
     }
+    return bank;
 }
 
-void processUartCommand(String command) {
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, command);
+void processUartCommand(const char *command, size_t length) {
+    ++uartStats.commands;
+
+    JsonDocument doc(commandArena.reset());
+    uint32_t parseStartUs = micros();
+    DeserializationError error = deserializeJson(doc, command, length);
+    recordLatency(HIST_UART_PARSE, micros() - parseStartUs);
 
     if (error) {
-        printJsonLog("error", "Invalid JSON");
+        ++uartStats.parseFailures;
+        printJsonLog("error", error == DeserializationError::NoMemory ? "Command too large" : "Invalid JSON");
         return;
     }
 
-    String type = doc["type"];
+    const char *type = doc["type"] | "";
+    if (strcmp(type, "trace") != 0) {
+        traceUartCommand(command, length);
+    }
 
-    if (type == "get_config") {
+    if (strcmp(type, "get_config") == 0) {
+        int bank = commandBank(doc);
+        if (bank < 0) return;
         blinkLed(BLINK_GET_CONFIG);
-        sendCurrentConfig();
+        sendCurrentConfig(bank);
     }
-    else if (type == "set_config") {
-        JsonArray switches = doc["switches"];
+    else if (strcmp(type, "set_config") == 0) {
+        JsonArrayConst switches = doc["switches"];
+        int bank = commandBank(doc);
+        if (bank < 0) return;
 
         if (switches.size() != NUM_FOOTSWITCHES) {
             blinkLed(BLINK_ERROR);
@@ -56,34 +221,270 @@ void processUartCommand(String command) {
             return;
         }
 
-        // Update configuration
+        // Entries go to their "id" (position when absent); each switch exactly once
+        int targets[NUM_FOOTSWITCHES];
+        bool seen[NUM_FOOTSWITCHES] = {};
+        for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
+            int id = switches[i]["id"] | i;
+            if (id < 0 || id >= NUM_FOOTSWITCHES) {
+                blinkLed(BLINK_ERROR);
+                printJsonLog("error", "Invalid switch ID");
+                return;
+            }
+            if (seen[id]) {
+                blinkLed(BLINK_ERROR);
+                printJsonLog("error", "Duplicate switch ID");
+                return;
+            }
+            seen[id] = true;
+            targets[i] = id;
+        }
+
+        // Pedals and bank navigation switches are global, not part of a bank
+        JsonArrayConst pedals = doc["pedals"];
+        char error[48];
+        if (!pedals.isNull() && !applyPedalsConfig(pedals, error, sizeof(error))) {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", error);
+            return;
+        }
+
+        JsonObjectConst nav = doc["bank_nav"];
+        if (!nav.isNull()) {
+            bankNav.prevSwitch = nav["prev"] | BANK_NAV_NONE;
+            bankNav.nextSwitch = nav["next"] | BANK_NAV_NONE;
+            saveBankNavToFlash();
+        }
+
+        // Build the new table aside, then swap it in
+        FootswitchConfig *staged = stageBankUpdate(bank);
         for (int i = 0; i < NUM_FOOTSWITCHES; i++) {
-            JsonObject sw = switches[i];
-            footswitches[i].name = sw["name"].as<String>();
-            footswitches[i].midiChannel = sw["channel"];
-            footswitches[i].midiCC = sw["cc"];
-            footswitches[i].midiValue = sw["value"];
-            footswitches[i].enabled = sw["enabled"];
-            footswitches[i].color = hexStringToColor(sw["color"].as<String>());
-        }
-
-        saveConfigToFlash();
-        blinkLed(BLINK_SET_CONFIG);
-        showConfiguringMessage(); // Show configuring message for 3 seconds
+            applySwitchConfig(staged[targets[i]], switches[i]);
+        }
+        publishBankUpdate(bank);
+
+        commitConfigUpdate(bank);
         printJsonLog("response", "Configuration updated");
     }
-    else if (type == "test_switch") {
+    else if (strcmp(type, "patch_switch") == 0) {
+        // Change individual fields of one switch; flash is written later
+        int switchId = doc["switch_id"] | -1;
+        if (switchId < 0 || switchId >= NUM_FOOTSWITCHES) {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", "Invalid switch ID");
+            return;
+        }
+        int bank = commandBank(doc);
+        if (bank < 0) return;
+
+        FootswitchConfig *target = getBankSwitches(bank);
+        lockConfig();
+        bool changed = patchSwitchConfig(target[switchId], doc.as<JsonObjectConst>());
+        unlockConfig();
+
+        if (changed) {
+            scheduleConfigCommit(bank, switchId);
+            postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_FOOTSWITCH);
+            postDisplayEvent(DISPLAY_PRODUCER_HOST, DISPLAY_EVENT_CONFIG);
+        }
+        printJsonLogf("response", "Switch %d patched", switchId + 1);
+    }
+    else if (strcmp(type, "commit") == 0) {
+        bool written = commitPendingConfig();
+
+        JsonDocument response(responseArena.reset());
+        response["type"] = "response";
+        response["status"] = "success";
+        response["message"] = written ? "Configuration committed" : "Nothing to commit";
+        response["flash_writes"] = configPersistStats.flashWrites;
+        response["writes_avoided"] = configPersistStats.writesAvoided;
+        response["patches"] = configPersistStats.patches;
+        response["write_failures"] = configPersistStats.writeFailures;
+        serializeJson(response, Serial);
+        Serial.println();
+    }
+    else if (strcmp(type, "set_pedals") == 0) {
+        char error[48];
+        if (!applyPedalsConfig(doc["pedals"], error, sizeof(error))) {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", error);
+            return;
+        }
+        printJsonLog("response", "Pedals updated");
+    }
+    else if (strcmp(type, "select_bank") == 0) {
+        int bank = doc["bank"] | -1;
+        if (bank < 0 || bank >= BANK_COUNT) {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", "Invalid bank");
+            return;
+        }
+        if (!selectBank(bank, DISPLAY_PRODUCER_HOST)) serviceBanks();  // Not resident yet: load and switch now
+        printJsonLogf("response", "Bank %d selected", bank + 1);
+    }
+    else if (strcmp(type, "test_switch") == 0) {
         int switchId = doc["switch_id"];
         if (switchId >= 0 && switchId < NUM_FOOTSWITCHES) {
             blinkLed(BLINK_TEST_SWITCH);
-            sendMidiCC(switchId);
-            printJsonLog("response", "Switch " + String(switchId + 1) + " tested");
+            queueSwitchMidi(MIDI_PRODUCER_HOST, switchId);
+            printJsonLogf("response", "Switch %d tested", switchId + 1);
         } else {
             blinkLed(BLINK_ERROR);
             printJsonLog("error", "Invalid switch ID");
         }
     }
-    else if (type == "ping") {
+    else if (strcmp(type, "calibrate_ladder") == 0) {
+        // Hold a switch (or none, switch_id -1) and send "capture" for it;
+        // "save" rebuilds the classification table and stores it in flash.
+        const char *action = doc["action"] | "capture";
+
+        if (strcmp(action, "capture") == 0) {
+            int switchId = doc["switch_id"] | -1;
+            if (switchId >= NUM_FOOTSWITCHES) {
+                blinkLed(BLINK_ERROR);
+                printJsonLog("error", "Invalid switch ID");
+                return;
+            }
+            uint16_t value = captureLadderLevel(switchId);
+            if (switchId < 0) {
+                printJsonLogf("response", "Captured idle at %u", value);
+            } else {
+                printJsonLogf("response", "Captured switch %d at %u", switchId + 1, value);
+            }
+        }
+        else if (strcmp(action, "save") == 0) {
+            char error[48];
+            if (saveLadderCalibration(error, sizeof(error))) {
+                blinkLed(BLINK_SET_CONFIG);
+                printJsonLog("response", "Ladder calibration saved");
+            } else {
+                blinkLed(BLINK_ERROR);
+                printJsonLog("error", error);
+            }
+        }
+        else if (strcmp(action, "reset") == 0) {
+            resetLadderCalibration();
+            printJsonLog("response", "Ladder calibration reset");
+        }
+        else {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", "Unknown calibration action");
+        }
+    }
+    else if (strcmp(type, "display_stats") == 0) {
+        sendDisplayStats();
+    }
+    else if (strcmp(type, "midi_stats") == 0) {
+        sendMidiStats();
+        if (doc["reset"] | false) requestMidiStatsReset();
+    }
+    else if (strcmp(type, "get_stats") == 0) {
+        // Report first, so a reset returns the totals it cleared
+        sendStats();
+        if (doc["reset"] | false) resetStats();
+    }
+    else if (strcmp(type, "midi_inject") == 0) {
+        // Simulated MIDI IN stream, parsed at wire speed by the input task
+        JsonArrayConst data = doc["bytes"];
+        uint8_t bytes[MIDI_INJECT_QUEUE_SIZE];
+        size_t count = 0;
+        for (JsonVariantConst value : data) {
+            if (count == sizeof(bytes)) break;
+            bytes[count++] = value.as<uint8_t>();
+        }
+        if (count == 0 || count < data.size() || !injectMidiInput(bytes, count)) {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", "MIDI inject queue full");
+            return;
+        }
+        printJsonLogf("response", "%u MIDI bytes injected", (unsigned)count);
+    }
+    else if (strcmp(type, "midi_thru") == 0) {
+        midiThruEnabled = doc["enabled"] | true;
+        printJsonLog("response", midiThruEnabled ? "MIDI THRU on" : "MIDI THRU off");
+    }
+    else if (strcmp(type, "heap_stats") == 0) {
+        sendHeapStats();
+    }
+    else if (strcmp(type, "boot_profile") == 0) {
+        sendBootProfile();
+    }
+    else if (strcmp(type, "subscribe") == 0) {
+        // Without "events" every kind is sent
+        uint8_t mask = (1u << HOST_EVENT_KIND_COUNT) - 1;
+        JsonArrayConst kinds = doc["events"];
+        if (!kinds.isNull()) {
+            mask = 0;
+            for (JsonVariantConst name : kinds) {
+                HostEventKind kind;
+                if (!parseEventKind(name | "", kind)) {
+                    blinkLed(BLINK_ERROR);
+                    printJsonLog("error", "Unknown event kind");
+                    return;
+                }
+                mask |= 1u << kind;
+            }
+        }
+        uint32_t sequence = subscribeEvents(mask);
+
+        JsonDocument response(responseArena.reset());
+        response["type"] = "response";
+        response["status"] = "success";
+        response["message"] = mask != 0 ? "Subscribed" : "Unsubscribed";
+        JsonArray events = response["events"].to<JsonArray>();
+        for (uint8_t i = 0; i < HOST_EVENT_KIND_COUNT; ++i) {
+            if (mask & (1u << i)) events.add(eventKindName(i));
+        }
+        response["seq"] = sequence;
+        response["sent"] = eventStats.sent;
+        response["dropped"] = eventStats.dropped;
+        serializeJson(response, Serial);
+        Serial.println();
+    }
+    else if (strcmp(type, "unsubscribe") == 0) {
+        subscribeEvents(0);
+        printJsonLogf("response", "Unsubscribed: %lu events sent, %lu dropped",
+                      (unsigned long)eventStats.sent, (unsigned long)eventStats.dropped);
+    }
+    else if (strcmp(type, "trace") == 0) {
+        const char *action = doc["action"] | "status";
+        if (strcmp(action, "start") == 0) {
+            if (!startTrace()) {
+                blinkLed(BLINK_ERROR);
+                printJsonLog("error", "Trace dump in progress");
+                return;
+            }
+            printJsonLog("response", "Trace recording started");
+        } else if (strcmp(action, "stop") == 0) {
+            stopTrace();
+            sendTraceStatus();
+        } else if (strcmp(action, "dump") == 0) {
+            if (!startTraceDump()) {
+                blinkLed(BLINK_ERROR);
+                printJsonLog("error", "Trace dump in progress");
+            }
+        } else if (strcmp(action, "status") == 0) {
+            sendTraceStatus();
+        } else {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", "Unknown trace action");
+        }
+    }
+    else if (strcmp(type, "binary_hello") == 0) {
+        // Reply in JSON, then every following byte is COBS-framed binary
+        int version = doc["version"] | BINARY_PROTOCOL_VERSION;
+        if (version != BINARY_PROTOCOL_VERSION) {
+            blinkLed(BLINK_ERROR);
+            printJsonLog("error", "Unsupported binary protocol version");
+            return;
+        }
+        // Event lines would break the framing; the binary session has no stream
+        subscribeEvents(0);
+        printJsonLogf("response", "Binary protocol v%d enabled", BINARY_PROTOCOL_VERSION);
+        Serial.flush();
+        startBinaryProtocol();
+    }
+    else if (strcmp(type, "ping") == 0) {
         blinkLed(BLINK_PING);
         printJsonLog("response", "Ping received");
     }
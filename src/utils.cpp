@@ -1,59 +1,159 @@
 #include "utils.h"
+#include "binary_protocol.h"
+#include <stdarg.h>
 
 // LED pin for feedback
 const int LED_PIN = 2;
 
-void printJsonLog(const String &type, const String &message) {
-    JsonDocument doc;
-    doc["type"] = type;
-    doc["message"] = message;
-    String output;
-    serializeJson(doc, output);
-    Serial.println(output);
+static uint8_t responseArenaBuffer[JSON_RESPONSE_ARENA_SIZE];
+JsonArena responseArena(responseArenaBuffer, sizeof(responseArenaBuffer));
+
+// Append text as a JSON string body (without quotes), escaping as needed
+static size_t appendJsonEscaped(char *out, size_t pos, size_t capacity, const char *text) {
+    for (; *text != '\0' && pos + 7 < capacity; ++text) {
+        char c = *text;
+        if (c == '"' || c == '\\') {
+            out[pos++] = '\\';
+            out[pos++] = c;
+        } else if ((uint8_t)c < 0x20) {
+            pos += snprintf(out + pos, capacity - pos, "\\u%04x", (uint8_t)c);
+        } else {
+            out[pos++] = c;
+        }
+    }
+    return pos;
 }
 
-void blinkLed(BlinkType type) {
-    int count = 1;
-    int onTime = 100;
-    int offTime = 100;
+static size_t appendRaw(char *out, size_t pos, size_t capacity, const char *text) {
+    while (*text != '\0' && pos + 1 < capacity) {
+        out[pos++] = *text++;
+    }
+    return pos;
+}
+
+// Writes {"type":...,"message":...} from a stack buffer in a single write,
+// so logging allocates nothing and lines from different tasks do not interleave
+void printJsonLog(const char *type, const char *message) {
+    // Plain text would corrupt the framing while a binary session is open
+    if (isBinaryProtocolActive()) {
+        sendBinaryLog(type, message);
+        return;
+    }
+
+    char line[JSON_LOG_MAX_LENGTH];
+    size_t pos = 0;
+    pos = appendRaw(line, pos, sizeof(line), "{\"type\":\"");
+    pos = appendJsonEscaped(line, pos, sizeof(line) - 16, type);
+    pos = appendRaw(line, pos, sizeof(line), "\",\"message\":\"");
+    pos = appendJsonEscaped(line, pos, sizeof(line) - 5, message);
+    pos = appendRaw(line, pos, sizeof(line), "\"}\r\n");
+    Serial.write((const uint8_t *)line, pos);
+}
+
+void printJsonLogf(const char *type, const char *format, ...) {
+    char message[JSON_LOG_MAX_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    printJsonLog(type, message);
+}
+
+// Non-blocking LED pattern player. blinkLed() only queues a pattern;
+// updateLed() advances it from the main loop, so callers never stall.
+struct BlinkPattern {
+    uint8_t count;
+    uint16_t onTime;
+    uint16_t offTime;
+};
+
+static BlinkPattern blinkPatternFor(BlinkType type) {
     switch (type) {
-        case BLINK_GET_CONFIG:
-            count = 1; onTime = 100; offTime = 150;
-            break;
-        case BLINK_SET_CONFIG:
-            count = 2; onTime = 100; offTime = 150;
-            break;
-        case BLINK_TEST_SWITCH:
-            count = 1; onTime = 400; offTime = 200;
-            break;
-        case BLINK_PING:
-            count = 1; onTime = 100; offTime = 100;
-            break;
-        case BLINK_ERROR:
-            count = 3; onTime = 60; offTime = 80;
-            break;
+        case BLINK_GET_CONFIG:  return {1, 100, 150};
+        case BLINK_SET_CONFIG:  return {2, 100, 150};
+        case BLINK_TEST_SWITCH: return {1, 400, 200};
+        case BLINK_PING:        return {1, 100, 100};
+        case BLINK_ERROR:       return {3, 60, 80};
+    }
+    return {1, 100, 100};
+}
+
+static BlinkType ledQueue[LED_QUEUE_SIZE];
+static uint8_t ledQueueHead = 0;
+static uint8_t ledQueueCount = 0;
+
+static bool ledActive = false;
+static BlinkPattern ledPattern;
+static uint8_t ledPhase = 0;           // Even phases LED on, odd phases off
+static unsigned long ledPhaseStart = 0;
+
+static void startBlinkPattern(BlinkType type) {
+    ledPattern = blinkPatternFor(type);
+    ledPhase = 0;
+    ledPhaseStart = millis();
+    ledActive = true;
+    digitalWrite(LED_PIN, HIGH);
+}
+
+// Queue a pattern behind the one playing. BLINK_ERROR preempts: it drops
+// anything queued and restarts the LED immediately.
+void blinkLed(BlinkType type) {
+    if (type == BLINK_ERROR) {
+        ledQueueCount = 0;
+        startBlinkPattern(type);
+        return;
+    }
+    if (!ledActive) {
+        startBlinkPattern(type);
+        return;
     }
-    for (int i = 0; i < count; i++) {
-        digitalWrite(LED_PIN, HIGH);
-        delay(onTime);
-        digitalWrite(LED_PIN, LOW);
-        if (i < count - 1) delay(offTime);
+    if (ledQueueCount < LED_QUEUE_SIZE) {
+        ledQueue[(ledQueueHead + ledQueueCount) % LED_QUEUE_SIZE] = type;
+        ++ledQueueCount;
     }
 }
 
+void updateLed() {
+    if (!ledActive) return;
+
+    unsigned long now = millis();
+    uint16_t duration = (ledPhase % 2 == 0) ? ledPattern.onTime : ledPattern.offTime;
+    if (now - ledPhaseStart < duration) return;
+
+    ++ledPhase;
+    ledPhaseStart = now;
+
+    // The final off phase separates this pattern from the next one
+    if (ledPhase >= ledPattern.count * 2) {
+        if (ledQueueCount > 0) {
+            BlinkType next = ledQueue[ledQueueHead];
+            ledQueueHead = (ledQueueHead + 1) % LED_QUEUE_SIZE;
+            --ledQueueCount;
+            startBlinkPattern(next);
+        } else {
+            ledActive = false;
+        }
+        return;
+    }
+
+    digitalWrite(LED_PIN, (ledPhase % 2 == 0) ? HIGH : LOW);
+}
+
 // Convert hex string to RGB565 color
-uint16_t hexStringToColor(const String &hexStr) {
-    String cleanHex = hexStr;
-    if (cleanHex.startsWith("#")) {
-        cleanHex = cleanHex.substring(1);
+uint16_t hexStringToColor(const char *hexStr) {
+    if (hexStr == NULL) {
+        return WHITE;
+    }
+    if (hexStr[0] == '#') {
+        ++hexStr;
     }
     
-    if (cleanHex.length() != 6) {
+    if (strlen(hexStr) != 6) {
         return WHITE; // Default to white if invalid hex
     }
     
     // Convert hex string to long
-    long hexValue = strtol(cleanHex.c_str(), NULL, 16);
+    long hexValue = strtol(hexStr, NULL, 16);
     
     // Extract RGB components
     uint8_t r = (hexValue >> 16) & 0xFF;
@@ -64,15 +164,24 @@ uint16_t hexStringToColor(const String &hexStr) {
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
 }
 
-// Convert RGB565 color to hex string
-String colorToHexString(uint16_t color) {
+// Convert RGB565 color to "#RRGGBB"
+void colorToHexString(uint16_t color, char hexStr[8]) {
     // Convert RGB565 to RGB888
     uint8_t r = (color >> 8) & 0xF8;
     uint8_t g = (color >> 3) & 0xFC;
     uint8_t b = (color << 3) & 0xF8;
     
     // Format as hex string
-    char hexStr[8];
-    sprintf(hexStr, "#%02X%02X%02X", r, g, b);
-    return String(hexStr);
-}
\ No newline at end of file
+    snprintf(hexStr, 8, "#%02X%02X%02X", r, g, b);
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021), bitwise to avoid a 512-byte table
+uint16_t crc16Ccitt(const uint8_t *data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
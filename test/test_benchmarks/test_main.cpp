@@ -0,0 +1,323 @@
+// Host benchmarks for the firmware hot paths, run with `pio test -e native`.
+//
+// Each benchmark prints one JSON line, e.g.
+//   {"bench":"uart_get_config","iterations":200,"mean_ns":41000,"p50_ns":40100,
+//    "p99_ns":52000,"max_ns":61000,"serial_bytes":1480}
+// and appends it to the file named by $BENCH_RESULTS when that is set, so
+// two runs can be compared line by line. Timings are host timings: compare
+// them between runs on the same machine, not with the ESP32. Byte and pixel
+// counts are deterministic and are checked against the retained-model rules.
+
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "mock_hal.h"
+#include "config.h"
+#include "uart.h"
+#include "ladder.h"
+#include "display.h"
+#include "banks.h"
+#include "switches.h"
+#include "log.h"
+#include "tile_cache.h"
+#include "MultiTFTBus.hpp"
+
+typedef std::chrono::steady_clock BenchClock;
+
+static uint64_t elapsedNs(BenchClock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+}
+
+// Print one result line; extra is a preformatted JSON fragment (or "")
+static void report(const char *name, std::vector<uint64_t> samples, const char *extra) {
+    std::sort(samples.begin(), samples.end());
+    uint64_t total = 0;
+    for (size_t i = 0; i < samples.size(); ++i) total += samples[i];
+    size_t n = samples.size();
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "{\"bench\":\"%s\",\"iterations\":%u,\"mean_ns\":%llu,\"p50_ns\":%llu,"
+             "\"p99_ns\":%llu,\"max_ns\":%llu%s%s}",
+             name, (unsigned)n, (unsigned long long)(total / n),
+             (unsigned long long)samples[n / 2], (unsigned long long)samples[n * 99 / 100],
+             (unsigned long long)samples[n - 1], extra[0] ? "," : "", extra);
+    printf("%s\n", line);
+
+    const char *path = getenv("BENCH_RESULTS");
+    if (path != NULL) {
+        FILE *file = fopen(path, "a");
+        if (file != NULL) {
+            fprintf(file, "%s\n", line);
+            fclose(file);
+        }
+    }
+}
+
+// Time one command through the full UART dispatcher (parse, handle, respond)
+static void benchCommand(const char *name, const char *command, int iterations) {
+    std::vector<uint64_t> samples;
+    size_t responseBytes = 0;
+    uint32_t flashBefore = mockPreferencesBytesWritten();
+
+    for (int i = 0; i < iterations; ++i) {
+        Serial.tx.clear();
+        BenchClock::time_point start = BenchClock::now();
+        processUartCommand(command, strlen(command));
+        samples.push_back(elapsedNs(start));
+        responseBytes = Serial.tx.size();
+    }
+
+    TEST_ASSERT_TRUE(responseBytes > 0);
+    char extra[96];
+    snprintf(extra, sizeof(extra), "\"serial_bytes\":%u,\"flash_bytes_per_op\":%u",
+             (unsigned)responseBytes, (unsigned)((mockPreferencesBytesWritten() - flashBefore) / iterations));
+    report(name, samples, extra);
+}
+
+// Drain deferred log records so they do not land in a measured response
+void setUp() {
+    serviceLog();
+    mockResetSerial();
+}
+
+void tearDown() {
+}
+
+void test_uart_get_config() {
+    benchCommand("uart_get_config", "{\"type\":\"get_config\"}", 200);
+    TEST_ASSERT_NOT_NULL(strstr(Serial.tx.c_str(), "\"type\":\"config\""));
+}
+
+void test_uart_patch_switch() {
+    benchCommand("uart_patch_switch",
+                 "{\"type\":\"patch_switch\",\"switch_id\":2,\"color\":\"#20C040\",\"name\":\"CHORUS\"}", 500);
+    TEST_ASSERT_TRUE(isConfigCommitPending());
+    commitPendingConfig();
+}
+
+void test_uart_set_config() {
+    static const char *command =
+        "{\"type\":\"set_config\",\"switches\":["
+        "{\"id\":0,\"name\":\"DRIVE\",\"channel\":1,\"cc\":20,\"value\":127,\"enabled\":true,\"color\":\"#FF0000\"},"
+        "{\"id\":1,\"name\":\"DELAY\",\"channel\":1,\"cc\":21,\"value\":127,\"enabled\":false,\"color\":\"#00FF00\"},"
+        "{\"id\":2,\"name\":\"REVERB\",\"channel\":1,\"cc\":22,\"value\":127,\"enabled\":true,\"color\":\"#0000FF\"},"
+        "{\"id\":3,\"name\":\"CHORUS\",\"channel\":1,\"cc\":23,\"value\":127,\"enabled\":false,\"color\":\"#FFFF00\"},"
+        "{\"id\":4,\"name\":\"SCENE A\",\"channel\":2,\"enabled\":true,\"color\":\"#FF00FF\",\"actions\":["
+            "{\"type\":\"pc\",\"channel\":2,\"program\":5},{\"type\":\"cc\",\"channel\":2,\"cc\":7,\"value\":100},"
+            "{\"type\":\"cc\",\"channel\":2,\"cc\":11,\"value\":64}]},"
+        "{\"id\":5,\"name\":\"TAP\",\"channel\":1,\"cc\":64,\"value\":127,\"enabled\":true,\"color\":\"#00FFFF\"}]}";
+    benchCommand("uart_set_config", command, 200);
+}
+
+void test_config_save() {
+    std::vector<uint64_t> samples;
+    uint32_t flashBefore = mockPreferencesBytesWritten();
+    const int iterations = 500;
+
+    for (int i = 0; i < iterations; ++i) {
+        markBankDirty(0);
+        BenchClock::time_point start = BenchClock::now();
+        saveConfigToFlash();
+        samples.push_back(elapsedNs(start));
+    }
+
+    char extra[64];
+    snprintf(extra, sizeof(extra), "\"flash_bytes_per_op\":%u",
+             (unsigned)((mockPreferencesBytesWritten() - flashBefore) / iterations));
+    report("config_save", samples, extra);
+}
+
+void test_config_load() {
+    FootswitchConfig before[NUM_FOOTSWITCHES];
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) before[i] = footswitches[i];
+
+    std::vector<uint64_t> samples;
+    for (int i = 0; i < 500; ++i) {
+        BenchClock::time_point start = BenchClock::now();
+        loadConfigFromFlash();
+        samples.push_back(elapsedNs(start));
+    }
+
+    // What was saved is what comes back
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, strcmp(footswitches[i].name, before[i].name));
+        TEST_ASSERT_EQUAL_UINT16(before[i].color, footswitches[i].color);
+        TEST_ASSERT_EQUAL_UINT8(before[i].midiLength, footswitches[i].midiLength);
+        TEST_ASSERT_EQUAL_MEMORY(before[i].midiBytes, footswitches[i].midiBytes, before[i].midiLength);
+    }
+    report("config_load", samples, "");
+}
+
+// One sample per sweep of every ADC code, reported per classification
+void test_ladder_classify() {
+    std::vector<uint64_t> samples;
+    int previous = LADDER_NONE;
+    int checksum = 0;
+
+    for (int round = 0; round < 200; ++round) {
+        BenchClock::time_point start = BenchClock::now();
+        for (uint16_t code = 0; code < LADDER_ADC_CODES; ++code) {
+            previous = classifyLadder(code, previous);
+            checksum += previous;
+        }
+        samples.push_back(elapsedNs(start) / LADDER_ADC_CODES);
+    }
+
+    for (uint16_t code = 0; code < LADDER_ADC_CODES; ++code) {
+        int id = classifyLadder(code, LADDER_NONE);
+        TEST_ASSERT_TRUE(id >= LADDER_NONE && id < NUM_FOOTSWITCHES);
+    }
+    char extra[48];
+    snprintf(extra, sizeof(extra), "\"checksum\":%d", checksum);
+    report("ladder_classify", samples, extra);
+}
+
+// Full repaint of a panel; pixels and bytes are per frame
+static void benchFullDraw(const char *name, void (*draw)(), MultiTFT &display, DisplayFrameStats &stats) {
+    std::vector<uint64_t> samples;
+    for (int i = 0; i < 50; ++i) {
+        display.resetPixelsWritten();
+        BenchClock::time_point start = BenchClock::now();
+        draw();
+        samples.push_back(elapsedNs(start));
+    }
+
+    TEST_ASSERT_TRUE(stats.lastFrameBytes > 0);
+    char extra[80];
+    snprintf(extra, sizeof(extra), "\"pixels\":%u,\"bytes\":%u",
+             (unsigned)display.pixelsWritten(), (unsigned)stats.lastFrameBytes);
+    report(name, samples, extra);
+}
+
+void test_draw_footswitch_screen() {
+    benchFullDraw("draw_footswitch_screen", drawFootswitchScreen, footswitchDisplay, footswitchDisplayStats);
+}
+
+void test_draw_config_screen() {
+    benchFullDraw("draw_config_screen", drawConfigScreen, configDisplay, configDisplayStats);
+}
+
+// Incremental updates: nothing changed pushes nothing; one changed tile
+// costs less than the full screen
+void test_update_footswitch_incremental() {
+    drawFootswitchScreen();
+    uint32_t fullFrameBytes = footswitchDisplayStats.lastFrameBytes;
+
+    uint32_t drawnBefore = footswitchDisplayStats.framesDrawn;
+    updateFootswitchDisplay();
+    TEST_ASSERT_EQUAL_UINT32(drawnBefore, footswitchDisplayStats.framesDrawn);
+
+    std::vector<uint64_t> samples;
+    for (int i = 0; i < 100; ++i) {
+        footswitches[2].enabled = !footswitches[2].enabled;
+        footswitchDisplay.resetPixelsWritten();
+        BenchClock::time_point start = BenchClock::now();
+        updateFootswitchDisplay();
+        samples.push_back(elapsedNs(start));
+    }
+
+    TEST_ASSERT_TRUE(footswitchDisplayStats.lastFrameBytes < fullFrameBytes);
+    char extra[80];
+    snprintf(extra, sizeof(extra), "\"pixels\":%u,\"bytes\":%u",
+             (unsigned)footswitchDisplay.pixelsWritten(), (unsigned)footswitchDisplayStats.lastFrameBytes);
+    report("update_footswitch_one_tile", samples, extra);
+}
+
+// Moving the selection redraws two tiles; after the first pass both looks of
+// each tile are cached, so it costs blits only
+void test_update_footswitch_selection() {
+    drawFootswitchScreen();
+    std::vector<uint64_t> samples;
+    uint32_t rendersAfterWarmup = 0;
+
+    for (int i = 0; i < 100; ++i) {
+        if (i == 4) rendersAfterWarmup = tileCacheStats.renders;
+        currentSelectedFootswitch = (i % 2) ? 1 : 3;
+        footswitchDisplay.resetPixelsWritten();
+        BenchClock::time_point start = BenchClock::now();
+        updateFootswitchDisplay();
+        samples.push_back(elapsedNs(start));
+    }
+    currentSelectedFootswitch = -1;
+
+    TEST_ASSERT_EQUAL_UINT32(rendersAfterWarmup, tileCacheStats.renders);
+    TEST_ASSERT_EQUAL_UINT32(0, tileCacheStats.fallbacks);
+    char extra[112];
+    snprintf(extra, sizeof(extra), "\"pixels\":%u,\"bytes\":%u,\"cache_bytes\":%u",
+             (unsigned)footswitchDisplay.pixelsWritten(), (unsigned)footswitchDisplayStats.lastFrameBytes,
+             (unsigned)tileCacheStats.usedBytes);
+    report("update_footswitch_selection", samples, extra);
+}
+
+// Bus scheduling: batches of two panels alternate, a panel's frame marker
+// completes after its batches, and chip select toggles once per turn
+static std::vector<int> busTrace;
+
+static void traceBatch(MultiTFT &panel, void *context) {
+    TEST_ASSERT_TRUE(panel.isSelected());
+    busTrace.push_back((int)(intptr_t)context);
+}
+
+static void traceDone(void *context) {
+    busTrace.push_back(100 + (int)(intptr_t)context);
+}
+
+void test_bus_interleave() {
+    std::vector<uint64_t> samples;
+    uint32_t panelSwitches = 0;
+    for (int round = 0; round < 1000; ++round) {
+        MultiTFTBus bus;
+        TEST_ASSERT_TRUE(bus.attach(footswitchDisplay));
+        TEST_ASSERT_TRUE(bus.attach(configDisplay));
+        TEST_ASSERT_FALSE(bus.attach(footswitchDisplay));
+        busTrace.clear();
+        uint32_t selectsBefore = footswitchDisplay.selectCount() + configDisplay.selectCount();
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < 4; ++i) bus.submit(footswitchDisplay, traceBatch, (void *)(intptr_t)i);
+        bus.submit(footswitchDisplay, NULL, NULL, traceDone, (void *)1);
+        for (int i = 10; i < 12; ++i) bus.submit(configDisplay, traceBatch, (void *)(intptr_t)i);
+        bus.submit(configDisplay, NULL, NULL, traceDone, (void *)2);
+        bus.flush();
+        samples.push_back(elapsedNs(start));
+
+        static const int EXPECTED[] = {0, 10, 1, 11, 2, 102, 3, 101};
+        TEST_ASSERT_EQUAL_UINT32(8, busTrace.size());
+        for (int i = 0; i < 8; ++i) TEST_ASSERT_EQUAL_INT(EXPECTED[i], busTrace[i]);
+        TEST_ASSERT_EQUAL_UINT32(selectsBefore + 5,
+                                 footswitchDisplay.selectCount() + configDisplay.selectCount());
+        TEST_ASSERT_FALSE(footswitchDisplay.isSelected() || configDisplay.isSelected());
+        TEST_ASSERT_EQUAL_UINT32(6, bus.batchesRun());
+        panelSwitches = bus.panelSwitches();
+    }
+
+    char extra[48];
+    snprintf(extra, sizeof(extra), "\"panel_switches\":%u", (unsigned)panelSwitches);
+    report("bus_flush_interleaved", samples, extra);
+}
+
+int main() {
+    // The boot sequence of setup(), without the tasks
+    mockClearPreferences();
+    initializeLog();
+    initializeConfigLock();
+    initializeFootswitchPins();
+    loadConfigFromFlash();
+    initializeBanks();
+    initializeDisplays();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_uart_get_config);
+    RUN_TEST(test_uart_patch_switch);
+    RUN_TEST(test_uart_set_config);
+    RUN_TEST(test_config_save);
+    RUN_TEST(test_config_load);
+    RUN_TEST(test_ladder_classify);
+    RUN_TEST(test_draw_footswitch_screen);
+    RUN_TEST(test_draw_config_screen);
+    RUN_TEST(test_update_footswitch_incremental);
+    RUN_TEST(test_update_footswitch_selection);
+    RUN_TEST(test_bus_interleave);
+    return UNITY_END();
+}
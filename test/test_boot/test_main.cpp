@@ -0,0 +1,83 @@
+// Boot sequence on the host, run with `pio test -e native`. setup() must
+// make the switches live without touching the panels; the display task's
+// bring-up (called directly here, tasks do not run) paints them, and the
+// boot profile is reported once after that.
+
+#include <unity.h>
+#include <string>
+#include "mock_hal.h"
+#include "boot.h"
+#include "display.h"
+
+void setup();
+void loop();
+
+#define SETUP_US 40000UL
+#define PAINT_US 250000UL
+
+static bool contains(const std::string &text, const char *needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_input_ready_before_displays() {
+    TEST_ASSERT_TRUE(bootStageReached(BOOT_STAGE_INPUT_READY));
+    TEST_ASSERT_FALSE(bootStageReached(BOOT_STAGE_DISPLAY_INIT));
+    TEST_ASSERT_FALSE(bootStageReached(BOOT_STAGE_FIRST_PAINT));
+    TEST_ASSERT_EQUAL_UINT32(0, footswitchDisplayStats.framesDrawn + configDisplayStats.framesDrawn);
+
+    for (int i = BOOT_STAGE_SETUP; i < BOOT_STAGE_INPUT_READY; ++i) {
+        TEST_ASSERT_TRUE(bootStageReached((BootStage)i));
+        TEST_ASSERT_TRUE(bootStageUs((BootStage)i) <= bootStageUs((BootStage)(i + 1)));
+    }
+    TEST_ASSERT_TRUE(bootStageUs(BOOT_STAGE_INPUT_READY) <= BOOT_INPUT_READY_TARGET_US);
+}
+
+// Nothing is reported before the first paint
+void test_profile_waits_for_paint() {
+    mockResetSerial();
+    loop();
+    TEST_ASSERT_FALSE(contains(Serial.tx, "boot_profile"));
+}
+
+void test_first_paint_and_profile() {
+    mockSetMicros(PAINT_US);
+    mockResetSerial();
+    bringUpDisplays();
+    // Off the loop, logging goes through the deferred ring only
+    TEST_ASSERT_TRUE(Serial.tx.empty());
+    TEST_ASSERT_TRUE(bootStageReached(BOOT_STAGE_FIRST_PAINT));
+    TEST_ASSERT_EQUAL_UINT32(PAINT_US, bootStageUs(BOOT_STAGE_FIRST_PAINT));
+    TEST_ASSERT_TRUE(footswitchDisplayStats.framesDrawn > 0);
+    TEST_ASSERT_TRUE(configDisplayStats.framesDrawn > 0);
+
+    // A stage keeps its first time
+    mockSetMicros(PAINT_US + 1000);
+    markBootStage(BOOT_STAGE_FIRST_PAINT);
+    TEST_ASSERT_EQUAL_UINT32(PAINT_US, bootStageUs(BOOT_STAGE_FIRST_PAINT));
+
+    mockResetSerial();
+    loop();
+    TEST_ASSERT_TRUE(contains(Serial.tx, "\"type\":\"boot_profile\""));
+    TEST_ASSERT_TRUE(contains(Serial.tx, "\"complete\":true"));
+    TEST_ASSERT_TRUE(contains(Serial.tx, "\"target_met\":true"));
+
+    // Only once unless asked for
+    mockResetSerial();
+    loop();
+    TEST_ASSERT_FALSE(contains(Serial.tx, "boot_profile"));
+}
+
+int main() {
+    mockClearPreferences();
+    mockSetMicros(SETUP_US);
+    setup();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_input_ready_before_displays);
+    RUN_TEST(test_profile_waits_for_paint);
+    RUN_TEST(test_first_paint_and_profile);
+    return UNITY_END();
+}
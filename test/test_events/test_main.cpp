@@ -0,0 +1,153 @@
+// Host event stream, run with `pio test -e native`. Events are posted
+// directly or through the real producers, and the lines serviceEvents()
+// writes to Serial are checked. Serial.txFifoSize stands in for a host that
+// stops reading.
+
+#include <unity.h>
+#include "mock_hal.h"
+#include "config.h"
+#include "banks.h"
+#include "events.h"
+#include "midi.h"
+#include "log.h"
+
+#define ALL_EVENTS ((1u << HOST_EVENT_KIND_COUNT) - 1)
+
+static uint32_t firstSequence = 0;
+
+// Service until nothing more is written
+static std::string written() {
+    std::string lines;
+    for (;;) {
+        serviceEvents();
+        if (Serial.tx.empty()) break;
+        lines += Serial.tx;
+        Serial.tx.clear();
+    }
+    return lines;
+}
+
+static int countLines(const std::string &text, const char *needle) {
+    int count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) ++count;
+    return count;
+}
+
+static bool contains(const std::string &text, const char *needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+static std::string sequenceField(uint32_t sequence) {
+    return "\"seq\":" + std::to_string(sequence) + ",";
+}
+
+void setUp() {
+    mockResetSerial();
+    Serial.txFifoSize = 128;
+    firstSequence = subscribeEvents(ALL_EVENTS);
+}
+
+void tearDown() {
+    subscribeEvents(0);
+    Serial.txFifoSize = 128;
+}
+
+void test_events_need_subscription() {
+    subscribeEvents(0);
+    TEST_ASSERT_FALSE(postHostEvent(HOST_EVENT_SWITCH, 1, 0, 10));
+    TEST_ASSERT_EQUAL_STRING("", written().c_str());
+
+    subscribeEvents(1u << HOST_EVENT_SWITCH);
+    TEST_ASSERT_FALSE(postHostEvent(HOST_EVENT_GESTURE, GESTURE_LONG_PRESS, 0, 20));
+    TEST_ASSERT_TRUE(postHostEvent(HOST_EVENT_SWITCH, 1, 2, 30));
+    std::string lines = written();
+    TEST_ASSERT_EQUAL_INT(1, countLines(lines, "\"ev\":"));
+    TEST_ASSERT_TRUE(contains(lines, "\"ev\":\"switch\""));
+    TEST_ASSERT_TRUE(contains(lines, "\"t\":30,"));
+    TEST_ASSERT_TRUE(contains(lines, "\"id\":2,\"state\":\"down\""));
+}
+
+void test_events_are_numbered_in_order() {
+    postHostEvent(HOST_EVENT_SWITCH, 1, 0, 100);
+    postHostEvent(HOST_EVENT_GESTURE, GESTURE_LONG_PRESS, 0, 200);
+    postHostEvent(HOST_EVENT_SWITCH, 0, 0, 300);
+    std::string lines = written();
+
+    size_t first = lines.find(sequenceField(firstSequence) + "\"t\":100");
+    size_t second = lines.find(sequenceField(firstSequence + 1) + "\"t\":200");
+    size_t third = lines.find(sequenceField(firstSequence + 2) + "\"t\":300");
+    TEST_ASSERT_TRUE(first != std::string::npos && second != std::string::npos && third != std::string::npos);
+    TEST_ASSERT_TRUE(first < second && second < third);
+    TEST_ASSERT_TRUE(contains(lines, "\"gesture\":\"long_press\""));
+}
+
+// A host that stops reading costs dropped events, never a blocked loop; the
+// gap in the sequence is reported where it happened
+void test_slow_host_drops_and_counts() {
+    Serial.txFifoSize = 0;
+    uint32_t dropped = eventStats.dropped;
+    for (int i = 0; i < EVENT_RING_SIZE + 6; ++i) postHostEvent(HOST_EVENT_SWITCH, 1, 0, 1000 + i);
+    serviceEvents();
+    TEST_ASSERT_EQUAL_STRING("", Serial.tx.c_str());
+    TEST_ASSERT_EQUAL_UINT32(dropped + 6, eventStats.dropped);
+
+    // The host reads again: the ring is written, then the drop marker
+    Serial.txFifoSize = 128;
+    std::string lines = written();
+    TEST_ASSERT_EQUAL_INT(EVENT_RING_SIZE, countLines(lines, "\"ev\":\"switch\""));
+    std::string marker = "{\"ev\":\"dropped\"," + sequenceField(firstSequence + EVENT_RING_SIZE) + "\"count\":6}";
+    TEST_ASSERT_TRUE(contains(lines, marker.c_str()));
+
+    postHostEvent(HOST_EVENT_SWITCH, 0, 0, 5000);
+    lines = written();
+    TEST_ASSERT_TRUE(contains(lines, (sequenceField(firstSequence + EVENT_RING_SIZE + 6) + "\"t\":5000").c_str()));
+}
+
+// Drops between two delivered events are marked between them
+void test_drop_marker_in_stream_order() {
+    Serial.txFifoSize = 0;
+    for (int i = 0; i < EVENT_RING_SIZE + 2; ++i) postHostEvent(HOST_EVENT_SWITCH, 1, 1, 10 + i);
+    Serial.txFifoSize = 128;
+    serviceEvents();   // One pass: room in the ring again
+    postHostEvent(HOST_EVENT_SWITCH, 0, 1, 9000);
+
+    std::string lines = Serial.tx + written();
+    size_t lastOld = lines.find("\"t\":" + std::to_string(10 + EVENT_RING_SIZE - 1) + ",");
+    size_t marker = lines.find("\"ev\":\"dropped\"");
+    size_t next = lines.find(sequenceField(firstSequence + EVENT_RING_SIZE + 2) + "\"t\":9000");
+    TEST_ASSERT_TRUE(lastOld != std::string::npos && marker != std::string::npos && next != std::string::npos);
+    TEST_ASSERT_TRUE(lastOld < marker && marker < next);
+}
+
+void test_midi_and_config_producers() {
+    subscribeEvents((1u << HOST_EVENT_MIDI) | (1u << HOST_EVENT_CONFIG));
+
+    TEST_ASSERT_TRUE(queueSwitchMidi(MIDI_PRODUCER_HOST, 0));
+    serviceMidiOutput();
+    std::string lines = written();
+    TEST_ASSERT_TRUE(contains(lines, "\"ev\":\"midi\""));
+    TEST_ASSERT_TRUE(contains(lines, "\"source\":\"host\""));
+
+    getBankSwitches(1);
+    TEST_ASSERT_TRUE(selectBank(1, DISPLAY_PRODUCER_HOST));
+    lines = written();
+    TEST_ASSERT_TRUE(contains(lines, "\"change\":\"bank\",\"bank\":1}"));
+    selectBank(0, DISPLAY_PRODUCER_HOST);
+}
+
+int main() {
+    mockClearPreferences();
+    initializeLog();
+    initializeEvents();
+    initializeConfigLock();
+    loadConfigFromFlash();
+    initializeBanks();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_events_need_subscription);
+    RUN_TEST(test_events_are_numbered_in_order);
+    RUN_TEST(test_slow_host_drops_and_counts);
+    RUN_TEST(test_drop_marker_in_stream_order);
+    RUN_TEST(test_midi_and_config_producers);
+    return UNITY_END();
+}
@@ -0,0 +1,218 @@
+// Gesture engine timing, run with `pio test -e native`. The engine is fed
+// debounced edges and sample times directly; every event it reports is
+// recorded with its timestamp.
+
+#include <unity.h>
+#include "mock_hal.h"
+#include "config.h"
+#include "banks.h"
+#include "gestures.h"
+#include "log.h"
+
+#define MS 1000UL
+
+struct RecordedEvent {
+    int switchIndex;
+    GestureEvent event;
+    uint32_t timeUs;
+};
+
+static RecordedEvent events[32];
+static int eventCount = 0;
+
+static void record(int switchIndex, GestureEvent event, uint32_t timeUs) {
+    if (eventCount < 32) events[eventCount++] = {switchIndex, event, timeUs};
+}
+
+// Sample clock from..to in 1 ms steps, as the input task would
+static void runClock(uint32_t fromUs, uint32_t toUs) {
+    for (uint32_t t = fromUs; t <= toUs; t += MS) serviceGestures(t);
+}
+
+static void expectEvent(int index, int switchIndex, GestureEvent event, uint32_t timeUs) {
+    TEST_ASSERT_TRUE(index < eventCount);
+    TEST_ASSERT_EQUAL_INT(switchIndex, events[index].switchIndex);
+    TEST_ASSERT_EQUAL_INT(event, events[index].event);
+    TEST_ASSERT_EQUAL_UINT32(timeUs, events[index].timeUs);
+}
+
+static void bind(int switchIndex, GestureEvent event, uint8_t kind) {
+    footswitches[switchIndex].gestures.bindings[event - 1].kind = kind;
+    compileSwitchMidi(footswitches[switchIndex]);
+}
+
+void setUp() {
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        setDefaultGestures(footswitches[i].gestures);
+        compileSwitchMidi(footswitches[i]);
+    }
+    initializeGestures(record);
+    eventCount = 0;
+}
+
+void tearDown() {
+}
+
+// Without bindings the press is reported at its edge, with nothing held back
+void test_gesture_plain_press() {
+    gestureSwitchDown(1, 1000 * MS);
+    TEST_ASSERT_EQUAL_INT(1, eventCount);
+    expectEvent(0, 1, GESTURE_PRESS, 1000 * MS);
+
+    runClock(1000 * MS, 3000 * MS);
+    TEST_ASSERT_EQUAL_INT(1, eventCount);
+    gestureSwitchUp(1, 3000 * MS);
+    expectEvent(1, 1, GESTURE_RELEASE, 3000 * MS);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+}
+
+void test_gesture_long_press() {
+    bind(0, GESTURE_LONG_PRESS, GESTURE_ACTION_BANK_NEXT);
+    gestureSwitchDown(0, 0);
+    TEST_ASSERT_EQUAL_INT(1, eventCount);
+
+    runClock(0, 2000 * MS);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(1, 0, GESTURE_LONG_PRESS, GESTURE_LONG_PRESS_MS * MS);
+    gestureSwitchUp(0, 2000 * MS);
+    expectEvent(2, 0, GESTURE_RELEASE, 2000 * MS);
+}
+
+void test_gesture_hold_repeat() {
+    bind(2, GESTURE_HOLD_REPEAT, GESTURE_ACTION_BANK_PREV);
+    gestureSwitchDown(2, 10 * MS);
+    runClock(10 * MS, 10 * MS + GESTURE_REPEAT_DELAY_MS * MS + 3 * GESTURE_REPEAT_INTERVAL_MS * MS);
+    gestureSwitchUp(2, 2000 * MS);
+
+    TEST_ASSERT_EQUAL_INT(6, eventCount);
+    expectEvent(0, 2, GESTURE_PRESS, 10 * MS);
+    for (int i = 0; i < 4; ++i) {
+        expectEvent(1 + i, 2, GESTURE_HOLD_REPEAT,
+                    10 * MS + GESTURE_REPEAT_DELAY_MS * MS + i * GESTURE_REPEAT_INTERVAL_MS * MS);
+    }
+    expectEvent(5, 2, GESTURE_RELEASE, 2000 * MS);
+}
+
+// A single tap on a double-tap switch is reported with its own edge times
+// once the window has closed
+void test_gesture_single_tap_waits_for_window() {
+    bind(3, GESTURE_DOUBLE_TAP, GESTURE_ACTION_BANK_NEXT);
+    gestureSwitchDown(3, 100 * MS);
+    runClock(100 * MS, 180 * MS);
+    gestureSwitchUp(3, 180 * MS);
+    runClock(180 * MS, 180 * MS + GESTURE_DOUBLE_TAP_MS * MS);
+    TEST_ASSERT_EQUAL_INT(0, eventCount);
+
+    serviceGestures(181 * MS + GESTURE_DOUBLE_TAP_MS * MS);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(0, 3, GESTURE_PRESS, 100 * MS);
+    expectEvent(1, 3, GESTURE_RELEASE, 180 * MS);
+}
+
+void test_gesture_double_tap() {
+    bind(3, GESTURE_DOUBLE_TAP, GESTURE_ACTION_BANK_NEXT);
+    gestureSwitchDown(3, 100 * MS);
+    runClock(100 * MS, 180 * MS);
+    gestureSwitchUp(3, 180 * MS);
+    runClock(180 * MS, 300 * MS);
+    gestureSwitchDown(3, 300 * MS);
+    runClock(300 * MS, 400 * MS);
+    gestureSwitchUp(3, 400 * MS);
+    runClock(400 * MS, 1000 * MS);
+
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(0, 3, GESTURE_DOUBLE_TAP, 300 * MS);
+    expectEvent(1, 3, GESTURE_RELEASE, 400 * MS);
+}
+
+// Holding a double-tap switch past the window makes it an ordinary press
+void test_gesture_hold_ends_tap_window() {
+    bind(4, GESTURE_DOUBLE_TAP, GESTURE_ACTION_BANK_NEXT);
+    gestureSwitchDown(4, 0);
+    runClock(0, GESTURE_DOUBLE_TAP_MS * MS);
+    TEST_ASSERT_EQUAL_INT(0, eventCount);
+    runClock(GESTURE_DOUBLE_TAP_MS * MS + MS, 1000 * MS);
+    TEST_ASSERT_EQUAL_INT(1, eventCount);
+    expectEvent(0, 4, GESTURE_PRESS, 0);
+
+    gestureSwitchUp(4, 1000 * MS);
+    runClock(1000 * MS, 2000 * MS);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(1, 4, GESTURE_RELEASE, 1000 * MS);
+}
+
+// Other switches keep their immediate press while one waits for a second
+// tap. The waiting tap is settled first, so presses go out in the order
+// they were made.
+void test_gesture_other_switch_not_delayed() {
+    bind(3, GESTURE_DOUBLE_TAP, GESTURE_ACTION_BANK_NEXT);
+    gestureSwitchDown(3, 0);
+    gestureSwitchUp(3, 60 * MS);
+    gestureSwitchDown(1, 120 * MS);
+    TEST_ASSERT_EQUAL_INT(3, eventCount);
+    expectEvent(0, 3, GESTURE_PRESS, 0);
+    expectEvent(1, 3, GESTURE_RELEASE, 60 * MS);
+    expectEvent(2, 1, GESTURE_PRESS, 120 * MS);
+
+    // The window that was cut short reports nothing more
+    runClock(121 * MS, 500 * MS);
+    TEST_ASSERT_EQUAL_INT(3, eventCount);
+}
+
+// Same for a switch still held inside its window
+void test_gesture_other_switch_releases_held_press() {
+    bind(3, GESTURE_DOUBLE_TAP, GESTURE_ACTION_BANK_NEXT);
+    gestureSwitchDown(3, 0);
+    gestureSwitchDown(1, 40 * MS);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(0, 3, GESTURE_PRESS, 0);
+    expectEvent(1, 1, GESTURE_PRESS, 40 * MS);
+
+    gestureSwitchUp(3, 80 * MS);
+    runClock(81 * MS, 500 * MS);
+    TEST_ASSERT_EQUAL_INT(3, eventCount);
+    expectEvent(2, 3, GESTURE_RELEASE, 80 * MS);
+}
+
+// Thresholds and bindings come from the switch configuration JSON
+void test_gesture_config_json() {
+    JsonDocument patch;
+    deserializeJson(patch, "{\"gestures\":{\"long_press_ms\":800,\"double_tap_ms\":5,"
+                           "\"long_press\":{\"type\":\"cc\",\"cc\":80,\"value\":0},"
+                           "\"double_tap\":{\"type\":\"bank_prev\"}}}");
+    FootswitchConfig &fs = footswitches[5];
+    TEST_ASSERT_TRUE(patchSwitchConfig(fs, patch.as<JsonObjectConst>()));
+    TEST_ASSERT_EQUAL_UINT32(800, fs.gestures.longPressMs);
+    TEST_ASSERT_EQUAL_UINT32(GESTURE_MIN_MS, fs.gestures.doubleTapMs);
+    TEST_ASSERT_EQUAL_UINT32(gestureBit(GESTURE_LONG_PRESS) | gestureBit(GESTURE_DOUBLE_TAP), fs.gestureMask);
+    TEST_ASSERT_EQUAL_INT(GESTURE_ACTION_MIDI, fs.gestures.bindings[GESTURE_LONG_PRESS - 1].kind);
+    TEST_ASSERT_EQUAL_INT(80, fs.gestures.bindings[GESTURE_LONG_PRESS - 1].midi.data1);
+
+    deserializeJson(patch, "{\"gestures\":{\"double_tap\":{\"type\":\"none\"}}}");
+    TEST_ASSERT_TRUE(patchSwitchConfig(fs, patch.as<JsonObjectConst>()));
+    TEST_ASSERT_EQUAL_UINT32(gestureBit(GESTURE_LONG_PRESS), fs.gestureMask);
+
+    deserializeJson(patch, "{\"gestures\":{\"release\":{\"type\":\"tap_tempo\"}}}");
+    TEST_ASSERT_FALSE(patchSwitchConfig(fs, patch.as<JsonObjectConst>()));
+    TEST_ASSERT_EQUAL_UINT32(gestureBit(GESTURE_LONG_PRESS), fs.gestureMask);
+}
+
+int main() {
+    mockClearPreferences();
+    initializeLog();
+    initializeConfigLock();
+    loadConfigFromFlash();
+    initializeBanks();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_gesture_plain_press);
+    RUN_TEST(test_gesture_long_press);
+    RUN_TEST(test_gesture_hold_repeat);
+    RUN_TEST(test_gesture_single_tap_waits_for_window);
+    RUN_TEST(test_gesture_double_tap);
+    RUN_TEST(test_gesture_hold_ends_tap_window);
+    RUN_TEST(test_gesture_other_switch_not_delayed);
+    RUN_TEST(test_gesture_other_switch_releases_held_press);
+    RUN_TEST(test_gesture_config_json);
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+// Steady-state heap use of the configuration paths, run with
+// `pio test -e native`. Every operator new in the process is counted
+// (the host String is a std::string, so any String left on a path shows up).
+// Each operation runs twice (most alternate between two states) to let
+// caches and the mocks' buffers reach their working size, then must run
+// again without a single allocation.
+
+#include <unity.h>
+#include <new>
+#include "mock_hal.h"
+#include "config.h"
+#include "uart.h"
+#include "display.h"
+#include "banks.h"
+#include "switches.h"
+#include "log.h"
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    ++allocations;
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+static void expectNoAllocations(void (*operation)()) {
+    operation();
+    operation();
+    size_t before = allocations;
+    for (int i = 0; i < 20; ++i) {
+        operation();
+        mockResetSerial();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, allocations - before);
+}
+
+static void runCommand(const char *command) {
+    processUartCommand(command, strlen(command));
+}
+
+static void pressSwitch() {
+    queueSwitchMidi(MIDI_PRODUCER_HOST, 2);
+    serviceMidiOutput();
+}
+
+static void redraw() {
+    footswitches[2].enabled = !footswitches[2].enabled;
+    currentSelectedFootswitch = (currentSelectedFootswitch == 1) ? 3 : 1;
+    updateFootswitchDisplay();
+    updateConfigDisplay();
+}
+
+static void patchSwitch() {
+    static int round = 0;
+    runCommand((++round % 2) ? "{\"type\":\"patch_switch\",\"switch_id\":2,\"name\":\"CHORUS\"}"
+                             : "{\"type\":\"patch_switch\",\"switch_id\":2,\"name\":\"FLANGER\"}");
+    commitPendingConfig();
+}
+
+// A full set_config (every switch, as the command requires), alternating
+// the first switch's name. Switch 1's name is longer than the limit.
+static char setConfigCommands[2][1536];
+
+static void buildSetConfigCommands() {
+    for (int round = 0; round < 2; ++round) {
+        char *out = setConfigCommands[round];
+        size_t size = sizeof(setConfigCommands[round]);
+        int used = snprintf(out, size, "{\"type\":\"set_config\",\"switches\":[");
+        for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+            const char *name = i == 0 ? (round ? "BOOST" : "DRIVE")
+                             : i == 1 ? "A NAME LONGER THAN THE LIMIT OF THIRTY-ONE" : "FX";
+            used += snprintf(out + used, size - used,
+                             "%s{\"id\":%d,\"name\":\"%s\",\"channel\":1,\"cc\":%d,\"value\":127,"
+                             "\"enabled\":true,\"color\":\"#00FF00\"}",
+                             i == 0 ? "" : ",", i, name, 20 + i);
+        }
+        snprintf(out + used, size - used, "]}");
+    }
+}
+
+static void setConfig() {
+    static int round = 0;
+    round ^= 1;
+    runCommand(setConfigCommands[round]);
+}
+
+static void getConfig() {
+    runCommand("{\"type\":\"get_config\"}");
+}
+
+static void loadConfig() {
+    loadConfigFromFlash();
+}
+
+static void switchBanks() {
+    selectBank(1, DISPLAY_PRODUCER_HOST);
+    selectBank(0, DISPLAY_PRODUCER_HOST);
+}
+
+void setUp() {
+    serviceLog();
+    mockResetSerial();
+}
+
+void tearDown() {
+}
+
+void test_heap_press() {
+    expectNoAllocations(pressSwitch);
+}
+
+void test_heap_redraw() {
+    expectNoAllocations(redraw);
+}
+
+void test_heap_patch_switch() {
+    expectNoAllocations(patchSwitch);
+}
+
+void test_heap_set_config() {
+    // The command must succeed, or only its error path would be measured
+    mockResetSerial();
+    setConfig();
+    TEST_ASSERT_TRUE(strstr(Serial.tx.c_str(), "Configuration updated") != NULL);
+    TEST_ASSERT_EQUAL_STRING("BOOST", getBankSwitches(getActiveBank())[0].name);
+    TEST_ASSERT_EQUAL_UINT32(FOOTSWITCH_NAME_MAX, strlen(getBankSwitches(getActiveBank())[1].name));
+
+    expectNoAllocations(setConfig);
+}
+
+void test_heap_get_config() {
+    expectNoAllocations(getConfig);
+}
+
+void test_heap_load_config() {
+    expectNoAllocations(loadConfig);
+}
+
+void test_heap_bank_switch() {
+    expectNoAllocations(switchBanks);
+}
+
+int main() {
+    // The boot sequence of setup(), without the tasks
+    mockClearPreferences();
+    initializeLog();
+    initializeConfigLock();
+    initializeFootswitchPins();
+    loadConfigFromFlash();
+    initializeBanks();
+    initializeDisplays();
+    buildSetConfigCommands();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_heap_press);
+    RUN_TEST(test_heap_redraw);
+    RUN_TEST(test_heap_patch_switch);
+    RUN_TEST(test_heap_set_config);
+    RUN_TEST(test_heap_get_config);
+    RUN_TEST(test_heap_load_config);
+    RUN_TEST(test_heap_bank_switch);
+    return UNITY_END();
+}
@@ -0,0 +1,87 @@
+// Footswitch layout checks for the board variants we build, run with
+// `pio test -e native`. The grids are compile-time constants, so the
+// static_asserts below fail the build and the tests check the tile tables.
+
+#include <unity.h>
+#include "layout.h"
+
+typedef TileGrid<4, 480, 320> Layout4;
+typedef TileGrid<6, 480, 320> Layout6;
+typedef TileGrid<8, 480, 320> Layout8;
+typedef TileGrid<12, 480, 320> Layout12;
+typedef TileGrid<6, 320, 480> Layout6Portrait;
+
+void setUp() {}
+void tearDown() {}
+
+// Six switches on the landscape panel reproduce the original hand-made screen
+static_assert(Layout6::columns == 2 && Layout6::rows == 3, "six switches: 2x3 grid");
+static_assert(Layout6::tileWidth == 220 && Layout6::tileHeight == 90, "six switches: 220x90 tiles");
+static_assert(Layout6::nameSize == 3 && Layout6::labelSize == 2, "six switches: text sizes 3 and 2");
+static_assert(Layout6::nameY == 30 && Layout6::labelY == 65, "six switches: text at 30 and 65");
+static_assert(Layout6::origin(5).x == 250 && Layout6::origin(5).y == 220, "six switches: last tile origin");
+
+static_assert(Layout4::columns == 2 && Layout4::rows == 2, "four switches: 2x2 grid");
+static_assert(Layout8::columns == 2 && Layout8::rows == 4, "eight switches: 2x4 grid");
+static_assert(Layout12::columns == 3 && Layout12::rows == 4, "twelve switches: 3x4 grid");
+
+// Every tile lies inside the panel, tiles never overlap, slots run row-major
+// and the text fits its tile
+template <typename Grid>
+static void checkGrid(int panelWidth, int panelHeight) {
+    for (int i = 0; i < Grid::count; ++i) {
+        const TileOrigin &a = Grid::origin(i);
+        TEST_ASSERT_TRUE(a.x >= 0 && a.y >= 0);
+        TEST_ASSERT_TRUE(a.x + Grid::tileWidth <= panelWidth);
+        TEST_ASSERT_TRUE(a.y + Grid::tileHeight <= panelHeight);
+
+        if (i > 0) {
+            const TileOrigin &previous = Grid::origin(i - 1);
+            TEST_ASSERT_TRUE(a.y > previous.y || (a.y == previous.y && a.x > previous.x));
+        }
+
+        for (int j = i + 1; j < Grid::count; ++j) {
+            const TileOrigin &b = Grid::origin(j);
+            bool apart = a.x + Grid::tileWidth <= b.x || b.x + Grid::tileWidth <= a.x ||
+                         a.y + Grid::tileHeight <= b.y || b.y + Grid::tileHeight <= a.y;
+            TEST_ASSERT_TRUE(apart);
+        }
+    }
+
+    // "CC127 Ch16" at the label size
+    TEST_ASSERT_TRUE(10 * layout::GLYPH_WIDTH * Grid::labelSize <= Grid::tileWidth);
+    TEST_ASSERT_TRUE(LAYOUT_NAME_FIT_CHARS * layout::GLYPH_WIDTH * Grid::nameSize <= Grid::tileWidth);
+}
+
+void test_layout_4() {
+    checkGrid<Layout4>(480, 320);
+}
+
+void test_layout_6() {
+    checkGrid<Layout6>(480, 320);
+    checkGrid<Layout6Portrait>(320, 480);
+}
+
+void test_layout_8() {
+    checkGrid<Layout8>(480, 320);
+}
+
+void test_layout_12() {
+    checkGrid<Layout12>(480, 320);
+}
+
+// The build's own layout follows its switch count and rotation
+void test_layout_build() {
+    TEST_ASSERT_EQUAL_INT(NUM_FOOTSWITCHES, FootswitchLayout::count);
+    checkGrid<FootswitchLayout>(layout::panelWidth(FOOTSWITCH_ROTATION), layout::panelHeight(FOOTSWITCH_ROTATION));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_layout_4);
+    RUN_TEST(test_layout_6);
+    RUN_TEST(test_layout_8);
+    RUN_TEST(test_layout_12);
+    RUN_TEST(test_layout_build);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// LED feedback against footswitch input, run with `pio test -e native`.
+// Patterns play while ladder samples arrive at 2 kHz and the input pass
+// runs every millisecond, as on the device. Blinking must never block: no
+// delay() anywhere, every pass drains the sample queue, and a press made
+// mid-blink is accepted on time.
+
+#include <unity.h>
+#include "mock_hal.h"
+#include "config.h"
+#include "banks.h"
+#include "ladder.h"
+#include "switches.h"
+#include "utils.h"
+#include "log.h"
+
+#define IDLE_LEVEL 3900
+#define SAMPLE_US (1000000UL / LADDER_SAMPLE_RATE_HZ)
+#define ACCEPT_MARGIN_US 2000UL     // Sample and pass granularity on top of the debounce
+
+static uint64_t nowUs = 1000000;
+static uint32_t ledToggles = 0;
+static int lastLedLevel = LOW;
+static int64_t acceptedAtUs = -1;   // First pass that saw the expected switch selected
+
+static uint16_t switchLevel(int switchId) {
+    return 300 + switchId * (3300 / NUM_FOOTSWITCHES);
+}
+
+// One millisecond of the device: the sampler's ticks, a loop pass (LED) and
+// an input pass
+static void runMs(int ms, uint16_t level, int expectSelected = -2) {
+    for (int i = 0; i < ms; ++i) {
+        for (uint32_t t = SAMPLE_US; t <= 1000; t += SAMPLE_US) {
+            LadderSample sample = {level, (uint32_t)(nowUs + t)};
+            queueLadderSample(sample);
+        }
+        nowUs += 1000;
+        mockSetMicros(nowUs);
+
+        updateLed();
+        runInputPass();
+
+        // The pass drained everything the sampler queued
+        LadderSample leftover;
+        TEST_ASSERT_FALSE(readLadderSample(leftover));
+
+        int led = digitalRead(LED_PIN);
+        if (led != lastLedLevel) ++ledToggles;
+        lastLedLevel = led;
+        if (acceptedAtUs < 0 && expectSelected >= 0 && currentSelectedFootswitch == expectSelected) {
+            acceptedAtUs = nowUs;
+        }
+    }
+}
+
+static void expectAcceptedInTime(uint64_t edgeUs) {
+    TEST_ASSERT_TRUE(acceptedAtUs >= 0);
+    TEST_ASSERT_TRUE((uint64_t)acceptedAtUs <= edgeUs + DEBOUNCE_DELAY * 1000UL + ACCEPT_MARGIN_US);
+}
+
+void setUp() {
+    runMs(200, IDLE_LEVEL);   // Any earlier pattern finished, switches released
+    currentSelectedFootswitch = -1;
+    acceptedAtUs = -1;
+    ledToggles = 0;
+    lastLedLevel = digitalRead(LED_PIN);
+    mockResetSerial();
+}
+
+void tearDown() {}
+
+// The 400 ms test-switch flash stays lit while a switch is pressed and accepted
+void test_press_during_test_switch_blink() {
+    uint64_t delayedBefore = mockDelayedMicros();
+    uint32_t overrunsBefore = getLadderOverruns();
+
+    blinkLed(BLINK_TEST_SWITCH);
+    TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(LED_PIN));
+    runMs(50, IDLE_LEVEL);
+
+    uint64_t edgeUs = nowUs;
+    runMs(120, switchLevel(2), 2);
+    TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(LED_PIN));
+    expectAcceptedInTime(edgeUs);
+    TEST_ASSERT_FALSE(Serial2.tx.empty());
+
+    runMs(100, IDLE_LEVEL);
+    TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(LED_PIN));
+    runMs(200, IDLE_LEVEL);
+    TEST_ASSERT_EQUAL_INT(LOW, digitalRead(LED_PIN));
+
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(mockDelayedMicros() - delayedBefore));
+    TEST_ASSERT_EQUAL_UINT32(overrunsBefore, getLadderOverruns());
+}
+
+// An error preempts the flash and plays three short flashes while a press
+// on another switch goes through
+void test_press_during_error_blink() {
+    uint64_t delayedBefore = mockDelayedMicros();
+    uint32_t overrunsBefore = getLadderOverruns();
+
+    blinkLed(BLINK_TEST_SWITCH);
+    runMs(30, IDLE_LEVEL);
+    blinkLed(BLINK_ERROR);
+    ledToggles = 0;
+    lastLedLevel = digitalRead(LED_PIN);
+    TEST_ASSERT_EQUAL_INT(HIGH, lastLedLevel);
+
+    runMs(40, IDLE_LEVEL);
+    uint64_t edgeUs = nowUs;
+    runMs(100, switchLevel(4), 4);
+    expectAcceptedInTime(edgeUs);
+
+    runMs(300, IDLE_LEVEL);
+    TEST_ASSERT_EQUAL_INT(LOW, digitalRead(LED_PIN));
+    TEST_ASSERT_EQUAL_UINT32(5, ledToggles);   // On-off three times, from on
+
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(mockDelayedMicros() - delayedBefore));
+    TEST_ASSERT_EQUAL_UINT32(overrunsBefore, getLadderOverruns());
+}
+
+// Queued patterns play one after another without holding up input
+void test_queued_patterns_do_not_block() {
+    uint64_t delayedBefore = mockDelayedMicros();
+    blinkLed(BLINK_SET_CONFIG);
+    blinkLed(BLINK_PING);
+    blinkLed(BLINK_GET_CONFIG);
+
+    uint64_t edgeUs = nowUs;
+    runMs(100, switchLevel(1), 1);
+    expectAcceptedInTime(edgeUs);
+    runMs(1000, IDLE_LEVEL);
+    TEST_ASSERT_EQUAL_INT(LOW, digitalRead(LED_PIN));
+    TEST_ASSERT_EQUAL_UINT32(8, ledToggles);   // 2 + 1 + 1 flashes
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(mockDelayedMicros() - delayedBefore));
+}
+
+int main() {
+    mockClearPreferences();
+    mockSetMicros(nowUs);
+    initializeLog();
+    initializeConfigLock();
+    initializeFootswitchPins();
+    loadConfigFromFlash();
+    initializeBanks();
+    pinMode(LED_PIN, OUTPUT);
+    digitalWrite(LED_PIN, LOW);
+
+    LadderCalibration cal;
+    cal.version = LADDER_CALIBRATION_VERSION;
+    cal.idleLevel = IDLE_LEVEL;
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) cal.levels[i] = switchLevel(i);
+    char error[48];
+    if (!useLadderCalibration(cal, error, sizeof(error))) {
+        printf("calibration: %s\n", error);
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_press_during_test_switch_blink);
+    RUN_TEST(test_press_during_error_blink);
+    RUN_TEST(test_queued_patterns_do_not_block);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// MIDI IN parser and THRU, run with `pio test -e native`. Bytes are fed to
+// Serial2 as the cable would deliver them; serviceMidiInput() parses them
+// and serviceMidiOutput() writes the forwarded stream back to Serial2.tx.
+
+#include <unity.h>
+#include "mock_hal.h"
+#include "midi.h"
+#include "midi_input.h"
+
+static int64_t nowUs = 0;
+
+// Bytes as lower-case hex, space separated, for readable comparisons
+static std::string hex(const std::string &bytes) {
+    std::string text;
+    char byte[4];
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        snprintf(byte, sizeof(byte), i == 0 ? "%02x" : " %02x", (uint8_t)bytes[i]);
+        text += byte;
+    }
+    return text;
+}
+
+static void feed(const uint8_t *bytes, size_t length) {
+    Serial2.feed(bytes, length);
+}
+
+// Parse everything received, then send until the output queues are empty
+static std::string forwarded() {
+    serviceMidiInput();
+    for (;;) {
+        size_t before = Serial2.tx.size();
+        serviceMidiOutput();
+        if (Serial2.tx.size() == before) break;
+    }
+    std::string out = Serial2.tx;
+    Serial2.tx.clear();
+    return out;
+}
+
+void setUp() {
+    // Long enough apart that the output resends its running status
+    nowUs += 2000000;
+    mockSetMicros(nowUs);
+    mockResetSerial();
+    midiThruEnabled = true;
+    requestMidiStatsReset();
+    serviceMidiInput();
+}
+
+void tearDown() {
+    midiThruEnabled = true;
+}
+
+// Data bytes without a status reuse the last channel status
+void test_running_status() {
+    const uint8_t in[] = {
+        0x90, 0x3C, 0x64, 0x3E, 0x64, 0x40, 0x00,   // Note On, On, On velocity 0 (Off)
+        0xB0, 0x07, 0x7F, 0x0A, 0x40,               // Two CCs
+        0xC0, 0x05, 0x06                            // Two Program Changes, one data byte each
+    };
+    feed(in, sizeof(in));
+    std::string out = forwarded();
+
+    TEST_ASSERT_EQUAL_UINT32(sizeof(in), midiInputStats.bytesReceived);
+    TEST_ASSERT_EQUAL_UINT32(2, midiInputStats.messages[MIDI_IN_NOTE_ON]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_NOTE_OFF]);
+    TEST_ASSERT_EQUAL_UINT32(2, midiInputStats.messages[MIDI_IN_CONTROL_CHANGE]);
+    TEST_ASSERT_EQUAL_UINT32(2, midiInputStats.messages[MIDI_IN_PROGRAM_CHANGE]);
+    TEST_ASSERT_EQUAL_UINT32(0, midiInputStats.droppedBytes);
+
+    // Seven messages forwarded; the output applies running status again
+    TEST_ASSERT_EQUAL_UINT32(7, midiInputStats.thruMessages);
+    TEST_ASSERT_EQUAL_STRING(hex(std::string((const char *)in, sizeof(in))).c_str(), hex(out).c_str());
+}
+
+// System common ends running status; data after it has no status to use
+void test_system_common_cancels_running_status() {
+    const uint8_t in[] = {0xB0, 0x07, 0x7F, 0xF3, 0x02, 0x0A, 0x40};
+    feed(in, sizeof(in));
+    std::string out = forwarded();
+
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_CONTROL_CHANGE]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_SYSTEM_COMMON]);
+    TEST_ASSERT_EQUAL_UINT32(2, midiInputStats.droppedBytes);
+    TEST_ASSERT_EQUAL_STRING("b0 07 7f f3 02", hex(out).c_str());
+}
+
+// Real-time bytes inside a message are handled on their own and sent ahead
+// of it; the message around them stays whole
+void test_realtime_between_data_bytes() {
+    const uint8_t in[] = {
+        0x90, 0x3C, 0xF8, 0x64,                     // Clock between Note On data bytes
+        0xB0, 0xF8, 0x07, 0xFE, 0x7F,               // Clock and Active Sensing inside a CC
+        0xF0, 0x7D, 0x01, 0xFA, 0x02, 0xF7          // Start inside a SysEx
+    };
+    feed(in, sizeof(in));
+    std::string out = forwarded();
+
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_NOTE_ON]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_CONTROL_CHANGE]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_SYSEX]);
+    TEST_ASSERT_EQUAL_UINT32(2, midiInputStats.messages[MIDI_IN_CLOCK]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_ACTIVE_SENSING]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_START]);
+    TEST_ASSERT_EQUAL_UINT32(0, midiInputStats.droppedBytes);
+    TEST_ASSERT_EQUAL_UINT32(3, midiInputStats.thruMessages);
+    TEST_ASSERT_EQUAL_STRING("f8 f8 fe fa 90 3c 64 b0 07 7f f0 7d 01 02 f7", hex(out).c_str());
+}
+
+// THRU forwards each complete message as one block, so a block from another
+// producer never lands inside it
+void test_thru_forwards_whole_blocks() {
+    const uint8_t in[] = {0x90, 0x3C, 0x64, 0xB0, 0x07, 0x7F};
+    const uint8_t host[] = {0xC1, 0x09};
+    feed(in, 2);
+    serviceMidiInput();
+    TEST_ASSERT_TRUE(queueMidiBlock(MIDI_PRODUCER_HOST, host, sizeof(host)));
+    feed(in + 2, sizeof(in) - 2);
+    std::string text = hex(forwarded());
+
+    size_t note = text.find("90 3c 64");
+    size_t cc = text.find("b0 07 7f");
+    size_t program = text.find("c1 09");
+    TEST_ASSERT_TRUE(note != std::string::npos && cc != std::string::npos && program != std::string::npos);
+    TEST_ASSERT_TRUE(note < cc);
+    TEST_ASSERT_EQUAL_UINT32(2, midiInputStats.thruMessages);
+    TEST_ASSERT_EQUAL_size_t(strlen("90 3c 64 b0 07 7f c1 09"), text.size());
+}
+
+// A message cut short by a new status, and a SysEx too long to forward
+// whole, are dropped rather than forwarded in part
+void test_thru_drops_incomplete_messages() {
+    const uint8_t cut[] = {0x90, 0x3C, 0xB0, 0x07, 0x7F};
+    feed(cut, sizeof(cut));
+    uint8_t sysex[MIDI_THRU_SYSEX_MAX + 2];
+    memset(sysex, 0x11, sizeof(sysex));
+    sysex[0] = 0xF0;
+    sysex[sizeof(sysex) - 1] = 0xF7;
+    feed(sysex, sizeof(sysex));
+    TEST_ASSERT_EQUAL_STRING("b0 07 7f", hex(forwarded()).c_str());
+    TEST_ASSERT_EQUAL_UINT32(2 + sizeof(sysex), midiInputStats.droppedBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, midiInputStats.messages[MIDI_IN_SYSEX]);
+}
+
+// With THRU off messages are still parsed and counted, but nothing is sent
+void test_thru_disabled() {
+    midiThruEnabled = false;
+    const uint8_t in[] = {0x90, 0x3C, 0x64, 0xF8, 0xB0, 0x07, 0x7F};
+    feed(in, sizeof(in));
+    TEST_ASSERT_EQUAL_STRING("", hex(forwarded()).c_str());
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_NOTE_ON]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_CLOCK]);
+    TEST_ASSERT_EQUAL_UINT32(1, midiInputStats.messages[MIDI_IN_CONTROL_CHANGE]);
+    TEST_ASSERT_EQUAL_UINT32(0, midiInputStats.thruMessages);
+}
+
+int main() {
+    initializeMIDI();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_running_status);
+    RUN_TEST(test_system_common_cancels_running_status);
+    RUN_TEST(test_realtime_between_data_bytes);
+    RUN_TEST(test_thru_forwards_whole_blocks);
+    RUN_TEST(test_thru_drops_incomplete_messages);
+    RUN_TEST(test_thru_disabled);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+// Expression pedal pipeline, run with `pio test -e native`. The ADC is the
+// mock's analogRead; samplePedals() and servicePedals() are called directly
+// with explicit times, and the bytes that reach Serial2 are checked.
+
+#include <unity.h>
+#include "mock_hal.h"
+#include "config.h"
+#include "banks.h"
+#include "pedals.h"
+#include "midi.h"
+#include "log.h"
+
+#define MS 1000UL
+
+static uint32_t now = 0;
+
+static void configurePedal(const char *json) {
+    JsonDocument doc;
+    deserializeJson(doc, json);
+    char error[48];
+    TEST_ASSERT_TRUE(applyPedalsConfig(doc.as<JsonArrayConst>(), error, sizeof(error)));
+}
+
+// Hold the pedal input at level long enough for the smoothing to settle
+static void setLevel(uint16_t level) {
+    mockSetAnalogValue(EXPRESSION_PEDAL1_PIN, level);
+    for (int i = 0; i < 100; ++i) samplePedals();
+}
+
+static std::string sent() {
+    serviceMidiOutput();
+    std::string bytes = Serial2.tx;
+    mockResetSerial();
+    return bytes;
+}
+
+void setUp() {
+    now += 1000 * MS;
+    sent();
+}
+
+void tearDown() {
+    configurePedal("[{\"id\":0,\"enabled\":false}]");
+    sent();
+}
+
+void test_pedal_deadband() {
+    configurePedal("[{\"id\":0,\"enabled\":true,\"channel\":2,\"cc\":11,\"min\":0,\"max\":4095,"
+                   "\"deadband\":16,\"max_rate_hz\":1000,\"high_res\":false,\"invert\":false}]");
+    setLevel(2048);
+    servicePedals(now);
+    uint32_t messages = pedalStats[0].messages;
+    TEST_ASSERT_EQUAL_UINT32(64, pedalStats[0].value);
+    TEST_ASSERT_TRUE(sent().find("\xB1\x0B\x40") != std::string::npos);
+
+    // Noise inside the deadband sends nothing
+    setLevel(2060);
+    servicePedals(now += 10 * MS);
+    TEST_ASSERT_EQUAL_UINT32(messages, pedalStats[0].messages);
+
+    setLevel(2200);
+    servicePedals(now += 10 * MS);
+    TEST_ASSERT_EQUAL_UINT32(messages + 1, pedalStats[0].messages);
+    TEST_ASSERT_EQUAL_UINT32(68, pedalStats[0].value);
+}
+
+// A sweep faster than the rate limit sends at most one value per interval,
+// and the last position once the interval has passed
+void test_pedal_rate_limit() {
+    configurePedal("[{\"id\":0,\"enabled\":true,\"channel\":2,\"cc\":11,\"min\":0,\"max\":4095,"
+                   "\"deadband\":0,\"max_rate_hz\":50}]");
+    setLevel(0);
+    servicePedals(now);
+    uint32_t messages = pedalStats[0].messages;
+
+    for (int step = 1; step <= 10; ++step) {
+        setLevel(step * 300);
+        servicePedals(now += 1 * MS);
+    }
+    TEST_ASSERT_EQUAL_UINT32(messages, pedalStats[0].messages);
+
+    servicePedals(now += 20 * MS);
+    TEST_ASSERT_EQUAL_UINT32(messages + 1, pedalStats[0].messages);
+    TEST_ASSERT_EQUAL_UINT32(93, pedalStats[0].value);   // 3000 of 4095
+}
+
+// Values not yet on the wire are replaced, never queued behind each other
+void test_pedal_latest_value_wins() {
+    configurePedal("[{\"id\":0,\"enabled\":true,\"channel\":2,\"cc\":11,\"min\":0,\"max\":4095,"
+                   "\"deadband\":0,\"max_rate_hz\":1000}]");
+    uint32_t coalesced = midiTxStats.continuousCoalesced;
+    setLevel(1000);
+    servicePedals(now += 5 * MS);
+    setLevel(4095);
+    servicePedals(now += 5 * MS);
+    TEST_ASSERT_EQUAL_UINT32(coalesced + 1, midiTxStats.continuousCoalesced);
+
+    std::string bytes = sent();
+    TEST_ASSERT_TRUE(bytes.find("\x0B\x7F") != std::string::npos);
+    TEST_ASSERT_TRUE(bytes.size() <= 3);
+}
+
+void test_pedal_high_resolution() {
+    configurePedal("[{\"id\":0,\"enabled\":true,\"channel\":3,\"cc\":1,\"min\":0,\"max\":4095,"
+                   "\"deadband\":0,\"max_rate_hz\":1000,\"high_res\":true}]");
+    setLevel(4095);
+    servicePedals(now += 5 * MS);
+    TEST_ASSERT_EQUAL_UINT32(16383, pedalStats[0].value);
+    TEST_ASSERT_TRUE(sent().find("\x01\x7F\x21\x7F") != std::string::npos);
+
+    char error[48];
+    JsonDocument doc;
+    deserializeJson(doc, "[{\"id\":0,\"cc\":64}]");
+    TEST_ASSERT_FALSE(applyPedalsConfig(doc.as<JsonArrayConst>(), error, sizeof(error)));
+}
+
+// A switch message queued after a pedal value still goes out first
+void test_pedal_yields_to_switches() {
+    configurePedal("[{\"id\":0,\"enabled\":true,\"channel\":2,\"cc\":11,\"min\":0,\"max\":4095,"
+                   "\"deadband\":0,\"max_rate_hz\":1000,\"high_res\":false}]");
+    setLevel(100);
+    servicePedals(now += 5 * MS);
+    queueSwitchMidi(MIDI_PRODUCER_HOST, 0);
+
+    std::string bytes = sent();
+    size_t switchAt = bytes.find("\x14\x7F");   // Switch 1: CC 20 = 127
+    size_t pedalAt = bytes.find("\xB1\x0B");
+    TEST_ASSERT_TRUE(switchAt != std::string::npos && pedalAt != std::string::npos);
+    TEST_ASSERT_TRUE(switchAt < pedalAt);
+}
+
+int main() {
+    mockClearPreferences();
+    initializeLog();
+    initializeConfigLock();
+    loadConfigFromFlash();
+    initializeBanks();
+    initializePedals();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_pedal_deadband);
+    RUN_TEST(test_pedal_rate_limit);
+    RUN_TEST(test_pedal_latest_value_wins);
+    RUN_TEST(test_pedal_high_resolution);
+    RUN_TEST(test_pedal_yields_to_switches);
+    return UNITY_END();
+}
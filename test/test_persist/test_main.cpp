@@ -0,0 +1,158 @@
+// Deferred flash commits and the legacy JSON migration, run with
+// `pio test -e native`. The loop's serviceConfigCommit() is driven against
+// the virtual clock, and mockSetPreferencesFull() makes every write fail as
+// on a full partition.
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "mock_hal.h"
+#include "config.h"
+#include "banks.h"
+#include "log.h"
+
+static uint64_t nowUs = 1000000;
+
+static int countLines(const std::string &text, const char *needle) {
+    int count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) ++count;
+    return count;
+}
+
+// Loop passes every 10 ms; returns the times of failed write attempts
+static std::vector<uint64_t> runLoop(uint32_t ms) {
+    std::vector<uint64_t> failures;
+    for (uint32_t t = 0; t < ms; t += 10) {
+        nowUs += 10000;
+        mockSetMicros(nowUs);
+        uint32_t before = configPersistStats.writeFailures;
+        serviceConfigCommit();
+        if (configPersistStats.writeFailures != before) failures.push_back(nowUs);
+    }
+    return failures;
+}
+
+void setUp() {
+    mockSetPreferencesFull(false);
+    runLoop(CONFIG_COMMIT_DELAY_MS + 100);
+    mockResetSerial();
+}
+
+void tearDown() {
+    mockSetPreferencesFull(false);
+}
+
+void test_commit_after_quiet_period() {
+    uint32_t writes = configPersistStats.flashWrites;
+    scheduleConfigCommit(0, 1);
+    runLoop(CONFIG_COMMIT_DELAY_MS - 100);
+    TEST_ASSERT_TRUE(isConfigCommitPending());
+    runLoop(200);
+    TEST_ASSERT_FALSE(isConfigCommitPending());
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, configPersistStats.flashWrites);
+}
+
+// A failing flash is retried a quiet period apart, a bounded number of
+// times, with one error line for the run and one when giving up
+void test_failed_write_backs_off_and_gives_up() {
+    mockSetPreferencesFull(true);
+    uint32_t writes = configPersistStats.flashWrites;
+    scheduleConfigCommit(0, 1);
+
+    std::vector<uint64_t> failures = runLoop(20 * CONFIG_COMMIT_DELAY_MS);
+    TEST_ASSERT_EQUAL_UINT32(CONFIG_COMMIT_MAX_RETRIES + 1, (uint32_t)failures.size());
+    for (size_t i = 1; i < failures.size(); ++i) {
+        TEST_ASSERT_TRUE(failures[i] - failures[i - 1] >= CONFIG_COMMIT_DELAY_MS * 1000UL);
+    }
+    TEST_ASSERT_FALSE(isConfigCommitPending());
+    TEST_ASSERT_EQUAL_INT(2, countLines(Serial.tx, "\"type\":\"error\""));
+    TEST_ASSERT_EQUAL_UINT32(writes, configPersistStats.flashWrites);
+
+    // The bank stays dirty: the next edit, once flash works, writes it
+    mockSetPreferencesFull(false);
+    uint32_t bytes = mockPreferencesBytesWritten();
+    getBankSwitches(1);   // Edited banks are resident, as after a patch
+    scheduleConfigCommit(1, 0);
+    runLoop(CONFIG_COMMIT_DELAY_MS + 100);
+    TEST_ASSERT_FALSE(isConfigCommitPending());
+    TEST_ASSERT_EQUAL_UINT32(writes + 2, configPersistStats.flashWrites);
+    TEST_ASSERT_TRUE(mockPreferencesBytesWritten() > bytes);
+}
+
+// A failure that clears up is retried once and reported once
+void test_transient_failure_recovers() {
+    mockSetPreferencesFull(true);
+    uint32_t writes = configPersistStats.flashWrites;
+    scheduleConfigCommit(0, 2);
+    TEST_ASSERT_EQUAL_UINT32(1, (uint32_t)runLoop(CONFIG_COMMIT_DELAY_MS + 100).size());
+    TEST_ASSERT_TRUE(isConfigCommitPending());
+
+    mockSetPreferencesFull(false);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)runLoop(CONFIG_COMMIT_DELAY_MS + 100).size());
+    TEST_ASSERT_FALSE(isConfigCommitPending());
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, configPersistStats.flashWrites);
+    TEST_ASSERT_EQUAL_INT(1, countLines(Serial.tx, "\"type\":\"error\""));
+}
+
+// Flash as older firmware left it: only the JSON string, no binary record
+static void writeLegacyConfig(const std::string &json) {
+    mockClearPreferences();
+    Preferences legacy;
+    legacy.begin("midi-config", false);
+    legacy.putString("config", json.c_str());
+    legacy.end();
+}
+
+static bool legacyConfigPresent() {
+    Preferences legacy;
+    legacy.begin("midi-config", true);
+    bool present = legacy.isKey("config");
+    legacy.end();
+    return present;
+}
+
+// Older firmware did not bound the string, so it is read at full length
+void test_long_legacy_config_migrates() {
+    std::string json = "{\"switches\":[{\"id\":0,\"name\":\"LEGACY\",\"channel\":2,\"cc\":30,\"value\":90,"
+                       "\"enabled\":true,\"color\":\"#FF0000\",\"padding\":\"" + std::string(1500, 'x') + "\"}]}";
+    writeLegacyConfig(json);
+    loadConfigFromFlash();
+
+    TEST_ASSERT_FALSE(legacyConfigPresent());
+    FootswitchConfig stored[NUM_FOOTSWITCHES];
+    TEST_ASSERT_TRUE(loadBankFromFlash(0, stored));
+    TEST_ASSERT_EQUAL_INT(1, countLines(Serial.tx, "Migrated JSON configuration"));
+    TEST_ASSERT_EQUAL_STRING("LEGACY", stored[0].name);
+}
+
+// A legacy string that cannot be used is reported and left alone: the
+// device runs on defaults without writing them over the user's data
+void test_unreadable_legacy_config_is_kept() {
+    writeLegacyConfig("{\"switches\":[{\"name\":");
+    uint32_t flashBytes = mockPreferencesBytesWritten();
+    loadConfigFromFlash();
+
+    TEST_ASSERT_TRUE(legacyConfigPresent());
+    FootswitchConfig stored[NUM_FOOTSWITCHES];
+    TEST_ASSERT_FALSE(loadBankFromFlash(0, stored));
+    TEST_ASSERT_EQUAL_UINT32(flashBytes, mockPreferencesBytesWritten());
+    TEST_ASSERT_EQUAL_INT(1, countLines(Serial.tx, "Failed to parse legacy configuration JSON"));
+    TEST_ASSERT_EQUAL_INT(1, countLines(Serial.tx, "Legacy configuration kept in flash"));
+}
+
+int main() {
+    mockClearPreferences();
+    mockSetMicros(nowUs);
+    initializeLog();
+    initializeConfigLock();
+    loadConfigFromFlash();
+    initializeBanks();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_commit_after_quiet_period);
+    RUN_TEST(test_failed_write_backs_off_and_gives_up);
+    RUN_TEST(test_transient_failure_recovers);
+    RUN_TEST(test_long_legacy_config_migrates);
+    RUN_TEST(test_unreadable_legacy_config_is_kept);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// 4-bit sprite expansion for pixel DMA (lib/MultiTFTBus/SpriteChunks.hpp),
+// run with `pio test -e native`. The host MultiTFT has no DMA, so the chunks
+// are checked here against a sink that behaves like pushPixelsDMA: it waits
+// for the previous transfer, then keeps its buffer "on the wire" until the
+// next call.
+
+#include <unity.h>
+#include <vector>
+#include "SpriteChunks.hpp"
+
+#define BUFFER_PIXELS 64
+
+static uint16_t buffers[2][BUFFER_PIXELS];
+static uint16_t *const bufferList[2] = {buffers[0], buffers[1]};
+
+struct DmaSink {
+    std::vector<uint16_t> wire;          // Pixels in the order they were sent
+    std::vector<int32_t> chunkPixels;
+    const uint16_t *inFlight = NULL;     // Buffer of the transfer still streaming
+    uint16_t inFlightCopy[BUFFER_PIXELS];
+    int32_t inFlightPixels = 0;
+    bool overwritten = false;            // A buffer changed while on the wire
+    bool sameBuffer = false;             // Two chunks in a row from one buffer
+
+    void send(uint16_t *chunk, int32_t pixels) {
+        finish();
+        sameBuffer |= chunk == inFlight;
+        inFlight = chunk;
+        inFlightPixels = pixels;
+        memcpy(inFlightCopy, chunk, pixels * sizeof(uint16_t));
+        chunkPixels.push_back(pixels);
+    }
+
+    // The previous transfer completes: its buffer must be as it was sent
+    void finish() {
+        if (inFlight == NULL) return;
+        overwritten |= memcmp(inFlightCopy, inFlight, inFlightPixels * sizeof(uint16_t)) != 0;
+        wire.insert(wire.end(), inFlight, inFlight + inFlightPixels);
+        inFlight = NULL;
+    }
+};
+
+// Palette index of each pixel, packed two per byte (even x high)
+static std::vector<uint8_t> pack(const std::vector<uint8_t> &indices, int32_t w, int32_t h) {
+    int32_t stride = (w + 1) / 2;
+    std::vector<uint8_t> packed(stride * h, 0);
+    for (int32_t y = 0; y < h; ++y) {
+        for (int32_t x = 0; x < w; ++x) {
+            uint8_t index = indices[y * w + x] & 0x0F;
+            packed[y * stride + x / 2] |= (x & 1) ? index : (uint8_t)(index << 4);
+        }
+    }
+    return packed;
+}
+
+static void checkSprite(int32_t w, int32_t h) {
+    uint16_t palette[16];
+    for (int i = 0; i < 16; ++i) palette[i] = (uint16_t)(0x1234 * (i + 1));
+    uint16_t swapped[16];
+    swapPaletteBytes(palette, swapped);
+
+    std::vector<uint8_t> indices(w * h);
+    for (int32_t i = 0; i < w * h; ++i) indices[i] = (uint8_t)((i * 7 + i / w) % 16);
+    std::vector<uint8_t> packed = pack(indices, w, h);
+
+    DmaSink sink;
+    int32_t chunks = streamSprite4(packed.data(), w, h, swapped, bufferList, BUFFER_PIXELS,
+                                   [&sink](uint16_t *chunk, int32_t pixels) { sink.send(chunk, pixels); });
+    sink.finish();
+
+    int32_t rowsPerChunk = BUFFER_PIXELS / w;
+    TEST_ASSERT_EQUAL_INT32((h + rowsPerChunk - 1) / rowsPerChunk, chunks);
+    TEST_ASSERT_FALSE(sink.overwritten);
+    TEST_ASSERT_FALSE(sink.sameBuffer);
+    for (size_t i = 0; i < sink.chunkPixels.size(); ++i) {
+        TEST_ASSERT_TRUE(sink.chunkPixels[i] <= BUFFER_PIXELS);
+        TEST_ASSERT_EQUAL_INT32(0, sink.chunkPixels[i] % w);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(w * h), (uint32_t)sink.wire.size());
+    for (int32_t i = 0; i < w * h; ++i) {
+        uint16_t color = palette[indices[i]];
+        TEST_ASSERT_EQUAL_HEX16((uint16_t)((color >> 8) | (color << 8)), sink.wire[i]);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_palette_is_byte_swapped() {
+    uint16_t palette[16] = {0xF800, 0x07E0, 0x001F, 0xFFFF};
+    uint16_t swapped[16];
+    swapPaletteBytes(palette, swapped);
+    TEST_ASSERT_EQUAL_HEX16(0x00F8, swapped[0]);
+    TEST_ASSERT_EQUAL_HEX16(0xE007, swapped[1]);
+    TEST_ASSERT_EQUAL_HEX16(0x1F00, swapped[2]);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, swapped[3]);
+}
+
+// Rows that fill the buffer exactly, and a last chunk that is short
+void test_even_width() {
+    checkSprite(16, 4);
+    checkSprite(16, 9);
+}
+
+// Odd rows end in half a byte, which must not shift the next row
+void test_odd_width() {
+    checkSprite(13, 11);
+    checkSprite(1, 70);
+}
+
+// One row per chunk: every chunk alternates buffers
+void test_row_per_chunk() {
+    checkSprite(BUFFER_PIXELS, 5);
+    checkSprite(BUFFER_PIXELS - 1, 3);
+}
+
+void test_row_too_wide() {
+    uint8_t packed[BUFFER_PIXELS] = {0};
+    uint16_t palette[16] = {0};
+    int calls = 0;
+    TEST_ASSERT_EQUAL_INT32(0, streamSprite4(packed, BUFFER_PIXELS + 1, 1, palette, bufferList, BUFFER_PIXELS,
+                                             [&calls](uint16_t *, int32_t) { ++calls; }));
+    TEST_ASSERT_EQUAL_INT(0, calls);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_palette_is_byte_swapped);
+    RUN_TEST(test_even_width);
+    RUN_TEST(test_odd_width);
+    RUN_TEST(test_row_per_chunk);
+    RUN_TEST(test_row_too_wide);
+    return UNITY_END();
+}
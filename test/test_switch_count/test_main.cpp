@@ -0,0 +1,156 @@
+// Fixed buffers at the built switch count, run with `pio test -e native`
+// and in the native_4/8/12 envs. Every switch gets its longest name and a
+// full action list; the binary protocol must then carry the whole bank both
+// ways and the flash record must round-trip.
+
+#include <unity.h>
+#include <vector>
+#include "mock_hal.h"
+#include "config.h"
+#include "banks.h"
+#include "binary_protocol.h"
+#include "utils.h"
+#include "log.h"
+
+static uint16_t nextRequestId = 1;
+
+void setUp() {
+    mockResetSerial();
+}
+
+void tearDown() {
+    if (isBinaryProtocolActive()) stopBinaryProtocol();
+}
+
+static std::vector<uint8_t> cobsEncode(const std::vector<uint8_t> &in) {
+    std::vector<uint8_t> out(1, 0);
+    size_t code = 0;
+    for (size_t i = 0; i < in.size(); ++i) {
+        if (in[i] == 0) {
+            out[code] = (uint8_t)(out.size() - code);
+            code = out.size();
+            out.push_back(0);
+            continue;
+        }
+        out.push_back(in[i]);
+        if (out.size() - code == 0xFF) {
+            out[code] = 0xFF;
+            code = out.size();
+            out.push_back(0);
+        }
+    }
+    out[code] = (uint8_t)(out.size() - code);
+    return out;
+}
+
+static std::vector<uint8_t> cobsDecode(const std::string &in, size_t start, size_t end) {
+    std::vector<uint8_t> out;
+    size_t pos = start;
+    while (pos < end) {
+        uint8_t code = (uint8_t)in[pos++];
+        for (uint8_t i = 1; i < code && pos < end; ++i) out.push_back((uint8_t)in[pos++]);
+        if (code != 0xFF && pos < end) out.push_back(0);
+    }
+    return out;
+}
+
+// Send one request frame and return the decoded payload of its response
+// (log frames sent meanwhile are skipped); flags receives the response flags
+static std::vector<uint8_t> request(uint8_t op, const std::vector<uint8_t> &payload, uint8_t &flags) {
+    uint16_t requestId = nextRequestId++;
+    uint8_t sequence = (uint8_t)requestId;   // One frame per request, so it counts along
+    std::vector<uint8_t> frame = {BINARY_PROTOCOL_VERSION, op, 0, sequence,
+                                  (uint8_t)(requestId & 0xFF), (uint8_t)(requestId >> 8)};
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    uint16_t crc = crc16Ccitt(frame.data(), frame.size());
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+
+    std::vector<uint8_t> encoded = cobsEncode(frame);
+    for (size_t i = 0; i < encoded.size(); ++i) binaryProtocolReceive(encoded[i]);
+    binaryProtocolReceive(0x00);
+
+    std::string &tx = Serial.tx;
+    size_t start = 0;
+    for (size_t end = tx.find('\0'); end != std::string::npos; start = end + 1, end = tx.find('\0', start)) {
+        std::vector<uint8_t> response = cobsDecode(tx, start, end);
+        if (response.size() < BINARY_HEADER_SIZE + BINARY_CRC_SIZE) continue;
+        size_t length = response.size() - BINARY_CRC_SIZE;
+        uint16_t responseId = response[4] | (response[5] << 8);
+        if (response[1] != op || responseId != requestId) continue;
+        TEST_ASSERT_EQUAL_HEX16(crc16Ccitt(response.data(), length), response[length] | (response[length + 1] << 8));
+        flags = response[2];
+        Serial.tx.clear();
+        return std::vector<uint8_t>(response.begin() + BINARY_HEADER_SIZE, response.begin() + length);
+    }
+    TEST_FAIL_MESSAGE("no response frame");
+    return std::vector<uint8_t>();
+}
+
+// Longest name and a full action list on every switch of the active bank
+static void fillWorstCase(char fill) {
+    FootswitchConfig *switches = stageBankUpdate(getActiveBank());
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        FootswitchConfig &fs = switches[i];
+        memset(fs.name, fill, FOOTSWITCH_NAME_MAX);
+        fs.name[FOOTSWITCH_NAME_MAX] = '\0';
+        fs.actionCount = MIDI_MAX_ACTIONS;
+        for (uint8_t a = 0; a < MIDI_MAX_ACTIONS; ++a) {
+            fs.actions[a] = {MIDI_ACTION_CC, 1, (uint8_t)(i + a), 127};
+        }
+        compileSwitchMidi(fs);
+    }
+    publishBankUpdate(getActiveBank());
+}
+
+void test_binary_config_round_trip() {
+    fillWorstCase('W');
+    startBinaryProtocol();
+
+    uint8_t flags = 0;
+    std::vector<uint8_t> config = request(OP_GET_CONFIG, {BINARY_ACTIVE_BANK}, flags);
+    TEST_ASSERT_EQUAL_HEX8(BINARY_FLAG_RESPONSE, flags);
+    TEST_ASSERT_EQUAL_size_t(2 + NUM_FOOTSWITCHES * BINARY_SWITCH_RECORD_MAX, config.size());
+    TEST_ASSERT_EQUAL_INT(NUM_FOOTSWITCHES, config[1]);
+
+    // Send the same bank back with other names: the full frame must be accepted
+    for (size_t pos = 2; pos < config.size(); pos += BINARY_SWITCH_RECORD_MAX) {
+        memset(&config[pos + 8], 'S', FOOTSWITCH_NAME_MAX);
+    }
+    request(OP_SET_CONFIG, config, flags);
+    TEST_ASSERT_EQUAL_HEX8(BINARY_FLAG_RESPONSE, flags);
+
+    const FootswitchConfig *switches = getBankSwitches(getActiveBank());
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        TEST_ASSERT_EQUAL_size_t(FOOTSWITCH_NAME_MAX, strlen(switches[i].name));
+        TEST_ASSERT_EQUAL_INT('S', switches[i].name[0]);
+        TEST_ASSERT_EQUAL_INT(MIDI_MAX_ACTIONS, switches[i].actionCount);
+    }
+}
+
+void test_flash_record_round_trip() {
+    fillWorstCase('F');
+    markBankDirty(getActiveBank());
+    saveConfigToFlash();
+
+    static FootswitchConfig loaded[NUM_FOOTSWITCHES];
+    TEST_ASSERT_TRUE(loadBankFromFlash(getActiveBank(), loaded));
+    for (int i = 0; i < NUM_FOOTSWITCHES; ++i) {
+        TEST_ASSERT_EQUAL_STRING(getBankSwitches(getActiveBank())[i].name, loaded[i].name);
+        TEST_ASSERT_EQUAL_INT(MIDI_MAX_ACTIONS, loaded[i].actionCount);
+        TEST_ASSERT_EQUAL_INT(i + MIDI_MAX_ACTIONS - 1, loaded[i].actions[MIDI_MAX_ACTIONS - 1].data1);
+    }
+}
+
+int main() {
+    mockClearPreferences();
+    initializeLog();
+    initializeConfigLock();
+    loadConfigFromFlash();
+    initializeBanks();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_binary_config_round_trip);
+    RUN_TEST(test_flash_record_round_trip);
+    return UNITY_END();
+}
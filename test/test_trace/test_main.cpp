@@ -0,0 +1,546 @@
+// Input trace replay, run with `pio test -e native`. Every trace in
+// test/traces (TRACE_DIR overrides) is fed through the firmware's own
+// setup(), loop(), input pass and display pass against the virtual clock,
+// one forked process per trace so each starts from a fresh boot. The MIDI
+// bytes, redraws and press latencies it produces must match the trace's
+// .expected file: the same lines in the same order, none of them later.
+// TRACE_FILE=<path> prints the replay of one capture instead, and
+// TRACE_UPDATE=1 rewrites the .expected files.
+//
+// Trace files are text, written by examples/trace_tool.py:
+//   trace version=1 rate_hz=2000 switches=6 debounce_ms=50 bank=0
+//         config_crc=0x1234 calibration=3900:300,900,1500,2100,2700,3300
+//   C <json>             Command run after boot, before the trace starts
+//   L <dt_us> <value> [xN]   Filtered ladder sample(s), dt_us apart
+//   U <t_us> <json>      Command line handled t_us after the start
+// config_crc and calibration are optional ("none": factory thresholds).
+
+#include <unity.h>
+#include "mock_hal.h"
+#include "config.h"
+#include "banks.h"
+#include "display.h"
+#include "events.h"
+#include "ladder.h"
+#include "midi_input.h"
+#include "switches.h"
+#include "trace.h"
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+void setup();
+void loop();
+
+#define REPLAY_BOOT_US 100000UL       // Clock at setup(); 0 would read as "untimed"
+#define REPLAY_START_US 1000000UL     // Trace time 0
+#define REPLAY_STEP_US 1000UL         // Loop pass period, and the input task's idle wake
+#define REPLAY_TAIL_US 200000UL       // Run on after the last sample to drain the outputs
+
+struct TraceLadderRun {
+    uint32_t dtUs;
+    uint16_t value;
+    uint32_t repeat;
+};
+
+struct TraceCommand {
+    uint32_t timeUs;
+    std::string line;
+};
+
+struct Trace {
+    std::string name;
+    std::string path;
+    std::string error;
+    uint32_t rateHz = LADDER_SAMPLE_RATE_HZ;
+    uint32_t switches = NUM_FOOTSWITCHES;
+    uint32_t debounceMs = DEBOUNCE_DELAY;
+    uint32_t bank = 0;
+    long configCrc = -1;
+    bool calibrated = false;
+    LadderCalibration calibration;
+    std::vector<std::string> setupCommands;
+    std::vector<TraceLadderRun> ladder;
+    std::vector<TraceCommand> commands;
+};
+
+// One line of replay output: "<t_us> <kind> <payload>"
+struct ReplayLine {
+    long timeUs;
+    std::string kind;
+    std::string payload;
+    long latencyUs;     // press lines only
+};
+
+static std::string traceDirectory() {
+    const char *dir = getenv("TRACE_DIR");
+    return dir != NULL ? dir : "test/traces";
+}
+
+static std::string restOfLine(std::istringstream &in) {
+    std::string rest;
+    std::getline(in, rest);
+    size_t start = rest.find_first_not_of(' ');
+    return start == std::string::npos ? "" : rest.substr(start);
+}
+
+static bool parseCalibration(const std::string &text, LadderCalibration &cal) {
+    cal.version = LADDER_CALIBRATION_VERSION;
+    size_t colon = text.find(':');
+    if (colon == std::string::npos) return false;
+    std::string idle = text.substr(0, colon);
+    cal.idleLevel = idle == "-" ? LADDER_LEVEL_UNSET : (uint16_t)strtoul(idle.c_str(), NULL, 10);
+    std::istringstream levels(text.substr(colon + 1));
+    std::string level;
+    int count = 0;
+    while (std::getline(levels, level, ',')) {
+        if (count == NUM_FOOTSWITCHES) return false;
+        cal.levels[count++] = (uint16_t)strtoul(level.c_str(), NULL, 10);
+    }
+    return count == NUM_FOOTSWITCHES;
+}
+
+static void parseHeader(std::istringstream &in, Trace &trace) {
+    std::string field;
+    while (in >> field) {
+        size_t eq = field.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = field.substr(0, eq);
+        std::string value = field.substr(eq + 1);
+        if (key == "version" && strtoul(value.c_str(), NULL, 10) != TRACE_VERSION) {
+            trace.error = "unsupported trace version " + value;
+        } else if (key == "rate_hz") {
+            trace.rateHz = strtoul(value.c_str(), NULL, 10);
+        } else if (key == "switches") {
+            trace.switches = strtoul(value.c_str(), NULL, 10);
+        } else if (key == "debounce_ms") {
+            trace.debounceMs = strtoul(value.c_str(), NULL, 10);
+        } else if (key == "bank") {
+            trace.bank = strtoul(value.c_str(), NULL, 10);
+        } else if (key == "config_crc") {
+            trace.configCrc = strtol(value.c_str(), NULL, 0);
+        } else if (key == "calibration" && value != "none") {
+            trace.calibrated = parseCalibration(value, trace.calibration);
+            if (!trace.calibrated) trace.error = "bad calibration " + value;
+        }
+    }
+}
+
+static Trace loadTrace(const std::string &path) {
+    Trace trace;
+    trace.path = path;
+    size_t slash = path.find_last_of('/');
+    trace.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+
+    std::ifstream file(path.c_str());
+    if (!file) {
+        trace.error = "cannot open " + path;
+        return trace;
+    }
+    std::string line;
+    bool header = false;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        std::string tag;
+        in >> tag;
+        if (tag == "trace") {
+            parseHeader(in, trace);
+            header = true;
+        } else if (tag == "L") {
+            TraceLadderRun run = {0, 0, 1};
+            std::string repeat;
+            in >> run.dtUs >> run.value >> repeat;
+            if (!repeat.empty() && repeat[0] == 'x') run.repeat = strtoul(repeat.c_str() + 1, NULL, 10);
+            trace.ladder.push_back(run);
+        } else if (tag == "U") {
+            TraceCommand command;
+            in >> command.timeUs;
+            command.line = restOfLine(in);
+            trace.commands.push_back(command);
+        } else if (tag == "C") {
+            trace.setupCommands.push_back(restOfLine(in));
+        } else if (trace.error.empty()) {
+            trace.error = "unknown line: " + line;
+        }
+    }
+    if (!header && trace.error.empty()) trace.error = "no trace header";
+    if (trace.switches != NUM_FOOTSWITCHES && trace.error.empty()) {
+        trace.error = "recorded with " + std::to_string(trace.switches) + " switches";
+    }
+    if (trace.debounceMs != DEBOUNCE_DELAY && trace.error.empty()) {
+        trace.error = "recorded with a " + std::to_string(trace.debounceMs) + " ms debounce";
+    }
+    return trace;
+}
+
+// Replays, and everything they observe, run in a child process
+
+static std::vector<std::string> output;
+static long lastDownUs = -1;
+static int lastDownId = -1;
+
+static long traceTime(uint64_t nowUs) {
+    return (long)nowUs - (long)REPLAY_START_US;
+}
+
+static void emit(uint64_t nowUs, const std::string &kind, const std::string &payload) {
+    output.push_back(std::to_string(traceTime(nowUs)) + " " + kind + " " + payload);
+}
+
+static long numberField(const std::string &line, const char *key) {
+    size_t at = line.find(key);
+    return at == std::string::npos ? -1 : strtol(line.c_str() + at + strlen(key), NULL, 10);
+}
+
+// Pair each switch-down event with the input MIDI block that answers it
+static void collectEvents() {
+    std::istringstream lines(Serial.tx);
+    Serial.tx.clear();
+    std::string line;
+    while (std::getline(lines, line)) {
+        long timeUs = numberField(line, "\"t\":");
+        if (line.find("\"ev\":\"switch\"") != std::string::npos) {
+            if (line.find("\"state\":\"down\"") == std::string::npos) continue;
+            lastDownUs = timeUs;
+            lastDownId = (int)numberField(line, "\"id\":");
+        } else if (line.find("\"ev\":\"midi\"") != std::string::npos &&
+                   line.find("\"source\":\"input\"") != std::string::npos && lastDownUs >= 0) {
+            output.push_back(std::to_string(traceTime(lastDownUs)) + " press " + std::to_string(lastDownId) + " " +
+                             std::to_string((uint32_t)(timeUs - lastDownUs)));
+            lastDownUs = -1;
+        }
+    }
+}
+
+static void collectMidi(uint64_t nowUs) {
+    if (Serial2.tx.empty()) return;
+    std::string hex;
+    char byte[4];
+    for (size_t i = 0; i < Serial2.tx.size(); ++i) {
+        snprintf(byte, sizeof(byte), i == 0 ? "%02x" : " %02x", (uint8_t)Serial2.tx[i]);
+        hex += byte;
+    }
+    Serial2.tx.clear();
+    emit(nowUs, "midi", hex);
+}
+
+static void collectRedraw(uint64_t nowUs) {
+    static const char *NAMES[] = {"footswitch", "config"};
+    uint8_t handled = serviceDisplayEvents();
+    if (handled == 0) return;
+    std::string names;
+    for (int i = 0; i < 2; ++i) {
+        if (!(handled & (1u << i))) continue;
+        if (!names.empty()) names += ",";
+        names += NAMES[i];
+    }
+    emit(nowUs, "redraw", names);
+}
+
+static void feedCommand(const std::string &line) {
+    Serial.feed(line.c_str());
+    Serial.feed("\n");
+}
+
+// A subscription or binary session recorded with the trace would take the
+// event stream away from the replay, so those commands are not fed
+static bool replaysCommand(const std::string &line) {
+    JsonDocument doc;
+    if (deserializeJson(doc, line)) return true;
+    const char *type = doc["type"] | "";
+    return strcmp(type, "subscribe") != 0 && strcmp(type, "unsubscribe") != 0 &&
+           strcmp(type, "binary_hello") != 0;
+}
+
+static std::string replayTrace(const Trace &trace) {
+    mockClearPreferences();
+    mockResetSerial();
+    uint64_t now = REPLAY_BOOT_US;
+    mockSetMicros(now);
+    setup();
+    bringUpDisplays();   // The display task's first job
+    Serial2.txByteTimeUs = MIDI_BYTE_TIME_US;
+
+    char error[48];
+    if (trace.calibrated && !useLadderCalibration(trace.calibration, error, sizeof(error))) {
+        return std::string("error calibration: ") + error + "\n";
+    }
+    if (trace.bank != 0 && !selectBank(trace.bank, DISPLAY_PRODUCER_HOST)) return "error bank " + std::to_string(trace.bank) + "\n";
+    for (size_t i = 0; i < trace.setupCommands.size(); ++i) {
+        feedCommand(trace.setupCommands[i]);
+        mockSetMicros(now += REPLAY_STEP_US);
+        loop();
+    }
+    while (getActiveBank() != trace.bank && now < REPLAY_START_US) {
+        mockSetMicros(now += REPLAY_STEP_US);
+        loop();
+    }
+    if (trace.configCrc >= 0 && traceConfigCrc() != trace.configCrc) {
+        return "error configuration differs from the recording (config_crc)\n";
+    }
+    if (now >= REPLAY_START_US) return "error setup ran past the trace start\n";
+
+    serviceDisplayEvents();
+    mockResetSerial();
+    subscribeEvents((1u << HOST_EVENT_SWITCH) | (1u << HOST_EVENT_MIDI));
+
+    // Samples and loop passes in time order; at the same instant the input
+    // task (higher priority) goes first
+    uint64_t nextLoopUs = REPLAY_START_US;
+    uint64_t lastInputUs = REPLAY_START_US;
+    uint64_t sampleUs = REPLAY_START_US;
+    size_t nextCommand = 0;
+    size_t run = 0;
+    uint32_t repeat = 0;
+    uint64_t endUs = 0;
+
+    for (;;) {
+        bool haveSample = run < trace.ladder.size();
+        uint64_t nextSampleUs = haveSample ? sampleUs + trace.ladder[run].dtUs : 0;
+        if (!haveSample && endUs == 0) endUs = sampleUs + REPLAY_TAIL_US;
+
+        if (haveSample && nextSampleUs <= nextLoopUs) {
+            sampleUs = nextSampleUs;
+            mockSetMicros(now = sampleUs);
+            LadderSample sample = {trace.ladder[run].value, (uint32_t)sampleUs};
+            if (++repeat >= trace.ladder[run].repeat) {
+                ++run;
+                repeat = 0;
+            }
+            if (sample.value == TRACE_GAP_VALUE) continue;
+            queueLadderSample(sample);
+            runInputPass();
+            lastInputUs = now;
+            collectMidi(now);
+            collectRedraw(now);
+            continue;
+        }
+
+        if (endUs != 0 && nextLoopUs > endUs) break;
+        mockSetMicros(now = nextLoopUs);
+        nextLoopUs += REPLAY_STEP_US;
+        if (now - lastInputUs >= REPLAY_STEP_US) {
+            runInputPass();
+            lastInputUs = now;
+            collectMidi(now);
+        }
+        while (nextCommand < trace.commands.size() &&
+               REPLAY_START_US + trace.commands[nextCommand].timeUs <= now) {
+            const std::string &line = trace.commands[nextCommand++].line;
+            if (replaysCommand(line)) feedCommand(line);
+        }
+        loop();
+        collectEvents();
+        collectRedraw(now);
+    }
+
+    std::string text;
+    for (size_t i = 0; i < output.size(); ++i) text += output[i] + "\n";
+    return text;
+}
+
+// Parent side
+
+static bool replayInChild(const Trace &trace, std::string &text) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        std::string result = replayTrace(trace);
+        size_t written = 0;
+        while (written < result.size()) {
+            ssize_t n = write(fds[1], result.data() + written, result.size() - written);
+            if (n <= 0) _exit(1);
+            written += n;
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    text.clear();
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) text.append(buffer, n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static std::vector<ReplayLine> parseOutput(const std::string &text) {
+    std::vector<ReplayLine> lines;
+    std::istringstream in(text);
+    std::string raw;
+    while (std::getline(in, raw)) {
+        if (raw.empty() || raw[0] == '#') continue;
+        std::istringstream fields(raw);
+        ReplayLine line = {0, "", "", -1};
+        fields >> line.timeUs >> line.kind;
+        line.payload = restOfLine(fields);
+        if (line.kind == "press") {
+            size_t space = line.payload.find(' ');
+            line.latencyUs = strtol(line.payload.c_str() + space + 1, NULL, 10);
+            line.payload = line.payload.substr(0, space);
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Same lines in the same order; each one no later, each press no slower
+static std::string compareOutput(const std::string &actualText, const std::string &expectedText) {
+    std::vector<ReplayLine> actual = parseOutput(actualText);
+    std::vector<ReplayLine> expected = parseOutput(expectedText);
+    for (size_t i = 0; i < actual.size() || i < expected.size(); ++i) {
+        if (i >= actual.size()) return "missing line " + std::to_string(i + 1) + ": " + expected[i].kind;
+        if (i >= expected.size()) return "extra line " + std::to_string(i + 1) + ": " + actual[i].kind;
+        const ReplayLine &a = actual[i];
+        const ReplayLine &e = expected[i];
+        std::string where = "line " + std::to_string(i + 1) + " (" + e.kind + " at " + std::to_string(e.timeUs) + "): ";
+        if (a.kind != e.kind || a.payload != e.payload) {
+            return where + "got " + a.kind + " " + a.payload + ", expected " + e.payload;
+        }
+        if (a.timeUs > e.timeUs) return where + "now at " + std::to_string(a.timeUs);
+        if (a.latencyUs > e.latencyUs) {
+            return where + "latency " + std::to_string(a.latencyUs) + " us, was " + std::to_string(e.latencyUs);
+        }
+    }
+    return "";
+}
+
+static std::vector<std::string> listTraces() {
+    std::vector<std::string> paths;
+    std::string dir = traceDirectory();
+    DIR *handle = opendir(dir.c_str());
+    if (handle == NULL) return paths;
+    while (struct dirent *entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.size() > 6 && name.compare(name.size() - 6, 6, ".trace") == 0) paths.push_back(dir + "/" + name);
+    }
+    closedir(handle);
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+static std::string expectedPath(const Trace &trace) {
+    return trace.path.substr(0, trace.path.size() - 6) + ".expected";
+}
+
+static bool readFile(const std::string &path, std::string &text) {
+    std::ifstream file(path.c_str());
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_golden_traces() {
+    std::vector<std::string> paths = listTraces();
+    TEST_ASSERT_TRUE_MESSAGE(!paths.empty(), "no traces found (set TRACE_DIR)");
+    bool update = getenv("TRACE_UPDATE") != NULL;
+    int failures = 0;
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        Trace trace = loadTrace(paths[i]);
+        std::string problem = trace.error;
+        std::string actual;
+        if (problem.empty() && !replayInChild(trace, actual)) problem = "replay crashed";
+        if (problem.empty() && actual.compare(0, 6, "error ") == 0) problem = actual.substr(6);
+
+        if (problem.empty() && update) {
+            std::ofstream file(expectedPath(trace).c_str());
+            file << "# Replay of " << trace.name << ": <t_us> midi <bytes> | redraw <events> | press <switch> <latency_us>\n"
+                 << actual;
+        } else if (problem.empty()) {
+            std::string expected;
+            if (!readFile(expectedPath(trace), expected)) {
+                problem = "no .expected file (run with TRACE_UPDATE=1)";
+            } else {
+                problem = compareOutput(actual, expected);
+            }
+        }
+        if (!problem.empty()) {
+            printf("%s: %s\n", trace.name.c_str(), problem.c_str());
+            ++failures;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(0, failures);
+}
+
+// Replaying the same trace twice gives byte-identical output
+void test_replay_is_deterministic() {
+    std::vector<std::string> paths = listTraces();
+    TEST_ASSERT_TRUE(!paths.empty());
+    Trace trace = loadTrace(paths[0]);
+    std::string first, second;
+    TEST_ASSERT_TRUE(replayInChild(trace, first));
+    TEST_ASSERT_TRUE(replayInChild(trace, second));
+    TEST_ASSERT_TRUE(first.find(" midi ") != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING(first.c_str(), second.c_str());
+}
+
+// The device side: what was recorded comes back out of the dump, and a
+// gap too long for one entry is split
+void test_recorder_dump() {
+    mockResetSerial();
+    mockSetMicros(5000000);
+    TEST_ASSERT_TRUE(startTrace());
+    LadderSample early = {3900, 4999900};    // Ticked just before the start
+    LadderSample next = {3900, 5000500};
+    LadderSample late = {300, 5070500};
+    traceLadderSample(early);
+    traceLadderSample(next);
+    traceLadderSample(late);
+    traceUartCommand("{\"type\":\"ping\"}", 15);
+    stopTrace();
+    LadderSample after = {1, 5100000};
+    traceLadderSample(after);
+
+    TEST_ASSERT_TRUE(startTraceDump());
+    TEST_ASSERT_FALSE(startTrace());
+    std::string lines;
+    for (int i = 0; i < 10; ++i) {
+        serviceTrace();
+        lines += Serial.tx;
+        Serial.tx.clear();
+    }
+    // {0, 3900} {500, 3900} {65535, gap} {4465, 300}, little-endian
+    TEST_ASSERT_TRUE(lines.find("\"stream\":\"ladder\",\"offset\":0,\"hex\":\"00003c0ff4013c0fffffffff71112c01\"") !=
+                     std::string::npos);
+    // Time 5000000, length 15, the line
+    TEST_ASSERT_TRUE(lines.find("\"stream\":\"uart\",\"offset\":0,\"hex\":\"404b4c000f007b2274797065223a2270696e67227d\"") !=
+                     std::string::npos);
+    TEST_ASSERT_TRUE(lines.find("{\"type\":\"trace_end\",\"ladder_samples\":4,\"uart_bytes\":21}") != std::string::npos);
+    TEST_ASSERT_TRUE(startTrace());
+    stopTrace();
+}
+
+int main() {
+    const char *single = getenv("TRACE_FILE");
+    if (single != NULL) {
+        Trace trace = loadTrace(single);
+        std::string text;
+        if (!trace.error.empty()) text = "error " + trace.error + "\n";
+        else if (!replayInChild(trace, text)) text = "error replay crashed\n";
+        fputs(text.c_str(), stdout);
+        return text.compare(0, 6, "error ") == 0 ? 1 : 0;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_golden_traces);
+    RUN_TEST(test_replay_is_deterministic);
+    RUN_TEST(test_recorder_dump);
+    return UNITY_END();
+}